@@ -0,0 +1,23 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "stm32g0xx_hal.h"
+
+// Cycle counting for the Cortex-M0+, which has no DWT cycle counter: the HAL
+// millisecond tick plus the SysTick down-counter give core clock cycles.
+typedef struct {
+    uint32_t tick;
+    uint32_t count;
+} bench_mark_t;
+
+// Define BENCH_PRINTF_FLOAT (and link with -u _printf_float) to also time the
+// old snprintf("%.2f") path in 'bench fmt'.
+
+// Function prototypes
+void bench_start(bench_mark_t* mark);
+uint32_t bench_cycles(const bench_mark_t* mark);
+
+// Console commands
+int8_t benchmark_register_commands(void);
+
+#endif // __BENCHMARK_H__
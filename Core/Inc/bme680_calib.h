@@ -0,0 +1,41 @@
+#ifndef __BME680_CALIB_H__
+#define __BME680_CALIB_H__
+
+#include "bme68x.h"
+#include "stm32g0xx_hal.h"
+
+// Calibration cache in flash.
+// bme68x_init() reads ~40 calibration bytes in three I2C transfers on every
+// bring-up. The parsed coefficients are kept in the last flash page (kept out
+// of the FLASH region by the linker script) with a CRC, keyed by chip ID,
+// variant, I2C address and the 5-byte COEFF3 block. That block holds the
+// per-unit heater trim, so a swapped sensor almost always misses; a warm
+// bring-up then reads only the key and takes the rest from flash. Each of
+// the two BME68x addresses has its own record slot in the page.
+#define BME680_CALIB_FLASH_PAGE   63
+#define BME680_CALIB_FLASH_ADDR   (FLASH_BASE + BME680_CALIB_FLASH_PAGE * FLASH_PAGE_SIZE)
+#define BME680_CALIB_MAGIC        0x31434342u   // "BCC1"
+#define BME680_CALIB_SLOTS        2             // 0x76, 0x77
+
+typedef struct {
+    uint8_t chip_id;
+    uint8_t variant_id;
+    uint8_t address;            // 7-bit I2C address
+    uint8_t coeff3[BME68X_LEN_COEFF3];
+} bme680_calib_key_t;
+
+typedef struct {
+    uint32_t loads;             // Bring-ups served from flash
+    uint32_t misses;            // No valid record, or a different sensor
+    uint32_t saves;
+    uint32_t save_errors;
+} bme680_calib_stats_t;
+
+// Function prototypes
+uint8_t bme680_calib_load(const bme680_calib_key_t* key, struct bme68x_calib_data* calib);
+int8_t bme680_calib_save(const bme680_calib_key_t* key, const struct bme68x_calib_data* calib);
+int8_t bme680_calib_erase(void);
+uint8_t bme680_calib_stored(uint8_t slot, bme680_calib_key_t* key);
+void bme680_calib_get_stats(bme680_calib_stats_t* stats);
+
+#endif // __BME680_CALIB_H__
@@ -4,8 +4,137 @@
 #include "bme68x.h"
 #include "stm32g0xx_hal.h"
 
-// BME680 device structure
-extern struct bme68x_dev bme680_dev;
+// Sensors on the bus.
+// Discovery at init probes both BME68x addresses; every one that answers
+// becomes a sensor, numbered 0, 1 in address order, with its own driver
+// instance (handed to the I2C callbacks through intf_ptr), health and sample
+// cache. Conversions on different sensors run at the same time. Sensor 0
+// always exists and is re-probed in the background if nothing answered.
+#define BME680_MAX_SENSORS          2
+
+// Factory temperature offset observed on this board, applied to every reading
+#define BME680_TEMP_OFFSET_CENTI    (-950)   // 0.01 degC
+
+// Sample in fixed units, identical for the float and integer builds
+typedef struct {
+    uint32_t timestamp;         // ms since boot
+    int16_t temperature;        // 0.01 degC
+    uint32_t pressure;          // Pa
+    uint16_t humidity;          // 0.01 %RH
+    uint32_t gas_resistance;    // Ohm (valid if status has BME68X_GASM_VALID_MSK)
+    uint8_t status;
+    uint8_t gas_step;           // Heater profile step of the gas reading
+    uint8_t sensor_id;          // Sensor the sample came from
+} bme680_sample_t;
+
+// Sensor health.
+// The sensor is probed once at init, then tracked from the result of every
+// I2C transfer. After BME680_HEALTH_MAX_ERRORS failed transfers in a row it is
+// marked failed: reads fail at once without touching the bus, and the sensor
+// task re-probes it in the background, doubling the interval after each
+// failed probe.
+#define BME680_HEALTH_UNKNOWN     0   // Not probed yet
+#define BME680_HEALTH_OK          1
+#define BME680_HEALTH_FAILED      2
+
+#define BME680_HEALTH_MAX_ERRORS  3
+#define BME680_PROBE_MIN_MS       1000
+#define BME680_PROBE_MAX_MS       60000
+
+// Per-transfer I2C timeout (the longest transfer, the calibration read, takes ~5 ms)
+#define BME680_I2C_TIMEOUT_MS     25
+
+typedef struct {
+    uint8_t state;              // BME680_HEALTH_*
+    uint8_t address;            // 7-bit address found by the last good probe
+    uint8_t consecutive_errors;
+    uint32_t transfers;
+    uint32_t errors;            // Failed transfers
+    uint32_t probes;            // Background re-probes
+    uint32_t backoff_ms;        // Current re-probe interval
+    uint32_t next_probe;        // Tick of the next re-probe (when failed)
+    uint32_t init_us;           // Duration of the last bring-up (reset to configured)
+    uint8_t calib_from_flash;   // ... which took the calibration from flash
+} bme680_health_t;
+
+// Measurement profiles.
+// Oversampling and the IIR filter lower the T/P/H noise at the cost of
+// conversion time and supply charge per sample. The active profile sets the
+// forced conversion time the sensor task waits for and the stream plans its
+// conversions with; its ODR is the standby between fields of a sequential
+// heater profile.
+#define BME680_MEAS_LOW_POWER       0
+#define BME680_MEAS_BALANCED        1
+#define BME680_MEAS_HIGH_PRECISION  2
+#define BME680_MEAS_FAST_STREAM     3
+#define BME680_MEAS_PROFILE_COUNT   4
+#define BME680_MEAS_DEFAULT         BME680_MEAS_LOW_POWER
+
+typedef struct {
+    const char* name;
+    uint8_t os_temp;            // BME68X_OS_*
+    uint8_t os_pres;
+    uint8_t os_hum;
+    uint8_t filter;             // BME68X_FILTER_*
+    uint8_t odr;                // BME68X_ODR_*
+} bme680_meas_profile_t;
+
+// Asynchronous forced-mode measurement.
+// bme680_start_measurement() triggers a conversion and returns at once; the
+// sensor task fetches the result when the conversion time has passed (polling
+// the new_data bit if the sensor is late) and calls every waiter. Requests
+// made while a conversion runs share its result.
+#define BME680_MAX_WAITERS       4
+#define BME680_POLL_MS           2     // new_data poll interval once the conversion is due
+#define BME680_MEAS_TIMEOUT_MS   50    // Beyond the computed conversion time
+
+// Readers accept a cached sample up to this old (console reads, LoRa
+// broadcast, host requests), so back-to-back reads share one conversion
+#define BME680_READ_MAX_AGE_MS   2000
+
+// bme680_get_sample(): the result will come through the callback
+#define BME680_W_PENDING         INT8_C(10)
+
+// Interface errors (the driver uses -1 to -5)
+#define BME680_E_BUSY            INT8_C(-10)   // All waiter slots in use
+#define BME680_E_TIMEOUT         INT8_C(-11)   // new_data never set
+#define BME680_E_PROFILE         INT8_C(-12)   // Bad heater or measurement profile, or mode not on this variant
+
+// Gas heater profiles.
+// A profile is a list of heater steps (target temperature, heating time) run
+// over and over by the sensor task, which owns the sensor meanwhile. A BME688
+// runs it in sequential or parallel mode and one burst read returns up to
+// three finished fields; the BME680 only has forced mode, so there each step
+// is one forced conversion. Every field becomes a sample (T/P/H plus the gas
+// resistance of its step) in the cache, and measurement requests are served
+// by the next field instead of a conversion of their own. Profiles run on
+// sensor 0 only.
+#define BME680_PROFILE_MAX_STEPS   10
+#define BME680_HEATER_MIN_C        200
+#define BME680_HEATER_MAX_C        400
+#define BME680_HEATER_MAX_MS       4032   // Longest gas_wait (63 x 64 ms)
+#define BME680_PARALLEL_CYCLE_MS   140    // Parallel mode TPH + gas cycle, heating times are multiples
+
+typedef struct {
+    uint8_t mode;                               // BME68X_FORCED_MODE, _SEQUENTIAL_MODE or _PARALLEL_MODE
+    uint8_t steps;
+    uint16_t temp_c[BME680_PROFILE_MAX_STEPS];  // Heater target, degC
+    uint16_t dur_ms[BME680_PROFILE_MAX_STEPS];  // Heating time, ms
+} bme680_profile_t;
+
+typedef struct {
+    uint8_t running;
+    uint8_t step;               // Step of the latest field
+    uint32_t reads;             // Burst reads of the field registers
+    uint32_t fields;            // New fields taken
+    uint32_t gas_valid;         // ... with a valid, heater-stable gas reading
+    uint32_t lost;              // Fields overwritten before they were read
+    uint32_t errors;
+} bme680_profile_stats_t;
+
+// Called from the sensor task once: rslt is BME68X_OK and sample holds the
+// compensated reading (temperature offset applied), or rslt is an error
+typedef void (*bme680_callback_t)(int8_t rslt, const bme680_sample_t* sample, void* arg);
 
 // Function prototypes
 int8_t bme680_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr);
@@ -16,10 +145,30 @@ int8_t bme680_read_sensor_data(struct bme68x_data *data);
 void bme680_print_sensor_data(struct bme68x_data *data);
 void bme680_test_sensor(void);
 int8_t bme680_check_sensor_presence(void);
-void i2c_scan_bus(void);
 void bme680_read_raw_registers(void);
 void bme680_read_raw_adc_values(void);
 void bme680_check_calibration_data(void);
+#ifdef BME68X_USE_FPU
 float decode_ieee754(uint32_t hex_value);
+#endif
+int8_t bme680_register_commands(void);
+int8_t bme680_start_measurement(uint8_t sensor, bme680_callback_t done, void* arg);
+int8_t bme680_get_sample(uint8_t sensor, uint32_t max_age_ms, bme680_sample_t* sample,
+                         bme680_callback_t done, void* arg);
+uint8_t bme680_measurement_busy(uint8_t sensor);
+uint8_t bme680_sensor_count(void);
+uint8_t bme680_is_available(uint8_t sensor);
+int8_t bme680_get_health(uint8_t sensor, bme680_health_t* health);
+int8_t bme680_register_task(void);
+int8_t bme680_profile_start(const bme680_profile_t* profile);
+void bme680_profile_stop(void);
+void bme680_get_profile(bme680_profile_t* profile, bme680_profile_stats_t* stats);
+int8_t bme680_set_meas_profile(uint8_t id);
+uint8_t bme680_get_meas_profile(void);
+const bme680_meas_profile_t* bme680_meas_profile_info(uint8_t id);
+uint32_t bme680_meas_duration_us(uint8_t id);
+uint32_t bme680_meas_charge_nc(uint8_t id);
+int8_t bme680_fetch_measurement(uint8_t sensor, struct bme68x_data* data);
+void bme680_to_sample(const struct bme68x_data* data, uint32_t timestamp, bme680_sample_t* sample);
 
 #endif // __BME680_INTERFACE_H__ 
\ No newline at end of file
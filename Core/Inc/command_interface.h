@@ -7,32 +7,62 @@
 // Command buffer size
 #define CMD_BUFFER_SIZE 64
 
+// Bytes drained from a UART receive ring per read
+#define CMD_RX_CHUNK_SIZE 64
+
+// Console ports and formatting
+#define CONSOLE_MAX_PORTS    3
+#define CONSOLE_MAX_ARGS     6
+#define CONSOLE_FORMAT_SIZE  256
+
+// Command registry: tables registered by modules, one sorted key per name/alias
+#define CONSOLE_MAX_GROUPS   12   // Two built in, eight module groups registered by main()
+#define CONSOLE_MAX_KEYS     128
+
+// Console port modes
+#define CONSOLE_MODE_TEXT    0   // Line editor and human-readable responses
+#define CONSOLE_MODE_BINARY  1   // COBS framed host protocol (host_protocol.c)
+
+// Per-port console state: input port, line editor, session and output sinks
+typedef struct {
+    const char* name;
+    UART_HandleTypeDef* huart;
+    char line[CMD_BUFFER_SIZE];
+    uint8_t line_len;
+    uint8_t started;
+    uint8_t sink_mask;      // Bit n set: responses are also written to console n
+    uint8_t index;          // Position in the port list
+    uint8_t mode;           // CONSOLE_MODE_TEXT or CONSOLE_MODE_BINARY
+} console_ctx_t;
+
+// Command table entry (kept in flash, one handler set shared by every port).
+// args is the usage schema: each <arg> is required, each [arg] is optional,
+// and the dispatcher checks the argument count against it.
+typedef struct {
+    const char* name;
+    const char* alias;
+    const char* args;
+    void (*handler)(console_ctx_t* ctx, int argc, char* argv[]);
+    const char* help;
+} console_command_t;
+
 // Function prototypes
 void command_interface_init(void);
+int8_t command_interface_add_port(UART_HandleTypeDef* huart, const char* name);
+void command_interface_announce(void);
 void command_interface_process(void);
-void command_interface_show_help(void);
-void command_interface_handle_command(char* command);
-void command_interface_handle_command_usart4(char* command);
-void command_interface_send_response(const char* response);
-void command_interface_send_response_usart4(const char* response);
-
-// Command handlers
-void cmd_read_temperature(void);
-void cmd_read_pressure(void);
-void cmd_read_humidity(void);
-void cmd_test_sensor(void);
-void cmd_math_operation(char* command);
-
-// USART4 Command handlers
-void cmd_read_temperature_usart4(void);
-void cmd_read_pressure_usart4(void);
-void cmd_read_humidity_usart4(void);
-void cmd_test_sensor_usart4(void);
-void cmd_math_operation_usart4(char* command);
-void command_interface_show_help_usart4(void);
-
-// LoRa Command handlers
-void cmd_lora_broadcast(void);
-void cmd_lora_broadcast_usart4(void);
-
-#endif // __COMMAND_INTERFACE_H__ 
\ No newline at end of file
+int8_t command_interface_register_task(void);
+void command_interface_handle_command(console_ctx_t* ctx, char* command);
+void command_interface_broadcast(const char* text);
+uint8_t command_interface_port_count(void);
+console_ctx_t* command_interface_get_port(uint8_t index);
+int8_t console_register_commands(const char* group, const console_command_t* table, uint8_t count);
+const console_command_t* console_find_command(const char* name);
+void command_interface_set_mode(console_ctx_t* ctx, uint8_t mode);
+
+// Console output (formatted once, fanned out to every sink of the console).
+// console_printf uses the fmt.c printf subset: no floats, use fmt_float/fmt_fixed.
+void console_write(console_ctx_t* ctx, const char* text);
+void console_printf(console_ctx_t* ctx, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif // __COMMAND_INTERFACE_H__
@@ -0,0 +1,36 @@
+#ifndef __FMT_H__
+#define __FMT_H__
+
+#include <stdint.h>
+#include <stdarg.h>
+
+// Float-free, heap-free text formatting.
+// Digits are produced by subtracting powers of ten, so no division (the
+// Cortex-M0+ has no divide instruction) and no newlib printf is involved.
+
+// Bounded string builder: never writes past size, always NUL-terminated
+typedef struct {
+    char* buf;
+    uint16_t size;
+    uint16_t len;
+    uint8_t truncated;
+} fmt_t;
+
+// Builder functions
+void fmt_init(fmt_t* f, char* buf, uint16_t size);
+void fmt_char(fmt_t* f, char c);
+void fmt_str(fmt_t* f, const char* s);
+void fmt_str_pad(fmt_t* f, const char* s, uint8_t width);         // Left-aligned, space padded
+void fmt_u32(fmt_t* f, uint32_t value);
+void fmt_i32(fmt_t* f, int32_t value);
+void fmt_u32_pad(fmt_t* f, uint32_t value, uint8_t width, char pad); // Right-aligned
+void fmt_hex(fmt_t* f, uint32_t value, uint8_t digits);            // Upper case, zero padded
+void fmt_fixed(fmt_t* f, int32_t value, uint8_t decimals);         // value scaled by 10^decimals
+void fmt_float(fmt_t* f, float value, uint8_t decimals);           // Rounded, up to 9 decimals
+
+// printf subset without floats: %d %i %u %x %X %c %s %%, flags '-' and '0',
+// a field width and the 'l' length modifier. Returns the length written.
+uint16_t fmt_vformat(char* buf, uint16_t size, const char* format, va_list args);
+uint16_t fmt_format(char* buf, uint16_t size, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#endif // __FMT_H__
@@ -0,0 +1,99 @@
+#ifndef __HOST_PROTOCOL_H__
+#define __HOST_PROTOCOL_H__
+
+#include "stm32g0xx_hal.h"
+#include "command_interface.h"
+#include "bme680_interface.h"
+
+// Frame layout (before COBS encoding, 0x00 delimits frames on the wire):
+//   seq (1) | type (1) | TLV payload (0..n) | CRC16-CCITT of the preceding bytes (2, LE)
+// Every TLV is tag (1) | length (1) | value (little-endian integers).
+#define HOST_PROTO_MAX_FRAME     64
+#define HOST_PROTO_MAX_PAYLOAD   (HOST_PROTO_MAX_FRAME - 4)
+#define HOST_PROTO_MAX_ENCODED   (HOST_PROTO_MAX_FRAME + HOST_PROTO_MAX_FRAME / 254 + 1)
+
+// Request types (responses echo the sequence number and set HOST_PROTO_RESPONSE)
+#define HOST_PROTO_PING          0x01
+#define HOST_PROTO_READ_SENSOR   0x02    // Optional TAG_SENSOR (default 0)
+#define HOST_PROTO_RADIO_STATS   0x03
+#define HOST_PROTO_GET_CONFIG    0x04
+#define HOST_PROTO_SET_MODE      0x05    // TAG_MODE = CONSOLE_MODE_TEXT leaves binary mode
+#define HOST_PROTO_UART_STATS    0x06
+#define HOST_PROTO_STREAM        0x07    // TAG_RATE (0 stops), optional TAG_FIELDS
+#define HOST_PROTO_SAMPLE        0x40    // Unsolicited sample (seq counts per port)
+#define HOST_PROTO_ERROR         0x7F
+#define HOST_PROTO_RESPONSE      0x80
+
+// TLV tags
+#define HOST_TAG_TIMESTAMP       0x01    // u32, ms since boot
+#define HOST_TAG_TEMPERATURE     0x02    // i16, 0.01 degC
+#define HOST_TAG_PRESSURE        0x03    // u32, Pa
+#define HOST_TAG_HUMIDITY        0x04    // u16, 0.01 %RH
+#define HOST_TAG_GAS             0x05    // u32, Ohm
+#define HOST_TAG_SENSOR_STATUS   0x06    // u8, bme68x status bits
+#define HOST_TAG_GAS_STEP        0x07    // u8, heater profile step of the gas reading
+#define HOST_TAG_SENSOR          0x08    // u8, sensor id
+#define HOST_TAG_RADIO_STATE     0x10    // u8, bit0 detected, bit1 initialized
+#define HOST_TAG_TX_OK           0x11    // u32
+#define HOST_TAG_TX_FAILED       0x12    // u32
+#define HOST_TAG_FREQUENCY       0x20    // u32, Hz
+#define HOST_TAG_SPREADING       0x21    // u8
+#define HOST_TAG_BANDWIDTH       0x22    // u16, kHz
+#define HOST_TAG_TX_POWER        0x23    // i8, dBm
+#define HOST_TAG_MODE            0x30    // u8, CONSOLE_MODE_*
+#define HOST_TAG_PORT            0x31    // u8, console index
+#define HOST_TAG_BYTES_QUEUED    0x32    // u32
+#define HOST_TAG_BYTES_DROPPED   0x33    // u32
+#define HOST_TAG_RATE            0x34    // u8, Hz
+#define HOST_TAG_FIELDS          0x35    // u8, HOST_FIELD_* mask
+#define HOST_TAG_SAMPLES_DROPPED 0x36    // u32, stream samples dropped since start
+#define HOST_TAG_ERROR           0x7F    // u8, HOST_ERR_*
+
+// Error codes
+#define HOST_ERR_UNKNOWN_TYPE    1
+#define HOST_ERR_BAD_PAYLOAD     2
+#define HOST_ERR_SENSOR          3
+#define HOST_ERR_BUSY            4       // A sensor read is already pending on this port
+
+// Sample fields (sample TLVs and stream field selection)
+#define HOST_FIELD_TEMPERATURE   0x01
+#define HOST_FIELD_PRESSURE      0x02
+#define HOST_FIELD_HUMIDITY      0x04
+#define HOST_FIELD_GAS           0x08
+#define HOST_FIELD_TPH           (HOST_FIELD_TEMPERATURE | HOST_FIELD_PRESSURE | HOST_FIELD_HUMIDITY)
+
+// Payload builder
+typedef struct {
+    uint8_t data[HOST_PROTO_MAX_PAYLOAD];
+    uint16_t len;
+    uint8_t overflow;
+} host_tlv_t;
+
+// Per-port protocol counters
+typedef struct {
+    uint32_t frames_rx;
+    uint32_t frames_tx;
+    uint32_t crc_errors;
+    uint32_t framing_errors;
+} host_protocol_stats_t;
+
+// Function prototypes
+void host_protocol_reset(console_ctx_t* ctx);
+uint16_t host_protocol_feed(console_ctx_t* ctx, const uint8_t* data, uint16_t len);
+int8_t host_protocol_send(console_ctx_t* ctx, uint8_t seq, uint8_t type, const host_tlv_t* tlv);
+uint8_t host_protocol_next_seq(console_ctx_t* ctx);
+void host_protocol_get_stats(console_ctx_t* ctx, host_protocol_stats_t* stats);
+
+// TLV helpers
+void host_tlv_init(host_tlv_t* tlv);
+void host_tlv_put_u8(host_tlv_t* tlv, uint8_t tag, uint8_t value);
+void host_tlv_put_u16(host_tlv_t* tlv, uint8_t tag, uint16_t value);
+void host_tlv_put_u32(host_tlv_t* tlv, uint8_t tag, uint32_t value);
+void host_tlv_put_sample(host_tlv_t* tlv, const bme680_sample_t* sample, uint8_t fields);
+
+// Framing primitives
+uint16_t host_protocol_crc16(const uint8_t* data, uint16_t len);
+uint16_t host_protocol_cobs_encode(const uint8_t* in, uint16_t len, uint8_t* out);
+int16_t host_protocol_cobs_decode(const uint8_t* in, uint16_t len, uint8_t* out);
+
+#endif // __HOST_PROTOCOL_H__
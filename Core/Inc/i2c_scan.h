@@ -0,0 +1,55 @@
+#ifndef __I2C_SCAN_H__
+#define __I2C_SCAN_H__
+
+#include "stm32g0xx_hal.h"
+#include "command_interface.h"
+
+// Background I2C bus scan.
+// Before each scan the SCL and SDA levels are checked with the bus idle. A
+// slave holding SDA low (reset in the middle of a read) is clocked free with
+// up to 9 SCL pulses and a STOP; SCL held low cannot be recovered. The scan
+// then probes the 7-bit addresses a few at a time from its scheduler task,
+// each with one address-only transfer and a short timeout, and leaves a
+// presence bitmap that boot, the console and drivers read without touching
+// the bus. A timeout or bus error aborts the scan as a bus fault.
+#define I2C_SCAN_FIRST_ADDR    0x08   // 0x00-0x07 and 0x78-0x7F are reserved
+#define I2C_SCAN_LAST_ADDR     0x77
+#define I2C_SCAN_BATCH         16     // Addresses per task run (~100 us each at 100 kHz)
+#define I2C_SCAN_TIMEOUT_MS    2      // Per address; a NACK takes ~0.1 ms
+#define I2C_SCAN_RECOVERY_PULSES  9
+
+// Scan state
+#define I2C_SCAN_IDLE          0   // No scan since boot
+#define I2C_SCAN_RUNNING       1
+#define I2C_SCAN_DONE          2
+
+// Bus state found by the last check
+#define I2C_BUS_OK             0
+#define I2C_BUS_RECOVERED      1   // SDA was held low and has been clocked free
+#define I2C_BUS_SDA_STUCK      2   // SDA still low after the recovery pulses
+#define I2C_BUS_SCL_STUCK      3   // SCL held low
+#define I2C_BUS_FAULT          4   // Timeout or bus error during the scan
+
+typedef struct {
+    uint8_t state;              // I2C_SCAN_*
+    uint8_t bus;                // I2C_BUS_*
+    uint8_t found;              // Addresses that answered
+    uint8_t next_addr;          // Next address to probe while running
+    uint32_t present[4];        // Bit (addr % 32) of word (addr / 32): addr answered
+    uint32_t done_tick;         // Tick the last scan ended
+    uint32_t duration_us;       // Bus time of the last scan
+    uint32_t scans;
+    uint32_t recoveries;        // Bus recoveries since boot
+} i2c_scan_result_t;
+
+// Function prototypes
+uint8_t i2c_scan_bus_check(void);
+void i2c_scan_start(void);
+uint8_t i2c_scan_present(uint8_t address);
+void i2c_scan_get(i2c_scan_result_t* result);
+int8_t i2c_scan_register_task(void);
+
+// Console commands
+int8_t i2c_scan_register_commands(void);
+
+#endif // __I2C_SCAN_H__
@@ -0,0 +1,100 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include "stm32g0xx_hal.h"
+
+// Deferred, levelled logging.
+// A log call only stores its format string (the log ID, it lives in flash),
+// a timestamp and up to LOG_MAX_ARGS integer arguments in a RAM queue; the
+// text is formatted later by log_process() from the main loop, so arguments
+// must be integers (no %s, no floats). Calls above a module's build level
+// compile to nothing.
+
+// Levels
+#define LOG_LEVEL_OFF    0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+// Modules
+#define LOG_MOD_I2C      0
+#define LOG_MOD_BME680   1
+#define LOG_MOD_LORA     2
+#define LOG_MOD_COUNT    3
+
+// Build levels: everything in Debug builds, warnings and errors otherwise.
+// Override per module with e.g. -DLOG_BUILD_LEVEL_I2C=LOG_LEVEL_OFF.
+#ifndef LOG_BUILD_LEVEL
+#ifdef DEBUG
+#define LOG_BUILD_LEVEL  LOG_LEVEL_DEBUG
+#else
+#define LOG_BUILD_LEVEL  LOG_LEVEL_WARN
+#endif
+#endif
+
+#ifndef LOG_BUILD_LEVEL_I2C
+#define LOG_BUILD_LEVEL_I2C     LOG_BUILD_LEVEL
+#endif
+#ifndef LOG_BUILD_LEVEL_BME680
+#define LOG_BUILD_LEVEL_BME680  LOG_BUILD_LEVEL
+#endif
+#ifndef LOG_BUILD_LEVEL_LORA
+#define LOG_BUILD_LEVEL_LORA    LOG_BUILD_LEVEL
+#endif
+
+// Runtime level every module starts with
+#define LOG_DEFAULT_LEVEL  LOG_LEVEL_INFO
+
+// Queue sizing
+#define LOG_MAX_ARGS     4
+#define LOG_QUEUE_SIZE   32
+
+// Runtime levels, indexed by LOG_MOD_* (read inline by the macros)
+extern uint8_t log_levels[LOG_MOD_COUNT];
+
+// Usage: LOG_DEBUG(I2C, "Read reg=0x%02X len=%lu", reg, len);
+// No trailing newline, log_process() ends every line.
+#define LOG_ERROR(mod, ...)  LOG_AT(mod, LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(mod, ...)   LOG_AT(mod, LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(mod, ...)   LOG_AT(mod, LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(mod, ...)  LOG_AT(mod, LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// Arguments are only evaluated when the level is enabled. The build level is
+// a constant, so a disabled call leaves no code, strings or arguments behind;
+// the dead log_check_format() call only gives printf-style type checking.
+#define LOG_AT(mod, level, format, ...)                                              \
+    do {                                                                             \
+        if ((level) <= LOG_BUILD_LEVEL_##mod && (level) <= log_levels[LOG_MOD_##mod]) { \
+            const uint32_t log_args_[] = { 0, ##__VA_ARGS__ };                       \
+            _Static_assert(sizeof(log_args_) / sizeof(uint32_t) - 1 <= LOG_MAX_ARGS,  \
+                           "too many log arguments");                                \
+            if (0) {                                                                 \
+                log_check_format(format, ##__VA_ARGS__);                             \
+            }                                                                        \
+            log_write(LOG_MOD_##mod, (level), format, &log_args_[1],                 \
+                      sizeof(log_args_) / sizeof(uint32_t) - 1);                     \
+        }                                                                            \
+    } while (0)
+
+// Queue statistics
+typedef struct {
+    uint16_t queued;            // Entries waiting to be printed
+    uint16_t high_water;        // Most entries ever waiting at once
+    uint32_t written;
+    uint32_t dropped;           // Queue full
+} log_stats_t;
+
+// Function prototypes
+void log_write(uint8_t module, uint8_t level, const char* format, const uint32_t* args, uint8_t argc);
+void log_check_format(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void log_process(void);
+int8_t log_register_task(void);
+int8_t log_set_level(uint8_t module, uint8_t level);
+uint8_t log_build_level(uint8_t module);
+void log_get_stats(log_stats_t* stats);
+
+// Console commands
+int8_t log_register_commands(void);
+
+#endif // __LOG_H__
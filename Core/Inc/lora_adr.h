@@ -0,0 +1,49 @@
+#ifndef __LORA_ADR_H__
+#define __LORA_ADR_H__
+
+#include <stdint.h>
+
+// Adaptive data rate.
+// The SNR of packets heard from the other end (downlinks, acknowledgements)
+// gives the link margin: the best SNR of the last LORA_ADR_HISTORY packets
+// minus the demodulation floor of the current spreading factor and an
+// installation margin. Every 2.5 dB of it (one SF step) first lowers the SF
+// towards SF7, then the TX power in 2 dB steps; a negative margin raises the
+// power back. Only a receive window that closes with nothing heard counts
+// as a loss (an uplink alone says nothing about the link): after
+// LORA_ADR_ACK_LIMIT of them, and every LORA_ADR_ACK_DELAY more, the power
+// goes to maximum, then the SF up one step at a time towards SF12 (the
+// LoRaWAN device back-off). ADR starts off.
+#define LORA_ADR_SF_MIN            7
+#define LORA_ADR_SF_MAX            12
+#define LORA_ADR_POWER_STEP_DB     2
+#define LORA_ADR_POWER_STEPS       7      // Maximum power down to maximum - 14 dB
+#define LORA_ADR_HISTORY           8      // Packets whose best SNR is taken
+#define LORA_ADR_MARGIN_DB         10     // Installation margin kept above the floor
+#define LORA_ADR_ACK_LIMIT         64
+#define LORA_ADR_ACK_DELAY         32
+#define LORA_ADR_RX_WINDOW_MS      1000   // Receive window after an uplink while ADR is on
+
+typedef struct {
+    uint8_t enabled;
+    uint8_t sf;                 // 7-12
+    int8_t power_dbm;
+    int8_t max_power_dbm;
+    uint8_t samples;            // Packets in the SNR history
+    int8_t best_snr_db;         // Best SNR of the history
+    int8_t last_snr_db;
+    int16_t last_rssi_dbm;
+    int16_t margin_db10;        // Link margin at the last evaluation, 0.1 dB
+    uint16_t windows_unheard;   // Receive windows since something was last heard
+    uint32_t changes;           // Setting changes since boot
+} lora_adr_state_t;
+
+// Function prototypes
+void lora_adr_init(uint8_t sf, int8_t max_power_dbm);
+void lora_adr_enable(uint8_t enable);
+uint8_t lora_adr_downlink(int8_t snr_db, int16_t rssi_dbm);
+uint8_t lora_adr_lost(void);
+void lora_adr_get(lora_adr_state_t* state);
+uint8_t lora_adr_ldro(uint8_t sf, uint16_t bw_khz);
+
+#endif // __LORA_ADR_H__
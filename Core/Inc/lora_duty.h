@@ -0,0 +1,33 @@
+#ifndef __LORA_DUTY_H__
+#define __LORA_DUTY_H__
+
+#include "stm32g0xx_hal.h"
+
+// EU868 duty-cycle ledger.
+// Each sub-band of ETSI EN 300 220 (as used by LoRaWAN) allows a fraction of
+// every hour on air: 0.1%, 1% or 10%. The ledger keeps the airtime of each
+// sub-band in one-minute buckets over a sliding hour, so the budget comes
+// back minute by minute as old transmissions leave the window. The ledger
+// keeps 61 buckets, the current minute and the 60 before it: a minute's
+// bucket is dropped only when minute + 61 begins, once all of it has left
+// the hour, which errs on the safe side by up to a minute. Frequencies
+// outside every sub-band get no budget at all.
+#define LORA_DUTY_WINDOW_MIN     60
+#define LORA_DUTY_BANDS          6
+
+typedef struct {
+    uint32_t low_hz;            // Sub-band [low_hz, high_hz)
+    uint32_t high_hz;
+    uint16_t limit_permille;    // Allowed share of the hour on air
+    uint32_t budget_ms;         // Airtime allowed per window
+    uint32_t used_ms;           // Airtime in the current window
+    uint32_t transmissions;     // Recorded since boot
+} lora_duty_band_info_t;
+
+// Function prototypes
+int8_t lora_duty_band(uint32_t freq_hz);
+int32_t lora_duty_wait_ms(uint32_t freq_hz, uint32_t airtime_ms);
+void lora_duty_record(uint32_t freq_hz, uint32_t airtime_ms);
+int8_t lora_duty_get(uint8_t band, lora_duty_band_info_t* info);
+
+#endif // __LORA_DUTY_H__
@@ -2,6 +2,7 @@
 #define __LORA_INTERFACE_H__
 
 #include "stm32g0xx_hal.h"
+#include "bme680_interface.h"
 
 // LoRa configuration
 #define LORA_FREQUENCY_HZ        868000000  // 868 MHz (EU band)
@@ -13,6 +14,10 @@
 #define LORA_PAYLOAD_LENGTH      64
 #define LORA_SYNC_WORD           0x12
 
+// Sensor payload (lora_payload.h)
+#define LORA_PAYLOAD_KEYFRAME_INTERVAL  8   // Absolute frame every 8, deltas between
+#define LORA_RX_NODES                   4   // Node/sensor pairs scan and monitor decode at once
+
 // LoRa context structure
 typedef struct {
     SPI_HandleTypeDef* spi;
@@ -22,15 +27,96 @@ typedef struct {
     uint16_t reset_pin;
 } lora_context_t;
 
+// Radio event pipeline.
+// The DIO1 interrupt only timestamps the edge and posts an event to the
+// LoRa task, which reads and clears the radio IRQ flags once and dispatches
+// them: TX done and TX timeout to the callback of the transmission, RX done,
+// RX timeout and CRC errors to the callback of the reception. A
+// transmission returns as soon as the packet is handed to the radio; no SPI
+// traffic happens while it is in the air, except one IRQ read by a watchdog
+// if the DIO1 edge never comes.
+#define LORA_TX_TIMEOUT_SLACK_MS 20     // Radio-side TX timeout beyond the time on air
+#define LORA_TX_WATCHDOG_MS      50     // Beyond the time on air, before the flags are read anyway
+#define LORA_RX_MAX_LENGTH       255
+
+// Errors passed to the callbacks and returned by the start functions
+#define LORA_E_BUSY              (-2)   // Another transmission or reception runs
+#define LORA_E_TIMEOUT           (-3)   // The radio reported a TX timeout or never finished
+#define LORA_E_FULL              (-4)   // Every transmit queue slot is taken
+#define LORA_E_EXPIRED           (-5)   // Dropped from the queue when its time to live ran out
+#define LORA_E_DUTY_CYCLE        (-6)   // Can never fit the duty-cycle budget of the sub-band
+
+// Transmit queue.
+// Packets are copied into slots of a static pool and sent by priority, oldest
+// first within one. When a transmission ends the LoRa task writes the next
+// packet to the radio before it runs the completion callback, so queued
+// packets go out back to back. Every packet is checked against the duty
+// cycle of its sub-band (lora_duty.h): one that does not fit yet stays at
+// the head of the queue until it does, or until its time to live would run
+// out on the way.
+#define LORA_TX_QUEUE_SLOTS      6      // At most 8 (slot bitmap)
+#define LORA_TX_PRIO_HIGH        0
+#define LORA_TX_PRIO_NORMAL      1
+#define LORA_TX_PRIO_LOW         2
+
+// RX events
+#define LORA_RX_DONE             0
+#define LORA_RX_TIMEOUT          1
+#define LORA_RX_CRC_ERROR        2
+
+typedef struct {
+    uint8_t data[LORA_RX_MAX_LENGTH];
+    uint8_t length;
+    int16_t rssi_dbm;
+    int8_t snr_db;
+    uint64_t edge_us;           // Timebase time of the DIO1 edge
+} lora_packet_t;
+
+// TX completion: rslt is 0 or an error; airtime_us runs from the start
+// command to the DIO1 edge (0 if the watchdog found the result)
+typedef void (*lora_tx_callback_t)(int8_t rslt, uint32_t airtime_us, void* arg);
+
+// RX event: packet is valid for LORA_RX_DONE only
+typedef void (*lora_rx_callback_t)(uint8_t event, const lora_packet_t* packet, void* arg);
+
+// Radio state and transmission counters
+typedef struct {
+    uint8_t detected;
+    uint8_t initialized;
+    uint32_t tx_ok;
+    uint32_t tx_failed;
+    uint32_t rx_ok;
+    uint32_t rx_crc_errors;
+    uint32_t irq_edges;         // DIO1 edges taken
+    uint32_t irq_missed;        // Results found by the TX watchdog instead of an edge
+    uint32_t last_airtime_us;
+    uint32_t tx_queued;
+    uint32_t tx_expired;        // Dropped from the queue after their time to live
+    uint32_t tx_queue_full;     // Refused with every slot taken
+    uint32_t tx_last_gap_us;    // TX done edge to the start of the next queued packet
+    uint32_t duty_deferred;     // Held back until the duty cycle allowed them
+    uint32_t duty_rejected;     // Longer than the whole budget, or outside the sub-bands
+    uint8_t sf;                 // Spreading factor in use (ADR)
+    int8_t tx_power_dbm;        // TX power in use (ADR)
+} lora_stats_t;
+
 // Function prototypes
 int8_t lora_init(void);
-int8_t lora_send_sensor_data(float temperature, float pressure, float humidity);
-int8_t lora_send_message(const uint8_t* data, uint8_t length);
-void lora_process_irq(void);
+int8_t lora_send_sensor_data(const bme680_sample_t* sample, lora_tx_callback_t done, void* arg);
+int8_t lora_send_message(const uint8_t* data, uint8_t length, lora_tx_callback_t done, void* arg);
+int8_t lora_queue_message(const uint8_t* data, uint8_t length, uint8_t priority, uint32_t ttl_ms,
+                          lora_tx_callback_t done, void* arg);
+uint8_t lora_queue_depth(void);
+int32_t lora_send_delay_ms(uint8_t length);
+int8_t lora_start_rx(uint32_t timeout_ms, lora_rx_callback_t callback, void* arg);
+uint8_t lora_busy(void);
+void lora_notify_irq(void);
+int8_t lora_register_task(void);
 int8_t lora_get_status(void);
 int8_t lora_force_redetect(void);
 void lora_print_config(void);
 int8_t lora_test_transmission(void);
+void lora_get_stats(lora_stats_t* stats);
 
 // New scanning and monitoring functions
 int8_t lora_scan_signals(uint32_t scan_time_ms);
@@ -38,4 +124,7 @@ int8_t lora_start_monitoring(void);
 int8_t lora_stop_monitoring(void);
 int8_t lora_get_rssi(void);
 
+// Console commands
+int8_t lora_register_commands(void);
+
 #endif // __LORA_INTERFACE_H__ 
\ No newline at end of file
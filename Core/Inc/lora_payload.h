@@ -0,0 +1,74 @@
+#ifndef __LORA_PAYLOAD_H__
+#define __LORA_PAYLOAD_H__
+
+#include <stdint.h>
+
+// Binary sensor payload, version 1.
+// Plain C with no HAL dependency, so the same encoder/decoder builds on the
+// gateway host. All multi-byte values are little-endian.
+//
+//   byte 0     version (bits 7-5), LORA_PAYLOAD_FLAG_* (bits 4-3), sensor (bits 2-0)
+//   bytes 1-2  node ID
+//   byte 3     sequence number, +1 per frame and sensor
+//   byte 4     field bitmap (LORA_PAYLOAD_F_*), only with LORA_PAYLOAD_FLAG_BITMAP;
+//              without it the frame carries temperature, pressure and humidity
+//   fields     in bit order. Absolute: temperature int16 (0.01 degC), pressure
+//              uint24 (Pa), humidity uint16 (0.01 %RH), gas uint32 (Ohm).
+//              Delta (LORA_PAYLOAD_FLAG_DELTA): each field as a zigzag LEB128
+//              varint of the difference to the previous frame of the node and
+//              sensor, which must have sequence number - 1 and the same fields
+//
+// A default absolute frame is 11 bytes, a delta frame of slowly changing
+// readings 7 bytes (the JSON text it replaces was ~55). The encoder sends an
+// absolute frame every keyframe_interval frames, so a receiver that lost a
+// frame resynchronizes within that many.
+#define LORA_PAYLOAD_VERSION        1
+#define LORA_PAYLOAD_MAX_LENGTH     20     // Every field present, worst-case deltas
+
+#define LORA_PAYLOAD_FLAG_DELTA     0x01
+#define LORA_PAYLOAD_FLAG_BITMAP    0x02
+
+// Fields
+#define LORA_PAYLOAD_F_TEMPERATURE  0x01
+#define LORA_PAYLOAD_F_PRESSURE     0x02
+#define LORA_PAYLOAD_F_HUMIDITY     0x04
+#define LORA_PAYLOAD_F_GAS          0x08
+#define LORA_PAYLOAD_F_DEFAULT      (LORA_PAYLOAD_F_TEMPERATURE | LORA_PAYLOAD_F_PRESSURE | LORA_PAYLOAD_F_HUMIDITY)
+#define LORA_PAYLOAD_F_ALL          (LORA_PAYLOAD_F_DEFAULT | LORA_PAYLOAD_F_GAS)
+
+// Errors
+#define LORA_PAYLOAD_E_SIZE         (-1)   // Buffer too small, or frame too short
+#define LORA_PAYLOAD_E_VERSION      (-2)   // Unknown version
+#define LORA_PAYLOAD_E_FORMAT       (-3)   // Malformed frame or invalid field set
+#define LORA_PAYLOAD_E_REFERENCE    (-4)   // Delta frame without the frame it refers to
+
+typedef struct {
+    uint16_t node_id;
+    uint8_t sensor;             // 0-7
+    uint8_t seq;
+    uint8_t fields;             // LORA_PAYLOAD_F_*
+    int16_t temperature;        // 0.01 degC
+    uint32_t pressure;          // Pa (24 bits)
+    uint16_t humidity;          // 0.01 %RH
+    uint32_t gas_resistance;    // Ohm
+} lora_payload_t;
+
+// Encoder state of one node and sensor, or the decoder's reference for one
+typedef struct {
+    uint16_t node_id;
+    uint8_t sensor;
+    uint8_t seq;                // Sequence number of the last frame
+    uint8_t valid;              // last holds a frame deltas can refer to
+    uint8_t keyframe_interval;  // Encoder: absolute frame every n frames, 0 for never delta
+    uint8_t since_keyframe;
+    lora_payload_t last;
+} lora_payload_ctx_t;
+
+// Function prototypes
+void lora_payload_init(lora_payload_ctx_t* ctx, uint16_t node_id, uint8_t sensor, uint8_t keyframe_interval);
+void lora_payload_force_keyframe(lora_payload_ctx_t* ctx);
+int16_t lora_payload_encode(lora_payload_ctx_t* ctx, const lora_payload_t* reading, uint8_t* buf, uint8_t size);
+int8_t lora_payload_peek(const uint8_t* buf, uint8_t length, uint16_t* node_id, uint8_t* sensor);
+int8_t lora_payload_decode(lora_payload_ctx_t* ref, const uint8_t* buf, uint8_t length, lora_payload_t* out);
+
+#endif // __LORA_PAYLOAD_H__
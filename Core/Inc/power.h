@@ -0,0 +1,49 @@
+#ifndef __POWER_H__
+#define __POWER_H__
+
+#include "stm32g0xx_hal.h"
+
+// Low-power idle for the scheduler.
+// When no task is ready the power manager sleeps until the next timed
+// release: Sleep (WFI, SysTick running) for short gaps, STOP1 with an LPTIM1
+// wakeup for longer ones. STOP1 also ends on a start bit on USART2/LPUART1
+// or on the LoRa DIO1 EXTI. USART4 cannot wake the MCU from STOP, so an open
+// console session on it limits idle to Sleep.
+
+// Deepest state the idle hook may use
+#define POWER_MODE_RUN     0   // Never sleep (busy idle)
+#define POWER_MODE_SLEEP   1   // WFI only
+#define POWER_MODE_STOP    2   // STOP1 when the gap allows it
+
+// STOP1 costs a few us on each side plus the LPTIM setup, so short gaps
+// stay in Sleep
+#define POWER_STOP_MIN_MS    3
+
+// LPTIM1 runs from the LSI (~32 kHz) divided by 16, which allows a single
+// STOP period of up to ~32 s; longer idle periods are split
+#define POWER_LPTIM_PRESCALER  16
+#define POWER_LPTIM_MAX_TICKS  0xFFFF
+
+// Time spent in each state since the last reset
+typedef struct {
+    uint32_t elapsed_ms;
+    uint32_t sleep_ms;
+    uint32_t stop_ms;
+    uint32_t sleep_count;
+    uint32_t stop_count;
+    uint32_t lptim_hz;          // Measured LPTIM1 tick rate
+} power_stats_t;
+
+// Function prototypes
+void power_init(void);
+void power_idle(void);
+void power_set_mode(uint8_t mode);
+uint8_t power_get_mode(void);
+void power_get_stats(power_stats_t* stats);
+void power_reset_stats(void);
+void power_lptim_irq(void);
+
+// Console commands
+int8_t power_register_commands(void);
+
+#endif // __POWER_H__
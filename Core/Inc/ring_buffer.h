@@ -0,0 +1,25 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer byte ring.
+// The producer only writes head, the consumer only writes tail, so one side
+// may run in an ISR (or be fed by DMA) without disabling interrupts.
+// Size must be a power of two; one slot is never used to tell full from empty.
+typedef struct {
+    uint8_t* buffer;
+    uint16_t mask;
+    volatile uint16_t head;
+    volatile uint16_t tail;
+} ring_buffer_t;
+
+// Function prototypes
+void ring_buffer_init(ring_buffer_t* rb, uint8_t* storage, uint16_t size);
+void ring_buffer_reset(ring_buffer_t* rb);
+uint16_t ring_buffer_count(const ring_buffer_t* rb);
+uint16_t ring_buffer_free(const ring_buffer_t* rb);
+uint16_t ring_buffer_write(ring_buffer_t* rb, const uint8_t* data, uint16_t len);
+uint16_t ring_buffer_read(ring_buffer_t* rb, uint8_t* data, uint16_t len);
+
+#endif // __RING_BUFFER_H__
@@ -0,0 +1,56 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include "stm32g0xx_hal.h"
+
+// Cooperative run-to-completion scheduler.
+// A task runs when its period elapses, when it is woken at a given tick, or
+// when an event flag is posted (also from ISRs). Of the ready tasks the one
+// with the lowest priority number runs first; none is ever preempted. When
+// nothing is ready the idle hook runs.
+
+#define SCHED_MAX_TASKS   8
+
+// Event flag posted by sched_wake() (the other bits are task-defined)
+#define SCHED_EVENT_WAKE  (1u << 31)
+
+// Task definition (kept in flash by the owning module)
+typedef struct {
+    const char* name;
+    void (*run)(uint32_t events);   // events: flags posted since the last run
+    uint16_t period_ms;             // 0: runs only on events and sched_wake_at()
+    uint16_t deadline_ms;           // Relative to release, 0: same as period
+    uint8_t priority;               // 0 is the most urgent
+} sched_task_def_t;
+
+// Per-task counters
+typedef struct {
+    uint32_t runs;
+    uint32_t total_us;              // Time spent running
+    uint32_t max_us;                // Longest single run
+    uint32_t max_latency_us;        // Longest wait from release to start
+    uint32_t overruns;              // Finished past the deadline or skipped a period
+} sched_task_stats_t;
+
+// Called with interrupts masked when no task is ready; a WFI inside still
+// wakes on any pending interrupt, so no event is missed between the ready
+// check and the sleep.
+typedef void (*sched_idle_hook_t)(void);
+
+// Function prototypes
+int8_t sched_add_task(const sched_task_def_t* def);
+void sched_set_event(int8_t id, uint32_t events);
+void sched_wake(int8_t id);
+void sched_wake_at(int8_t id, uint32_t tick);
+void sched_set_idle_hook(sched_idle_hook_t hook);
+uint8_t sched_dispatch(void);
+uint8_t sched_next_release(uint32_t* tick);
+void sched_run(void);
+uint8_t sched_task_count(void);
+const sched_task_def_t* sched_get_task(int8_t id, sched_task_stats_t* stats);
+void sched_reset_stats(void);
+
+// Console commands
+int8_t sched_register_commands(void);
+
+#endif // __SCHEDULER_H__
@@ -0,0 +1,32 @@
+#ifndef __SENSOR_STREAM_H__
+#define __SENSOR_STREAM_H__
+
+#include "stm32g0xx_hal.h"
+#include "command_interface.h"
+
+// Streaming limits
+#define SENSOR_STREAM_MIN_HZ     1
+#define SENSOR_STREAM_MAX_HZ     10
+
+// Stream counters (reset on every start)
+typedef struct {
+    uint8_t rate_hz;            // 0 when stopped
+    uint8_t fields;             // HOST_FIELD_* mask
+    uint16_t lead_ms;           // Conversions start this long before each deadline
+    uint32_t samples_sent;
+    uint32_t samples_dropped;   // Missed deadlines and samples with no room in the TX queue
+    uint32_t read_errors;
+} sensor_stream_stats_t;
+
+// Function prototypes
+int8_t sensor_stream_start(console_ctx_t* ctx, uint8_t rate_hz, uint8_t fields);
+void sensor_stream_stop(void);
+void sensor_stream_process(void);
+int8_t sensor_stream_register_task(void);
+uint8_t sensor_stream_get_rate(void);
+void sensor_stream_get_stats(sensor_stream_stats_t* stats);
+
+// Console commands
+int8_t sensor_stream_register_commands(void);
+
+#endif // __SENSOR_STREAM_H__
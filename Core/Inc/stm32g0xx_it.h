@@ -51,7 +51,14 @@ void HardFault_Handler(void);
 void SVC_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel2_3_IRQHandler(void);
+void DMA1_Ch4_7_DMAMUX1_OVR_IRQHandler(void);
+void USART2_IRQHandler(void);
+void USART3_4_LPUART1_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM2_IRQHandler(void);
+void TIM6_DAC_LPTIM1_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,24 @@
+#ifndef __TIMEBASE_H__
+#define __TIMEBASE_H__
+
+#include "stm32g0xx_hal.h"
+
+// Microsecond timebase.
+// TIM2 (32-bit) counts at 1 MHz whatever the clock setup; its overflows extend
+// it to a 64-bit count that does not wrap in the lifetime of the device. TIM2
+// stops in STOP mode, so the power manager adds the time spent there.
+// Deadlines are absolute 64-bit times, so comparisons never wrap.
+
+// Function prototypes
+void timebase_init(void);
+uint64_t timebase_now_us(void);
+void timebase_delay_us(uint32_t us);
+void timebase_delay_ms(uint32_t ms);
+uint64_t timebase_deadline_us(uint32_t timeout_us);
+uint64_t timebase_deadline_ms(uint32_t timeout_ms);
+uint8_t timebase_expired(uint64_t deadline);
+uint32_t timebase_remaining_ms(uint64_t deadline);
+void timebase_advance_us(uint32_t us);
+void timebase_irq(void);
+
+#endif // __TIMEBASE_H__
@@ -0,0 +1,19 @@
+#ifndef __UART_RX_H__
+#define __UART_RX_H__
+
+#include "stm32g0xx_hal.h"
+
+// Receive path configuration
+#define UART_RX_MAX_PORTS       3
+#define UART_RX_DMA_SIZE        128   // Circular DMA buffer per port
+#define UART_RX_RING_SIZE       256   // SPSC ring per port (power of two)
+
+// Function prototypes
+int8_t uart_rx_start(UART_HandleTypeDef* huart);
+uint16_t uart_rx_available(UART_HandleTypeDef* huart);
+uint16_t uart_rx_read(UART_HandleTypeDef* huart, uint8_t* data, uint16_t len);
+uint32_t uart_rx_get_overflows(UART_HandleTypeDef* huart);
+uint8_t uart_rx_is_busy(UART_HandleTypeDef* huart);
+void uart_rx_set_notify(void (*notify)(void));
+
+#endif // __UART_RX_H__
@@ -0,0 +1,37 @@
+#ifndef __UART_TX_H__
+#define __UART_TX_H__
+
+#include "stm32g0xx_hal.h"
+
+// Transmit path configuration
+#define UART_TX_MAX_PORTS       3
+#define UART_TX_RING_SIZE       1024  // Queue per port (power of two)
+#define UART_TX_DMA_CHUNK       64    // Largest single DMA transfer
+
+// What to do when a write does not fit in the queue
+typedef enum {
+    UART_TX_POLICY_BLOCK = 0,     // Wait for DMA to make room (never from an ISR)
+    UART_TX_POLICY_DROP_OLDEST,   // Discard the oldest queued bytes
+    UART_TX_POLICY_TRUNCATE       // Keep what fits, discard the rest of the write
+} uart_tx_policy_t;
+
+// Per-port counters
+typedef struct {
+    uint32_t bytes_queued;
+    uint32_t bytes_dropped;
+    uint16_t high_water;
+    uint16_t pending;
+    uart_tx_policy_t policy;
+} uart_tx_stats_t;
+
+// Function prototypes
+int8_t uart_tx_init(UART_HandleTypeDef* huart, uart_tx_policy_t policy);
+void uart_tx_set_policy(UART_HandleTypeDef* huart, uart_tx_policy_t policy);
+uint16_t uart_tx_write(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t len);
+uint16_t uart_tx_write_string(UART_HandleTypeDef* huart, const char* str);
+uint16_t uart_tx_free(UART_HandleTypeDef* huart);
+uint8_t uart_tx_is_idle(UART_HandleTypeDef* huart);
+int8_t uart_tx_get_stats(UART_HandleTypeDef* huart, uart_tx_stats_t* stats);
+const char* uart_tx_policy_name(uart_tx_policy_t policy);
+
+#endif // __UART_TX_H__
@@ -0,0 +1,312 @@
+#include "benchmark.h"
+#include "command_interface.h"
+#include "bme680_interface.h"
+#include "fmt.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef BENCH_PRINTF_FLOAT
+#include <stdio.h>
+#endif
+
+#define BENCH_DEFAULT_COUNT  100
+#define BENCH_MAX_COUNT      10000
+
+// Keeps the formatted output observable so the loops are not optimised away
+static volatile uint16_t bench_sink;
+
+// Read tick and SysTick counter as one consistent pair
+static void bench_now(uint32_t* tick, uint32_t* count)
+{
+    uint32_t before;
+
+    do {
+        before = SysTick->VAL;
+        *tick = HAL_GetTick();
+        *count = SysTick->VAL;
+    } while (*count > before); // Counter reloaded in between, read again
+}
+
+void bench_start(bench_mark_t* mark)
+{
+    bench_now(&mark->tick, &mark->count);
+}
+
+// Core clock cycles since bench_start (SysTick counts down, reloads every ms)
+uint32_t bench_cycles(const bench_mark_t* mark)
+{
+    uint32_t tick;
+    uint32_t count;
+
+    bench_now(&tick, &count);
+    return (tick - mark->tick) * (SysTick->LOAD + 1) + mark->count - count;
+}
+
+// Report one timed case
+static void bench_report(console_ctx_t* ctx, const char* name, uint32_t cycles, uint32_t count)
+{
+    uint32_t per_sample = cycles / count;
+
+    console_printf(ctx, "  %-24s %7lu cycles/sample (%lu us)\r\n", name, per_sample,
+                   per_sample / (SystemCoreClock / 1000000u));
+}
+
+// Command handler timing the sample formatting paths
+static void cmd_bench_fmt(console_ctx_t* ctx, int argc, char* argv[])
+{
+    const float temperature = 23.45f;
+    const float pressure = 101325.37f;
+    const float humidity = 45.67f;
+    const bme680_sample_t sample = {
+        .timestamp = 123456, .temperature = 2345, .pressure = 101325, .humidity = 4567
+    };
+    uint32_t count = (argc > 1) ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    char text[96];
+    bench_mark_t mark;
+    fmt_t line;
+
+    if (count == 0 || count > BENCH_MAX_COUNT) {
+        console_printf(ctx, "Count must be 1-%u\r\n", BENCH_MAX_COUNT);
+        return;
+    }
+
+    console_printf(ctx, "Formatting one T/P/H sample, %lu runs:\r\n", count);
+
+    // Fixed-point sample, as streamed and sent over LoRa
+    bench_start(&mark);
+    for (uint32_t i = 0; i < count; i++) {
+        fmt_init(&line, text, sizeof(text));
+        fmt_u32(&line, sample.timestamp);
+        fmt_char(&line, ',');
+        fmt_fixed(&line, sample.temperature, 2);
+        fmt_char(&line, ',');
+        fmt_u32(&line, sample.pressure);
+        fmt_char(&line, ',');
+        fmt_fixed(&line, sample.humidity, 2);
+        fmt_str(&line, "\r\n");
+        bench_sink = line.len;
+    }
+    bench_report(ctx, "fmt fixed-point", bench_cycles(&mark), count);
+
+    // Float driver values, as printed by the read commands
+    bench_start(&mark);
+    for (uint32_t i = 0; i < count; i++) {
+        fmt_init(&line, text, sizeof(text));
+        fmt_str(&line, "T: ");
+        fmt_float(&line, temperature, 2);
+        fmt_str(&line, " P: ");
+        fmt_float(&line, pressure, 2);
+        fmt_str(&line, " H: ");
+        fmt_float(&line, humidity, 2);
+        fmt_str(&line, "\r\n");
+        bench_sink = line.len;
+    }
+    bench_report(ctx, "fmt_float", bench_cycles(&mark), count);
+
+#ifdef BENCH_PRINTF_FLOAT
+    // The previous newlib-nano path
+    bench_start(&mark);
+    for (uint32_t i = 0; i < count; i++) {
+        bench_sink = (uint16_t)snprintf(text, sizeof(text), "T: %.2f P: %.2f H: %.2f\r\n",
+                                        temperature, pressure, humidity);
+    }
+    bench_report(ctx, "snprintf %.2f", bench_cycles(&mark), count);
+#else
+    console_write(ctx, "  (build with BENCH_PRINTF_FLOAT to time snprintf \"%.2f\")\r\n");
+#endif
+}
+
+// Compensation benchmark.
+// The BME68x driver runs against a register image in RAM instead of the I2C
+// bus, holding a synthetic calibration block and, in turn, each synthetic raw
+// field (plausible register values spread over the operating range, not
+// captured from a sensor). The reference results were computed by the float
+// build of the same driver (fixed units, no temperature offset), so the
+// integer build is checked against them; run the command in the Debug
+// (integer) and Release (float) builds to compare speed.
+#define BENCH_COMP_REG_COUNT  256
+
+typedef struct {
+    uint32_t adc_temp;          // 20-bit ADC values as read from the field registers
+    uint32_t adc_pres;
+    uint16_t adc_hum;
+    uint16_t adc_gas;           // 10-bit, low gas variant
+    uint8_t gas_range;
+    int16_t temperature;        // Float path result, 0.01 degC
+    uint32_t pressure;          // Pa
+    uint16_t humidity;          // 0.01 %RH
+    uint32_t gas_resistance;    // Ohm
+} bench_comp_vector_t;
+
+// Calibration registers 0x8A-0xA0, 0xE1-0xEE and 0x00-0x04, in driver order
+static const uint8_t bench_comp_calib[BME68X_LEN_COEFF_ALL] = {
+    0x1D, 0x67, 0x03, 0x00, 0x76, 0x8E, 0x85, 0xD7, 0x58, 0x00, 0x9C, 0x1A, 0xA9, 0xFF,
+    0x21, 0x1E, 0x00, 0x00, 0xF9, 0xFE, 0x04, 0xF5, 0x1E, 0x3F, 0x1F, 0x2F, 0x00, 0x2D,
+    0x14, 0x78, 0x9C, 0xFA, 0x65, 0xB9, 0xDA, 0xEA, 0x12, 0x2C, 0x00, 0x10, 0x00, 0x00,
+};
+
+// -30 to 55 degC, 600 to 1100 hPa, 5 to 92 %RH, 3 kOhm to 1.5 MOhm
+static const bench_comp_vector_t bench_comp_vectors[] = {
+    { 384327, 314903, 21773,  512,  5, -1050, 101325, 4550,  248262 },
+    { 418491, 345825, 26992,  300,  7,    25,  98000, 8020,   74959 },
+    { 458370, 434662, 18678,  700,  3,  1280,  85000, 3000,  876963 },
+    { 485599, 333771, 22879,  150, 10,  2137, 103500, 5555,   10712 },
+    { 506345, 388996, 15011,  900,  2,  2790,  95000, 1230, 1550926 },
+    { 540336, 540584, 27667,  423,  8,  3860,  70000, 9200,   33507 },
+    { 592426, 328944, 13323, 1000,  4,  5500, 110000,  500,  366155 },
+    { 321709, 556451, 25132,   60, 12, -3020,  60000, 6500,    2947 },
+};
+
+#define BENCH_COMP_VECTOR_COUNT  (sizeof(bench_comp_vectors) / sizeof(bench_comp_vectors[0]))
+
+static uint8_t bench_comp_regs[BENCH_COMP_REG_COUNT];
+
+static int8_t bench_comp_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    (void)intf_ptr;
+    if (reg_addr + len > BENCH_COMP_REG_COUNT) {
+        return BME68X_E_COM_FAIL;
+    }
+    memcpy(reg_data, &bench_comp_regs[reg_addr], len);
+    return BME68X_OK;
+}
+
+// Writes (soft reset) are accepted and dropped, the image stays as loaded
+static int8_t bench_comp_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    (void)reg_addr;
+    (void)reg_data;
+    (void)len;
+    (void)intf_ptr;
+    return BME68X_OK;
+}
+
+static void bench_comp_delay_us(uint32_t period, void* intf_ptr)
+{
+    (void)period;
+    (void)intf_ptr;
+}
+
+// Load one vector into field 0 as a finished forced-mode conversion
+static void bench_comp_load(const bench_comp_vector_t* vector)
+{
+    uint8_t* field = &bench_comp_regs[BME68X_REG_FIELD0];
+
+    field[0] = BME68X_NEW_DATA_MSK;
+    field[2] = (uint8_t)(vector->adc_pres >> 12);
+    field[3] = (uint8_t)(vector->adc_pres >> 4);
+    field[4] = (uint8_t)(vector->adc_pres << 4);
+    field[5] = (uint8_t)(vector->adc_temp >> 12);
+    field[6] = (uint8_t)(vector->adc_temp >> 4);
+    field[7] = (uint8_t)(vector->adc_temp << 4);
+    field[8] = (uint8_t)(vector->adc_hum >> 8);
+    field[9] = (uint8_t)vector->adc_hum;
+    field[13] = (uint8_t)(vector->adc_gas >> 2);
+    field[14] = (uint8_t)(vector->adc_gas << 6) | BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK |
+                vector->gas_range;
+}
+
+// Compensate the loaded vector and convert it as bme680_interface does
+static int8_t bench_comp_run(struct bme68x_dev* dev, bme680_sample_t* sample)
+{
+    struct bme68x_data data;
+    uint8_t n_data;
+    int8_t rslt;
+
+    rslt = bme68x_get_data(BME68X_FORCED_MODE, &data, &n_data, dev);
+    if (rslt == BME68X_OK) {
+        bme680_to_sample(&data, 0, sample);
+    }
+    return rslt;
+}
+
+// Keep the largest |value - reference| seen
+static void bench_comp_error(uint32_t* max_error, int32_t value, int32_t reference)
+{
+    uint32_t error = (uint32_t)((value > reference) ? value - reference : reference - value);
+
+    if (error > *max_error) {
+        *max_error = error;
+    }
+}
+
+// Command handler timing the BME68x compensation on synthetic raw vectors
+static void cmd_bench_comp(console_ctx_t* ctx, int argc, char* argv[])
+{
+    uint32_t count = (argc > 1) ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    uint32_t err_t = 0, err_p = 0, err_h = 0, err_g = 0;
+    struct bme68x_dev dev = { 0 };
+    bme680_sample_t sample;
+    bench_mark_t mark;
+    uint32_t cycles = 0;
+    int8_t rslt;
+
+    if (count == 0 || count > BENCH_MAX_COUNT) {
+        console_printf(ctx, "Count must be 1-%u\r\n", BENCH_MAX_COUNT);
+        return;
+    }
+
+    memset(bench_comp_regs, 0, sizeof(bench_comp_regs));
+    memcpy(&bench_comp_regs[BME68X_REG_COEFF1], bench_comp_calib, BME68X_LEN_COEFF1);
+    memcpy(&bench_comp_regs[BME68X_REG_COEFF2], &bench_comp_calib[BME68X_LEN_COEFF1], BME68X_LEN_COEFF2);
+    memcpy(&bench_comp_regs[BME68X_REG_COEFF3], &bench_comp_calib[BME68X_LEN_COEFF1 + BME68X_LEN_COEFF2],
+           BME68X_LEN_COEFF3);
+    bench_comp_regs[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+    bench_comp_regs[BME68X_REG_VARIANT_ID] = BME68X_VARIANT_GAS_LOW;
+
+    dev.intf = BME68X_I2C_INTF;
+    dev.read = bench_comp_read;
+    dev.write = bench_comp_write;
+    dev.delay_us = bench_comp_delay_us;
+    dev.amb_temp = 25;
+    rslt = bme68x_init(&dev);
+    if (rslt != BME68X_OK) {
+        console_printf(ctx, "Driver init on the register image failed: %d\r\n", rslt);
+        return;
+    }
+
+#ifdef BME68X_USE_FPU
+    console_printf(ctx, "Float compensation (soft-float), %u vectors x %lu runs:\r\n",
+                   BENCH_COMP_VECTOR_COUNT, count);
+#else
+    console_printf(ctx, "Integer compensation, %u vectors x %lu runs:\r\n",
+                   BENCH_COMP_VECTOR_COUNT, count);
+#endif
+
+    // Time the driver read and conversion, the field load stays outside
+    for (uint8_t v = 0; v < BENCH_COMP_VECTOR_COUNT; v++) {
+        const bench_comp_vector_t* vector = &bench_comp_vectors[v];
+
+        bench_comp_load(vector);
+        bench_start(&mark);
+        for (uint32_t i = 0; i < count; i++) {
+            rslt = bench_comp_run(&dev, &sample);
+        }
+        cycles += bench_cycles(&mark);
+        if (rslt != BME68X_OK) {
+            console_printf(ctx, "Vector %u failed: %d\r\n", v, rslt);
+            return;
+        }
+
+        bench_comp_error(&err_t, sample.temperature, vector->temperature);
+        bench_comp_error(&err_p, (int32_t)sample.pressure, (int32_t)vector->pressure);
+        bench_comp_error(&err_h, sample.humidity, vector->humidity);
+        // Gas in per mille of the reference, it spans three decades
+        bench_comp_error(&err_g, (int32_t)((uint64_t)sample.gas_resistance * 1000u / vector->gas_resistance), 1000);
+    }
+    bench_report(ctx, "get_data + to_sample", cycles, count * BENCH_COMP_VECTOR_COUNT);
+
+    console_printf(ctx, "  Max error vs float reference: T %lu.%02lu degC, P %lu Pa, H %lu.%02lu %%RH, gas %lu.%lu%%\r\n",
+                   err_t / 100, err_t % 100, err_p, err_h / 100, err_h % 100, err_g / 10, err_g % 10);
+}
+
+static const console_command_t benchmark_commands[] = {
+    { "bench fmt", NULL, "[count]", cmd_bench_fmt, "Time sample formatting (cycles per sample)" },
+    { "bench comp", NULL, "[count]", cmd_bench_comp, "Time BME68x compensation on synthetic raw vectors" },
+};
+
+// Register the benchmark commands with the console
+int8_t benchmark_register_commands(void)
+{
+    return console_register_commands("Diagnostics", benchmark_commands,
+                                     sizeof(benchmark_commands) / sizeof(benchmark_commands[0]));
+}
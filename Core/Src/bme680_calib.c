@@ -0,0 +1,167 @@
+#include "bme680_calib.h"
+#include "host_protocol.h"
+#include "log.h"
+#include <string.h>
+#include <stddef.h>
+
+// Flash record. A change of the driver's calibration structure changes size
+// and invalidates old records.
+typedef struct {
+    uint32_t magic;             // BME680_CALIB_MAGIC
+    bme680_calib_key_t key;
+    struct bme68x_calib_data calib;
+    uint16_t size;              // sizeof(struct bme68x_calib_data)
+    uint16_t crc;               // CRC16-CCITT of everything before it
+} bme680_calib_record_t;
+
+// Flash is programmed in 64-bit double words; the records of the two
+// addresses follow each other, each padded to whole double words
+#define BME680_CALIB_DWORDS  ((sizeof(bme680_calib_record_t) + 7) / 8)
+
+typedef union {
+    bme680_calib_record_t record;
+    uint64_t dwords[BME680_CALIB_DWORDS];
+} bme680_calib_slot_t;
+
+static bme680_calib_stats_t bme680_calib_stats;
+
+static const bme680_calib_record_t* bme680_calib_flash(uint8_t slot)
+{
+    return &((const bme680_calib_slot_t*)BME680_CALIB_FLASH_ADDR)[slot].record;
+}
+
+// Record slot of a sensor: 0 for 0x76, 1 for 0x77
+static uint8_t bme680_calib_slot(uint8_t address)
+{
+    return address & 1;
+}
+
+// Erase the record page (flash unlocked by the caller)
+static HAL_StatusTypeDef bme680_calib_erase_page(void)
+{
+    FLASH_EraseInitTypeDef erase = { 0 };
+    uint32_t page_error;
+
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.Banks = FLASH_BANK_1;
+    erase.Page = BME680_CALIB_FLASH_PAGE;
+    erase.NbPages = 1;
+    return HAL_FLASHEx_Erase(&erase, &page_error);
+}
+
+// The flash record is complete and uncorrupted
+static uint8_t bme680_calib_record_valid(const bme680_calib_record_t* record)
+{
+    return record->magic == BME680_CALIB_MAGIC && record->size == sizeof(struct bme68x_calib_data) &&
+           record->crc == host_protocol_crc16((const uint8_t*)record, offsetof(bme680_calib_record_t, crc));
+}
+
+// Copy the stored coefficients if the record is valid and was saved for this
+// sensor, returns 0 if the caller has to read them from the sensor
+uint8_t bme680_calib_load(const bme680_calib_key_t* key, struct bme68x_calib_data* calib)
+{
+    const bme680_calib_record_t* record = bme680_calib_flash(bme680_calib_slot(key->address));
+
+    if (!bme680_calib_record_valid(record) || memcmp(&record->key, key, sizeof(*key)) != 0) {
+        bme680_calib_stats.misses++;
+        return 0;
+    }
+
+    *calib = record->calib;
+    bme680_calib_stats.loads++;
+    return 1;
+}
+
+// Store the coefficients for this sensor. Rewrites the page only when the
+// record differs, so repeated bring-ups of the same sensor do not wear the
+// flash; the record of the other address is carried over. The page erase
+// takes up to 40 ms with the CPU stalled on flash reads.
+// Returns 0, or -1 if erasing or programming failed.
+int8_t bme680_calib_save(const bme680_calib_key_t* key, const struct bme68x_calib_data* calib)
+{
+    uint8_t slot = bme680_calib_slot(key->address);
+    const bme680_calib_record_t* stored = bme680_calib_flash(slot);
+    bme680_calib_slot_t buffer[BME680_CALIB_SLOTS];
+    uint8_t keep[BME680_CALIB_SLOTS];
+    HAL_StatusTypeDef status;
+
+    // Padding is zeroed so the CRC and the comparison cover fixed bytes
+    memset(buffer, 0, sizeof(buffer));
+    buffer[slot].record.magic = BME680_CALIB_MAGIC;
+    buffer[slot].record.key = *key;
+    buffer[slot].record.calib = *calib;
+    buffer[slot].record.calib.t_fine = 0;   // Compensation scratch, not a coefficient
+    buffer[slot].record.size = sizeof(struct bme68x_calib_data);
+    buffer[slot].record.crc = host_protocol_crc16((const uint8_t*)&buffer[slot].record,
+                                                  offsetof(bme680_calib_record_t, crc));
+
+    if (memcmp(stored, &buffer[slot].record, sizeof(buffer[slot].record)) == 0) {
+        return 0;
+    }
+
+    // Valid records of the other address survive the erase
+    for (uint8_t i = 0; i < BME680_CALIB_SLOTS; i++) {
+        keep[i] = (i == slot) || bme680_calib_record_valid(bme680_calib_flash(i));
+        if (i != slot && keep[i]) {
+            memcpy(&buffer[i], bme680_calib_flash(i), sizeof(buffer[i]));
+        }
+    }
+
+    HAL_FLASH_Unlock();
+    status = bme680_calib_erase_page();
+    for (uint8_t i = 0; i < BME680_CALIB_SLOTS && status == HAL_OK; i++) {
+        for (uint32_t j = 0; keep[i] && j < BME680_CALIB_DWORDS && status == HAL_OK; j++) {
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD,
+                                       BME680_CALIB_FLASH_ADDR + (i * BME680_CALIB_DWORDS + j) * 8,
+                                       buffer[i].dwords[j]);
+        }
+    }
+    HAL_FLASH_Lock();
+
+    if (status != HAL_OK || !bme680_calib_record_valid(stored)) {
+        LOG_ERROR(BME680, "Calibration save failed: %d", status);
+        bme680_calib_stats.save_errors++;
+        return -1;
+    }
+
+    LOG_INFO(BME680, "Calibration for 0x%02X saved to flash (%u bytes)", key->address,
+             (unsigned)sizeof(buffer[slot].record));
+    bme680_calib_stats.saves++;
+    return 0;
+}
+
+// Drop the stored records, the next bring-up of every sensor reads it.
+// Returns 0, or -1 if erasing failed.
+int8_t bme680_calib_erase(void)
+{
+    HAL_StatusTypeDef status;
+
+    HAL_FLASH_Unlock();
+    status = bme680_calib_erase_page();
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? 0 : -1;
+}
+
+// A valid record is stored in slot (BME680_CALIB_SLOTS of them), its key
+// copied to key (may be NULL)
+uint8_t bme680_calib_stored(uint8_t slot, bme680_calib_key_t* key)
+{
+    const bme680_calib_record_t* record;
+
+    if (slot >= BME680_CALIB_SLOTS) {
+        return 0;
+    }
+    record = bme680_calib_flash(slot);
+    if (!bme680_calib_record_valid(record)) {
+        return 0;
+    }
+    if (key != NULL) {
+        *key = record->key;
+    }
+    return 1;
+}
+
+void bme680_calib_get_stats(bme680_calib_stats_t* stats)
+{
+    *stats = bme680_calib_stats;
+}
@@ -1,234 +1,403 @@
 #include "bme680_interface.h"
+#include "bme680_calib.h"
 #include "main.h"
-#include <stdio.h>
+#include "command_interface.h"
+#include "fmt.h"
+#include "log.h"
+#include "scheduler.h"
+#include "timebase.h"
 #include <string.h>
+#include <stdlib.h>
 #include <math.h>
 
 extern I2C_HandleTypeDef hi2c1;
-extern UART_HandleTypeDef huart2;
-extern UART_HandleTypeDef huart4;
 
-// BME680 device structure
-struct bme68x_dev bme680_dev;
+// Measurement profiles, indexed by BME680_MEAS_*
+static const bme680_meas_profile_t bme680_meas_profiles[BME680_MEAS_PROFILE_COUNT] = {
+    { "low-power",      BME68X_OS_1X, BME68X_OS_1X,  BME68X_OS_1X, BME68X_FILTER_OFF,     BME68X_ODR_1000_MS },
+    { "balanced",       BME68X_OS_2X, BME68X_OS_4X,  BME68X_OS_1X, BME68X_FILTER_SIZE_3,  BME68X_ODR_250_MS },
+    { "high-precision", BME68X_OS_2X, BME68X_OS_16X, BME68X_OS_2X, BME68X_FILTER_SIZE_15, BME68X_ODR_NONE },
+    { "fast-stream",    BME68X_OS_1X, BME68X_OS_2X,  BME68X_OS_1X, BME68X_FILTER_SIZE_3,  BME68X_ODR_NONE },
+};
 
-// Debug function to send message to both UARTs
+static uint8_t bme680_meas_id = BME680_MEAS_DEFAULT;
+
+// Standby per BME68X_ODR_* in ms (0.59 ms rounded up, none for BME68X_ODR_NONE)
+static const uint16_t bme680_odr_ms[] = { 1, 63, 125, 250, 500, 1000, 10, 20, 0 };
+
+// Supply current while converting each channel, and in sleep (datasheet typicals)
+#define BME680_IDD_TEMP_UA      350
+#define BME680_IDD_PRES_UA      714
+#define BME680_IDD_HUM_UA       340
+#define BME680_IDD_SLEEP_NA     150
+#define BME680_OS_CYCLE_US      1963   // One oversampling cycle, as in bme68x_get_meas_dur()
+
+// Conversion in progress and the callbacks waiting for it
+typedef struct {
+    bme680_callback_t done;
+    void* arg;
+} bme680_waiter_t;
+
+typedef struct {
+    uint8_t running;
+    uint8_t waiter_count;
+    bme680_waiter_t waiters[BME680_MAX_WAITERS];
+    uint32_t start_tick;
+    uint32_t due_tick;          // Next look at the sensor: conversion end, then every poll
+    uint32_t timeout_tick;
+} bme680_measurement_t;
+
+// One sensor on the bus. The driver hands intf_ptr (pointing here) to the
+// I2C callbacks, which take the address and health tracking from it.
+typedef struct {
+    uint8_t id;
+    struct bme68x_dev dev;
+    struct bme68x_conf conf;    // Active TPH configuration (timing needs no register reads)
+    bme680_health_t health;
+    bme680_measurement_t meas;
+    bme680_sample_t cache;      // Latest good sample, from any conversion
+    uint8_t cache_valid;
+} bme680_sensor_t;
+
+// Sensor 0 always exists, failed and re-probed if nothing answered at boot
+static bme680_sensor_t bme680_sensors[BME680_MAX_SENSORS] = {
+    [0] = { .health = { .state = BME680_HEALTH_UNKNOWN, .address = BME68X_I2C_ADDR_LOW } },
+};
+static uint8_t bme680_sensor_slots = 1;
+static uint8_t bme680_discovered;       // Some sensor answered (at boot or on a re-probe)
+
+// Running gas heater profile (sensor 0 only)
+typedef struct {
+    bme680_profile_t profile;
+    bme680_profile_stats_t stats;
+    uint16_t reg_dur[BME680_PROFILE_MAX_STEPS]; // Heating times as passed to the driver
+    uint8_t last_index;         // meas_index of the last field taken
+    uint8_t have_index;
+    uint16_t poll_ms;           // Sequential/parallel: interval between burst reads
+    uint8_t step_pending;       // Forced: the current step's conversion was started
+    uint32_t step_start;
+    uint32_t step_timeout;
+    uint32_t next_tick;         // Next run of the profile state machine
+} bme680_profile_state_t;
+
+static bme680_profile_state_t bme680_prof;
+static bme680_sensor_t* const bme680_prof_sensor = &bme680_sensors[0];
+
+// The sensor task has one timed release shared by all sensors; it is kept at
+// the earliest tick any of them asked for
+static int8_t bme680_task_id = -1;
+static uint32_t bme680_wake_tick;
+static uint8_t bme680_wake_armed;
+static uint8_t bme680_first_sensor;     // Round-robin start of the next task run
+
+// Debug function to send message to every console port
 void debug_print(const char* message) {
-    HAL_UART_Transmit(&huart2, (uint8_t*)message, strlen(message), HAL_MAX_DELAY);
-    HAL_UART_Transmit(&huart4, (uint8_t*)message, strlen(message), HAL_MAX_DELAY);
+    command_interface_broadcast(message);
 }
 
-// I2C bus scanner function
-void i2c_scan_bus(void) {
-    uint8_t found_devices = 0;
-    char debug_msg[128];
-    
-    debug_print("Scanning I2C bus for devices...\r\n");
-    
-    for (uint8_t addr = 1; addr < 128; addr++) {
-        HAL_StatusTypeDef status = HAL_I2C_IsDeviceReady(&hi2c1, addr << 1, 2, 100);
-        if (status == HAL_OK) {
-            snprintf(debug_msg, sizeof(debug_msg), "Device found at address: 0x%02X\r\n", addr);
-            debug_print(debug_msg);
-            found_devices++;
-        }
+// Append a reading with two decimals, fields separated by sep
+static void bme680_format_reading(fmt_t* f, const bme680_sample_t* sample, const char* sep)
+{
+    fmt_str(f, "Temperature: ");
+    fmt_fixed(f, sample->temperature, 2);
+    fmt_str(f, "°C");
+    fmt_str(f, sep);
+    fmt_str(f, "Pressure: ");
+    fmt_u32(f, sample->pressure);
+    fmt_str(f, " Pa");
+    fmt_str(f, sep);
+    fmt_str(f, "Humidity: ");
+    fmt_fixed(f, sample->humidity, 2);
+    fmt_str(f, "%\r\n");
+}
+
+// Ask for a sensor task run at tick; an earlier pending run is kept
+static void bme680_wake_at(uint32_t tick)
+{
+    if (!bme680_wake_armed || (int32_t)(tick - bme680_wake_tick) < 0) {
+        bme680_wake_tick = tick;
+        bme680_wake_armed = 1;
+        sched_wake_at(bme680_task_id, tick);
     }
-    
-    if (found_devices == 0) {
-        debug_print("No I2C devices found on bus!\r\n");
-    } else {
-        snprintf(debug_msg, sizeof(debug_msg), "Total devices found: %d\r\n", found_devices);
-        debug_print(debug_msg);
+}
+
+// Mark a sensor failed and schedule its first background re-probe
+static void bme680_health_fail(bme680_sensor_t* s)
+{
+    s->health.state = BME680_HEALTH_FAILED;
+    s->health.backoff_ms = BME680_PROBE_MIN_MS;
+    s->health.next_probe = HAL_GetTick() + s->health.backoff_ms;
+    bme680_wake_at(s->health.next_probe);
+}
+
+// Account for one I2C transfer
+static void bme680_health_record(bme680_sensor_t* s, uint8_t ok)
+{
+    s->health.transfers++;
+    if (ok) {
+        s->health.consecutive_errors = 0;
+        return;
+    }
+
+    s->health.errors++;
+    if (++s->health.consecutive_errors >= BME680_HEALTH_MAX_ERRORS &&
+        s->health.state == BME680_HEALTH_OK) {
+        LOG_WARN(BME680, "Sensor %u marked failed after %u I2C errors", s->id, s->health.consecutive_errors);
+        bme680_health_fail(s);
     }
 }
 
-// Enhanced I2C read function for BME680 with detailed error reporting
+// I2C read function for BME680 (per-transfer trace at debug level).
+// intf_ptr is the sensor the driver works on.
 int8_t bme680_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
+    bme680_sensor_t* s = intf_ptr;
     HAL_StatusTypeDef status;
-    char debug_msg[128];
-    
-    // Debug: Print read attempt
-    snprintf(debug_msg, sizeof(debug_msg), "I2C Read: Reg=0x%02X, Len=%lu\r\n", reg_addr, len);
-    debug_print(debug_msg);
     
     // Read data from BME680 using I2C
-    status = HAL_I2C_Mem_Read(&hi2c1, BME68X_I2C_ADDR_LOW << 1, reg_addr, 
-                              I2C_MEMADD_SIZE_8BIT, reg_data, len, 1000);
+    status = HAL_I2C_Mem_Read(&hi2c1, s->health.address << 1, reg_addr, 
+                              I2C_MEMADD_SIZE_8BIT, reg_data, len, BME680_I2C_TIMEOUT_MS);
+    bme680_health_record(s, status == HAL_OK);
     
-    if (status == HAL_OK) {
-        snprintf(debug_msg, sizeof(debug_msg), "I2C Read Success: Data[0]=0x%02X\r\n", reg_data[0]);
-        debug_print(debug_msg);
-        return BME68X_OK;
-    } else {
-        snprintf(debug_msg, sizeof(debug_msg), "I2C Read Failed: Status=%d\r\n", status);
-        debug_print(debug_msg);
+    if (status != HAL_OK) {
+        LOG_ERROR(I2C, "Read failed: Addr=0x%02X, Reg=0x%02X, Len=%lu, Status=%d", s->health.address, reg_addr,
+                  len, status);
         return BME68X_E_COM_FAIL;
     }
+    
+    LOG_DEBUG(I2C, "Read: Addr=0x%02X, Reg=0x%02X, Len=%lu, Data[0]=0x%02X", s->health.address, reg_addr, len,
+              reg_data[0]);
+    return BME68X_OK;
 }
 
-// Enhanced I2C write function for BME680 with detailed error reporting
+// I2C write function for BME680 (per-transfer trace at debug level)
 int8_t bme680_i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
+    bme680_sensor_t* s = intf_ptr;
     HAL_StatusTypeDef status;
-    char debug_msg[128];
-    
-    // Debug: Print write attempt
-    snprintf(debug_msg, sizeof(debug_msg), "I2C Write: Reg=0x%02X, Data[0]=0x%02X, Len=%lu\r\n", 
-             reg_addr, reg_data[0], len);
-    debug_print(debug_msg);
     
     // Write data to BME680 using I2C
-    status = HAL_I2C_Mem_Write(&hi2c1, BME68X_I2C_ADDR_LOW << 1, reg_addr, 
-                               I2C_MEMADD_SIZE_8BIT, (uint8_t*)reg_data, len, 1000);
+    status = HAL_I2C_Mem_Write(&hi2c1, s->health.address << 1, reg_addr, 
+                               I2C_MEMADD_SIZE_8BIT, (uint8_t*)reg_data, len, BME680_I2C_TIMEOUT_MS);
+    bme680_health_record(s, status == HAL_OK);
     
-    if (status == HAL_OK) {
-        debug_print("I2C Write Success\r\n");
-        return BME68X_OK;
-    } else {
-        snprintf(debug_msg, sizeof(debug_msg), "I2C Write Failed: Status=%d\r\n", status);
-        debug_print(debug_msg);
+    if (status != HAL_OK) {
+        LOG_ERROR(I2C, "Write failed: Addr=0x%02X, Reg=0x%02X, Len=%lu, Status=%d", s->health.address, reg_addr,
+                  len, status);
         return BME68X_E_COM_FAIL;
     }
+    
+    LOG_DEBUG(I2C, "Write: Addr=0x%02X, Reg=0x%02X, Data[0]=0x%02X, Len=%lu", s->health.address, reg_addr,
+              reg_data[0], len);
+    return BME68X_OK;
 }
 
-// Delay function for BME680
+// Delay function for BME680 (timer based, independent of clock and optimization)
 void bme680_delay_us(uint32_t period, void *intf_ptr)
 {
-    // For small delays, use a simple loop
-    // For larger delays, use HAL_Delay
-    if (period < 1000) {
-        // Simple microsecond delay loop
-        volatile uint32_t i;
-        for (i = 0; i < period * 16; i++) {
-            __NOP();
-        }
-    } else {
-        // Convert microseconds to milliseconds for HAL_Delay
-        HAL_Delay(period / 1000);
-    }
+    timebase_delay_us(period);
 }
 
-// Enhanced sensor presence check with multiple address attempts
-int8_t bme680_check_sensor_presence(void)
+// A BME68x answers at address (one try, short timeouts)
+static int8_t bme680_probe_address(uint8_t address)
 {
     HAL_StatusTypeDef status;
     uint8_t chip_id;
-    char debug_msg[128];
-    
-    debug_print("Checking BME680 sensor presence...\r\n");
-    
-    // Try both possible addresses
-    uint8_t addresses[] = {BME68X_I2C_ADDR_LOW, BME68X_I2C_ADDR_HIGH};
-    const char* addr_names[] = {"0x76", "0x77"};
-    
-    for (int i = 0; i < 2; i++) {
-        snprintf(debug_msg, sizeof(debug_msg), "Trying address %s...\r\n", addr_names[i]);
-        debug_print(debug_msg);
-        
-        // First check if device responds
-        status = HAL_I2C_IsDeviceReady(&hi2c1, addresses[i] << 1, 3, 1000);
-        if (status == HAL_OK) {
-            snprintf(debug_msg, sizeof(debug_msg), "Device responds at address %s\r\n", addr_names[i]);
-            debug_print(debug_msg);
-            
-            // Try to read chip ID
-            status = HAL_I2C_Mem_Read(&hi2c1, addresses[i] << 1, BME68X_REG_CHIP_ID, 
-                                      I2C_MEMADD_SIZE_8BIT, &chip_id, 1, 1000);
-            
-            if (status == HAL_OK) {
-                snprintf(debug_msg, sizeof(debug_msg), "Chip ID read: 0x%02X (Expected: 0x%02X)\r\n", 
-                         chip_id, BME68X_CHIP_ID);
-                debug_print(debug_msg);
-                
-                if (chip_id == BME68X_CHIP_ID) {
-                    snprintf(debug_msg, sizeof(debug_msg), "✓ BME680 found at address %s\r\n", addr_names[i]);
-                    debug_print(debug_msg);
-                    return BME68X_OK;
-                } else {
-                    snprintf(debug_msg, sizeof(debug_msg), "✗ Wrong chip ID at address %s\r\n", addr_names[i]);
-                    debug_print(debug_msg);
-                }
-            } else {
-                snprintf(debug_msg, sizeof(debug_msg), "✗ Failed to read chip ID at address %s\r\n", addr_names[i]);
-                debug_print(debug_msg);
-            }
-        } else {
-            snprintf(debug_msg, sizeof(debug_msg), "✗ No device at address %s\r\n", addr_names[i]);
-            debug_print(debug_msg);
+
+    // First check if device responds
+    status = HAL_I2C_IsDeviceReady(&hi2c1, address << 1, 1, BME680_I2C_TIMEOUT_MS);
+    if (status != HAL_OK) {
+        LOG_DEBUG(BME680, "No device at address 0x%02X", address);
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+
+    // Try to read chip ID
+    status = HAL_I2C_Mem_Read(&hi2c1, address << 1, BME68X_REG_CHIP_ID,
+                              I2C_MEMADD_SIZE_8BIT, &chip_id, 1, BME680_I2C_TIMEOUT_MS);
+    if (status != HAL_OK) {
+        LOG_DEBUG(BME680, "Failed to read chip ID at address 0x%02X", address);
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+
+    LOG_DEBUG(BME680, "Chip ID at 0x%02X: 0x%02X (Expected: 0x%02X)", address, chip_id, BME68X_CHIP_ID);
+    return (chip_id == BME68X_CHIP_ID) ? BME68X_OK : BME68X_E_DEV_NOT_FOUND;
+}
+
+// Sensor discovery on both addresses. Every address that answers with the
+// BME68x chip ID becomes a sensor, numbered in address order, and keeps that
+// address for every later transfer.
+int8_t bme680_check_sensor_presence(void)
+{
+    static const uint8_t addresses[] = { BME68X_I2C_ADDR_LOW, BME68X_I2C_ADDR_HIGH };
+    uint8_t found = 0;
+
+    for (uint8_t i = 0; i < sizeof(addresses) && found < BME680_MAX_SENSORS; i++) {
+        if (bme680_probe_address(addresses[i]) == BME68X_OK) {
+            bme680_sensors[found].id = found;
+            bme680_sensors[found].health.address = addresses[i];
+            found++;
         }
     }
-    
-    debug_print("✗ BME680 sensor not found on any address\r\n");
-    return BME68X_E_DEV_NOT_FOUND;
+
+    if (found == 0) {
+        LOG_WARN(BME680, "Sensor not found on any address");
+        if (bme680_sensors[0].health.state != BME680_HEALTH_FAILED) {
+            bme680_health_fail(&bme680_sensors[0]);
+        }
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+
+    bme680_sensor_slots = found;
+    bme680_discovered = 1;
+    LOG_INFO(BME680, "%u sensor(s) found", found);
+    return BME68X_OK;
 }
 
-// Enhanced sensor initialization with detailed error reporting
-int8_t bme680_init_sensor(void)
+// Heater off and back to plain forced conversions (also puts the sensor to sleep)
+static int8_t bme680_heater_off(bme680_sensor_t* s)
+{
+    struct bme68x_heatr_conf heatr_conf = { 0 };
+
+    heatr_conf.enable = BME68X_DISABLE;
+    heatr_conf.heatr_temp = 300;
+    heatr_conf.heatr_dur = 100;
+    return bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &s->dev);
+}
+
+// TPH configuration of a measurement profile
+static void bme680_meas_conf(uint8_t id, struct bme68x_conf* conf)
+{
+    const bme680_meas_profile_t* profile = &bme680_meas_profiles[id];
+
+    conf->os_temp = profile->os_temp;
+    conf->os_pres = profile->os_pres;
+    conf->os_hum = profile->os_hum;
+    conf->filter = profile->filter;
+    conf->odr = profile->odr;
+}
+
+// Calibration cache key: chip ID (checked), variant and the COEFF3 block
+static int8_t bme680_read_calib_key(bme680_sensor_t* s, bme680_calib_key_t* key)
 {
     int8_t rslt;
-    char debug_msg[128];
-    
-    debug_print("Initializing BME680 sensor...\r\n");
+
+    memset(key, 0, sizeof(*key));
+    key->address = s->health.address;
+    rslt = bme68x_get_regs(BME68X_REG_CHIP_ID, &key->chip_id, 1, &s->dev);
+    if (rslt == BME68X_OK && key->chip_id != BME68X_CHIP_ID) {
+        rslt = BME68X_E_DEV_NOT_FOUND;
+    }
+    if (rslt == BME68X_OK) {
+        rslt = bme68x_get_regs(BME68X_REG_VARIANT_ID, &key->variant_id, 1, &s->dev);
+    }
+    if (rslt == BME68X_OK) {
+        rslt = bme68x_get_regs(BME68X_REG_COEFF3, key->coeff3, BME68X_LEN_COEFF3, &s->dev);
+    }
+    return rslt;
+}
+
+// Reset, chip ID, variant and calibration, like bme68x_init(), but with the
+// coefficients from the flash cache when it was saved for this sensor. On a
+// miss bme68x_init() reads them and they are saved for the next bring-up.
+static int8_t bme680_bring_up(bme680_sensor_t* s)
+{
+    bme680_calib_key_t key;
+    int8_t rslt;
+
+    (void)bme68x_soft_reset(&s->dev);
+    rslt = bme680_read_calib_key(s, &key);
+    if (rslt != BME68X_OK) {
+        return rslt;
+    }
+
+    s->dev.chip_id = key.chip_id;
+    s->dev.variant_id = key.variant_id;
+    if (bme680_calib_load(&key, &s->dev.calib)) {
+        s->health.calib_from_flash = 1;
+        return BME68X_OK;
+    }
+
+    s->health.calib_from_flash = 0;
+    rslt = bme68x_init(&s->dev);
+    if (rslt == BME68X_OK && bme680_calib_save(&key, &s->dev.calib) != 0) {
+        LOG_WARN(BME680, "Calibration not cached, next bring-up reads it again");
+    }
+    return rslt;
+}
+
+// Initialize one sensor: driver, measurement profile, heater off
+static int8_t bme680_sensor_init(bme680_sensor_t* s)
+{
+    uint64_t start_us = timebase_now_us();
+    struct bme68x_conf conf;
+    int8_t rslt;
     
     // Initialize device structure
-    bme680_dev.intf = BME68X_I2C_INTF;
-    bme680_dev.read = bme680_i2c_read;
-    bme680_dev.write = bme680_i2c_write;
-    bme680_dev.delay_us = bme680_delay_us;
-    bme680_dev.intf_ptr = NULL;
-    bme680_dev.amb_temp = 25;
+    s->dev.intf = BME68X_I2C_INTF;
+    s->dev.read = bme680_i2c_read;
+    s->dev.write = bme680_i2c_write;
+    s->dev.delay_us = bme680_delay_us;
+    s->dev.intf_ptr = s;
+    s->dev.amb_temp = 25;
     
     // Initialize the sensor
-    rslt = bme68x_init(&bme680_dev);
-    
-    snprintf(debug_msg, sizeof(debug_msg), "BME68X Init Result: %d\r\n", rslt);
-    debug_print(debug_msg);
+    rslt = bme680_bring_up(s);
+    if (rslt != BME68X_OK) {
+        LOG_ERROR(BME680, "Sensor %u library initialization failed: %d", s->id, rslt);
+        if (s->health.state != BME680_HEALTH_FAILED) {
+            bme680_health_fail(s);
+        }
+        return rslt;
+    }
     
-    if (rslt == BME68X_OK) {
-        debug_print("✓ BME68X library initialization successful\r\n");
-        
-        // Configure sensor settings
-        struct bme68x_conf conf;
-        conf.os_hum = BME68X_OS_1X;
-        conf.os_pres = BME68X_OS_1X;
-        conf.os_temp = BME68X_OS_1X;
-        conf.filter = BME68X_FILTER_OFF;
-        conf.odr = BME68X_ODR_NONE;
-        
-        rslt = bme68x_set_conf(&conf, &bme680_dev);
-        
-        snprintf(debug_msg, sizeof(debug_msg), "BME68X Config Result: %d\r\n", rslt);
-        debug_print(debug_msg);
-        
-        if (rslt == BME68X_OK) {
-            debug_print("✓ BME68X configuration successful\r\n");
-            
-            // Configure gas sensor (optional - for gas resistance measurement)
-            struct bme68x_heatr_conf heatr_conf;
-            heatr_conf.enable = BME68X_DISABLE; // Disable gas sensor for now
-            heatr_conf.heatr_temp = 300;
-            heatr_conf.heatr_dur = 100;
-            
-            rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &bme680_dev);
-            
-            snprintf(debug_msg, sizeof(debug_msg), "BME68X Gas Config Result: %d\r\n", rslt);
-            debug_print(debug_msg);
-            
-            if (rslt == BME68X_OK) {
-                debug_print("✓ BME680 sensor fully initialized\r\n");
-            } else {
-                debug_print("⚠ Gas sensor configuration failed, but sensor is usable\r\n");
-            }
-        } else {
-            debug_print("✗ BME68X configuration failed\r\n");
+    // Configure sensor settings from the measurement profile
+    bme680_meas_conf(bme680_meas_id, &conf);
+    rslt = bme68x_set_conf(&conf, &s->dev);
+    if (rslt != BME68X_OK) {
+        LOG_ERROR(BME680, "Sensor %u configuration failed: %d", s->id, rslt);
+        if (s->health.state != BME680_HEALTH_FAILED) {
+            bme680_health_fail(s);
         }
+        return rslt;
+    }
+    s->conf = conf;
+    s->cache_valid = 0;
+    s->health.init_us = (uint32_t)(timebase_now_us() - start_us);
+    s->health.state = BME680_HEALTH_OK;
+    s->health.consecutive_errors = 0;
+    
+    // Gas heater off until a heater profile is started
+    if (s == bme680_prof_sensor) {
+        bme680_prof.stats.running = 0;
+    }
+    rslt = bme680_heater_off(s);
+    if (rslt != BME68X_OK) {
+        LOG_WARN(BME680, "Sensor %u gas configuration failed (%d), sensor is usable", s->id, rslt);
     } else {
-        debug_print("✗ BME68X library initialization failed\r\n");
+        LOG_INFO(BME680, "Sensor %u initialized at 0x%02X", s->id, s->health.address);
     }
     
     return rslt;
 }
 
+// Initialize every sensor found by bme680_check_sensor_presence(). Returns
+// the first error, BME68X_OK if all came up; failed ones are re-probed in the
+// background.
+int8_t bme680_init_sensor(void)
+{
+    int8_t first = BME68X_OK;
+
+    for (uint8_t i = 0; i < bme680_sensor_slots; i++) {
+        int8_t rslt = bme680_sensor_init(&bme680_sensors[i]);
+
+        if (first == BME68X_OK) {
+            first = rslt;
+        }
+    }
+    return first;
+}
+
+#ifdef BME68X_USE_FPU
 // Manual IEEE 754 decoder for debugging
 float manual_decode_ieee754(uint32_t hex_value) {
     // Extract sign, exponent, and mantissa
@@ -299,222 +468,71 @@ int is_float_invalid(float value) {
     return 0; // Valid
 }
 
-// Read sensor data
+#endif // BME68X_USE_FPU
+
+// Temperature offset correction (adjust BME680_TEMP_OFFSET_CENTI based on your testing)
+static void bme680_apply_temp_offset(struct bme68x_data *data)
+{
+#ifdef BME68X_USE_FPU
+    data->temperature += BME680_TEMP_OFFSET_CENTI / 100.0f;
+#else
+    data->temperature += BME680_TEMP_OFFSET_CENTI;
+#endif
+}
+
+// Read sensor data (blocking forced-mode measurement, kept for the legacy
+// bme680_test_sensor() diagnostic; everything else uses bme680_start_measurement())
 int8_t bme680_read_sensor_data(struct bme68x_data *data)
 {
+    bme680_sensor_t* s = &bme680_sensors[0];
+    bme680_sample_t sample;
     int8_t rslt;
-    uint8_t n_data;
-    char debug_msg[128];
-    
-    debug_print("Reading BME680 sensor data...\r\n");
+    uint8_t n_data = 0;
     
     // Set operation mode to forced mode
-    rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &bme680_dev);
+    rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &s->dev);
+    if (rslt != BME68X_OK) {
+        LOG_ERROR(BME680, "Failed to set forced mode: %d", rslt);
+        return rslt;
+    }
     
-    if (rslt == BME68X_OK) {
-        debug_print("✓ Forced mode set successfully\r\n");
-        
-        // Wait for measurement to complete
-        uint32_t del_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, NULL, &bme680_dev);
-        snprintf(debug_msg, sizeof(debug_msg), "Measurement duration: %lu us\r\n", del_period);
-        debug_print(debug_msg);
-        
-        bme680_dev.delay_us(del_period, bme680_dev.intf_ptr);
-        
-        // Read the data
-        rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, &bme680_dev);
-        
-        snprintf(debug_msg, sizeof(debug_msg), "Data read result: %d, samples: %d\r\n", rslt, n_data);
-        debug_print(debug_msg);
-        
-        if (rslt == BME68X_OK && n_data > 0) {
-            debug_print("✓ Sensor data read successfully\r\n");
-            
-            // Debug: Print raw values with more detail
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Raw values - Temp: %.6f, Press: %.6f, Hum: %.6f\r\n",
-                     data->temperature, data->pressure, data->humidity);
-            debug_print(debug_msg);
-            
-            // Debug: Check if values are zero
-            if (data->temperature == 0.0f && data->pressure == 0.0f && data->humidity == 0.0f) {
-                debug_print("⚠ All sensor values are zero - possible library issue\r\n");
-            }
-            
-            // Debug: Print memory representation and decoded values
-            uint32_t temp_mem = *(uint32_t*)&data->temperature;
-            uint32_t press_mem = *(uint32_t*)&data->pressure;
-            uint32_t hum_mem = *(uint32_t*)&data->humidity;
-            
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Memory dump - Temp: %08lX, Press: %08lX, Hum: %08lX\r\n",
-                     temp_mem, press_mem, hum_mem);
-            debug_print(debug_msg);
-            
-            // Decode and show actual values using both methods
-            float temp_decoded = decode_ieee754(temp_mem);
-            float press_decoded = decode_ieee754(press_mem);
-            float hum_decoded = decode_ieee754(hum_mem);
-            
-            // Manual decoding for comparison
-            float temp_manual = manual_decode_ieee754(temp_mem);
-            float press_manual = manual_decode_ieee754(press_mem);
-            float hum_manual = manual_decode_ieee754(hum_mem);
-            
-            // Debug: Show hex values and decoded values directly
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Hex values - Temp: 0x%08lX, Press: 0x%08lX, Hum: 0x%08lX\r\n",
-                     temp_mem, press_mem, hum_mem);
-            debug_print(debug_msg);
-            
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Decoded values (union) - Temp: %.6f, Press: %.6f, Hum: %.6f\r\n",
-                     temp_decoded, press_decoded, hum_decoded);
-            debug_print(debug_msg);
-            
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Decoded values (manual) - Temp: %.6f, Press: %.6f, Hum: %.6f\r\n",
-                     temp_manual, press_manual, hum_manual);
-            debug_print(debug_msg);
-            
-            // Debug: Show individual components
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Temp breakdown - Hex: 0x%08lX, Decoded: %.6f\r\n",
-                     temp_mem, temp_decoded);
-            debug_print(debug_msg);
-            
-            // Direct IEEE 754 calculation for temperature
-            uint32_t temp_sign = (temp_mem >> 31) & 0x1;
-            uint32_t temp_exp = (temp_mem >> 23) & 0xFF;
-            uint32_t temp_mant = temp_mem & 0x7FFFFF;
-            
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Temp IEEE 754 - Sign: %lu, Exp: %lu, Mant: 0x%06lX\r\n",
-                     temp_sign, temp_exp, temp_mant);
-            debug_print(debug_msg);
-            
-            if (temp_exp != 0 && temp_exp != 0xFF) {
-                int temp_exp_val = (int)temp_exp - 127;
-                float temp_result = 1.0f;
-                
-                // Calculate mantissa (implicit 1.0 + fractional part)
-                for (int i = 22; i >= 0; i--) {
-                    if (temp_mant & (1 << i)) {
-                        temp_result += 1.0f / (1 << (23 - i));
-                    }
-                }
-                
-                // Apply exponent
-                if (temp_exp_val > 0) {
-                    temp_result *= (1 << temp_exp_val);
-                } else if (temp_exp_val < 0) {
-                    temp_result /= (1 << (-temp_exp_val));
-                }
-                
-                // Apply sign
-                if (temp_sign) temp_result = -temp_result;
-                
-                snprintf(debug_msg, sizeof(debug_msg), 
-                         "Temp calculation - Exp_val: %d, Result: %.6f°C\r\n",
-                         temp_exp_val, temp_result);
-                debug_print(debug_msg);
-                
-                // Use this calculated value
-                temp_decoded = temp_result;
-            }
-            
-            // Also calculate pressure and humidity
-            uint32_t press_sign = (press_mem >> 31) & 0x1;
-            uint32_t press_exp = (press_mem >> 23) & 0xFF;
-            uint32_t press_mant = press_mem & 0x7FFFFF;
-            
-            if (press_exp != 0 && press_exp != 0xFF) {
-                int press_exp_val = (int)press_exp - 127;
-                float press_result = 1.0f;
-                
-                for (int i = 22; i >= 0; i--) {
-                    if (press_mant & (1 << i)) {
-                        press_result += 1.0f / (1 << (23 - i));
-                    }
-                }
-                
-                if (press_exp_val > 0) {
-                    press_result *= (1 << press_exp_val);
-                } else if (press_exp_val < 0) {
-                    press_result /= (1 << (-press_exp_val));
-                }
-                
-                if (press_sign) press_result = -press_result;
-                press_decoded = press_result;
-            }
-            
-            uint32_t hum_sign = (hum_mem >> 31) & 0x1;
-            uint32_t hum_exp = (hum_mem >> 23) & 0xFF;
-            uint32_t hum_mant = hum_mem & 0x7FFFFF;
-            
-            if (hum_exp != 0 && hum_exp != 0xFF) {
-                int hum_exp_val = (int)hum_exp - 127;
-                float hum_result = 1.0f;
-                
-                for (int i = 22; i >= 0; i--) {
-                    if (hum_mant & (1 << i)) {
-                        hum_result += 1.0f / (1 << (23 - i));
-                    }
-                }
-                
-                if (hum_exp_val > 0) {
-                    hum_result *= (1 << hum_exp_val);
-                } else if (hum_exp_val < 0) {
-                    hum_result /= (1 << (-hum_exp_val));
-                }
-                
-                if (hum_sign) hum_result = -hum_result;
-                hum_decoded = hum_result;
-            }
-            
-            // Check validity of each value
-            int temp_valid = is_float_invalid(data->temperature);
-            int press_valid = is_float_invalid(data->pressure);
-            int hum_valid = is_float_invalid(data->humidity);
-            
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Validity check - Temp: %s, Press: %s, Hum: %s\r\n",
-                     temp_valid == 0 ? "Valid" : (temp_valid == 1 ? "NaN" : "Inf"),
-                     press_valid == 0 ? "Valid" : (press_valid == 1 ? "NaN" : "Inf"),
-                     hum_valid == 0 ? "Valid" : (hum_valid == 1 ? "NaN" : "Inf"));
-            debug_print(debug_msg);
-            
-            // Check if values are valid (not NaN or infinite)
-            if (is_float_invalid(data->temperature) || is_float_invalid(data->pressure) || is_float_invalid(data->humidity)) {
-                debug_print("✗ Invalid sensor values detected (NaN or infinite)\r\n");
-                return BME68X_E_INVALID_LENGTH;
-            }
-            
-            // Check if values are within reasonable ranges
-            if (data->temperature < -40.0f || data->temperature > 85.0f ||
-                data->pressure < 30000.0f || data->pressure > 125000.0f ||
-                data->humidity < 0.0f || data->humidity > 100.0f) {
-                snprintf(debug_msg, sizeof(debug_msg), 
-                         "⚠ Values out of expected range - Temp: %.2f, Press: %.2f, Hum: %.2f\r\n",
-                         data->temperature, data->pressure, data->humidity);
-                debug_print(debug_msg);
-            }
-            
-            // Apply temperature offset correction if needed
-            // The BME680 might have a factory offset that needs correction
-            float temp_offset = -9.5f; // Adjust this value based on your testing
-            data->temperature += temp_offset;
-            
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Temperature after offset correction: %.2f°C\r\n",
-                     data->temperature);
-            debug_print(debug_msg);
-        } else {
-            debug_print("✗ Failed to read sensor data\r\n");
-        }
-    } else {
-        debug_print("✗ Failed to set forced mode\r\n");
+    // Wait for measurement to complete
+    uint32_t del_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, &s->conf, &s->dev);
+    LOG_DEBUG(BME680, "Measurement duration: %lu us", del_period);
+    s->dev.delay_us(del_period, s->dev.intf_ptr);
+    
+    // Read the data
+    rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, &s->dev);
+    if (rslt != BME68X_OK || n_data == 0) {
+        LOG_ERROR(BME680, "Failed to read sensor data: %d, samples: %u", rslt, n_data);
+        return (rslt != BME68X_OK) ? rslt : BME68X_W_NO_NEW_DATA;
+    }
+    
+#ifdef BME68X_USE_FPU
+    // Raw bit patterns, enough to decode the floats offline if they look wrong
+    LOG_DEBUG(BME680, "Raw values - Temp: 0x%08lX, Press: 0x%08lX, Hum: 0x%08lX",
+              *(uint32_t*)&data->temperature, *(uint32_t*)&data->pressure, *(uint32_t*)&data->humidity);
+    
+    // Check if values are valid (not NaN or infinite)
+    if (is_float_invalid(data->temperature) || is_float_invalid(data->pressure) || is_float_invalid(data->humidity)) {
+        LOG_ERROR(BME680, "Invalid sensor values detected (NaN or infinite)");
+        return BME68X_E_INVALID_LENGTH;
     }
+#endif
+    
+    // Check if values are within reasonable ranges (in fixed units, so the
+    // integer build needs no float compares)
+    bme680_to_sample(data, 0, &sample);
+    if (sample.temperature < -4000 || sample.temperature > 8500 ||
+        sample.pressure < 30000 || sample.pressure > 125000 ||
+        sample.humidity > 10000) {
+        LOG_WARN(BME680, "Values out of expected range - Temp: %d cC, Press: %lu Pa, Hum: %u c%%",
+                 sample.temperature, sample.pressure, sample.humidity);
+    }
+    
+    // Apply temperature offset correction
+    // The BME680 might have a factory offset that needs correction
+    bme680_apply_temp_offset(data);
     
     return rslt;
 }
@@ -522,19 +540,20 @@ int8_t bme680_read_sensor_data(struct bme68x_data *data)
 // Print sensor data
 void bme680_print_sensor_data(struct bme68x_data *data)
 {
+    bme680_sample_t sample;
     char buffer[256];
+    fmt_t line;
     
     // Format and print temperature, pressure, and humidity
-    snprintf(buffer, sizeof(buffer), 
-             "Temperature: %.2f°C, Pressure: %.2f Pa, Humidity: %.2f%%\r\n",
-             data->temperature, data->pressure, data->humidity);
+    bme680_to_sample(data, HAL_GetTick(), &sample);
+    fmt_init(&line, buffer, sizeof(buffer));
+    bme680_format_reading(&line, &sample, ", ");
     
     // Send via both UARTs
-    HAL_UART_Transmit(&huart2, (uint8_t*)buffer, strlen(buffer), HAL_MAX_DELAY);
-    HAL_UART_Transmit(&huart4, (uint8_t*)buffer, strlen(buffer), HAL_MAX_DELAY);
+    command_interface_broadcast(buffer);
 }
 
-// Check BME680 calibration data
+// Check BME680 calibration data (sensor 0, like the other raw diagnostics)
 void bme680_check_calibration_data(void)
 {
     uint8_t calib_data[41];
@@ -543,11 +562,11 @@ void bme680_check_calibration_data(void)
     debug_print("Reading BME680 calibration data...\r\n");
     
     // Read calibration data from registers 0xE1 to 0xF0 and 0x8A to 0xA1
-    HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, BME68X_I2C_ADDR_LOW << 1, 0xE1, 
+    HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, bme680_sensors[0].health.address << 1, 0xE1, 
                                                 I2C_MEMADD_SIZE_8BIT, calib_data, 16, 1000);
     
     if (status == HAL_OK) {
-        status = HAL_I2C_Mem_Read(&hi2c1, BME68X_I2C_ADDR_LOW << 1, 0x8A, 
+        status = HAL_I2C_Mem_Read(&hi2c1, bme680_sensors[0].health.address << 1, 0x8A, 
                                   I2C_MEMADD_SIZE_8BIT, &calib_data[16], 25, 1000);
     }
     
@@ -555,24 +574,24 @@ void bme680_check_calibration_data(void)
         debug_print("✓ Calibration data read successfully\r\n");
         
         // Display some key calibration values
-        snprintf(debug_msg, sizeof(debug_msg), 
-                 "T1: 0x%04X, T2: 0x%04X, T3: 0x%02X\r\n",
-                 (calib_data[1] << 8) | calib_data[0],
-                 (calib_data[3] << 8) | calib_data[2],
-                 calib_data[3]);
+        fmt_format(debug_msg, sizeof(debug_msg), 
+                   "T1: 0x%04X, T2: 0x%04X, T3: 0x%02X\r\n",
+                   (calib_data[1] << 8) | calib_data[0],
+                   (calib_data[3] << 8) | calib_data[2],
+                   calib_data[3]);
         debug_print(debug_msg);
         
-        snprintf(debug_msg, sizeof(debug_msg), 
-                 "P1: 0x%04X, P2: 0x%04X, P3: 0x%02X\r\n",
-                 (calib_data[5] << 8) | calib_data[4],
-                 (calib_data[7] << 8) | calib_data[6],
-                 calib_data[7]);
+        fmt_format(debug_msg, sizeof(debug_msg), 
+                   "P1: 0x%04X, P2: 0x%04X, P3: 0x%02X\r\n",
+                   (calib_data[5] << 8) | calib_data[4],
+                   (calib_data[7] << 8) | calib_data[6],
+                   calib_data[7]);
         debug_print(debug_msg);
         
-        snprintf(debug_msg, sizeof(debug_msg), 
-                 "H1: 0x%02X, H2: 0x%04X\r\n",
-                 calib_data[25],
-                 (calib_data[26] << 8) | calib_data[27]);
+        fmt_format(debug_msg, sizeof(debug_msg), 
+                   "H1: 0x%02X, H2: 0x%04X\r\n",
+                   calib_data[25],
+                   (calib_data[26] << 8) | calib_data[27]);
         debug_print(debug_msg);
     } else {
         debug_print("✗ Failed to read calibration data\r\n");
@@ -591,7 +610,7 @@ void bme680_read_raw_adc_values(void)
     // Temperature: registers 0x22-0x24
     // Pressure: registers 0x1F-0x21  
     // Humidity: registers 0x25-0x26
-    HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, BME68X_I2C_ADDR_LOW << 1, 0x1F, 
+    HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, bme680_sensors[0].health.address << 1, 0x1F, 
                                                 I2C_MEMADD_SIZE_8BIT, raw_data, 8, 1000);
     
     if (status == HAL_OK) {
@@ -600,14 +619,14 @@ void bme680_read_raw_adc_values(void)
         uint32_t raw_press = ((uint32_t)raw_data[0] << 12) | ((uint32_t)raw_data[1] << 4) | ((uint32_t)raw_data[2] >> 4);
         uint16_t raw_hum = ((uint16_t)raw_data[6] << 8) | raw_data[7];
         
-        snprintf(debug_msg, sizeof(debug_msg), 
-                 "Raw ADC values - Temp: %lu, Press: %lu, Hum: %u\r\n",
-                 raw_temp, raw_press, raw_hum);
+        fmt_format(debug_msg, sizeof(debug_msg), 
+                   "Raw ADC values - Temp: %lu, Press: %lu, Hum: %u\r\n",
+                   raw_temp, raw_press, raw_hum);
         debug_print(debug_msg);
         
         // Also read the calibration data to understand the conversion
         uint8_t calib_temp[3];
-        status = HAL_I2C_Mem_Read(&hi2c1, BME68X_I2C_ADDR_LOW << 1, 0xE1, 
+        status = HAL_I2C_Mem_Read(&hi2c1, bme680_sensors[0].health.address << 1, 0xE1, 
                                   I2C_MEMADD_SIZE_8BIT, calib_temp, 3, 1000);
         
         if (status == HAL_OK) {
@@ -615,9 +634,9 @@ void bme680_read_raw_adc_values(void)
             int16_t T2 = (int16_t)((calib_temp[3] << 8) | calib_temp[2]);
             int8_t T3 = (int8_t)calib_temp[4];
             
-            snprintf(debug_msg, sizeof(debug_msg), 
-                     "Temp calibration - T1: %u, T2: %d, T3: %d\r\n",
-                     T1, T2, T3);
+            fmt_format(debug_msg, sizeof(debug_msg), 
+                       "Temp calibration - T1: %u, T2: %d, T3: %d\r\n",
+                       T1, T2, T3);
             debug_print(debug_msg);
         }
     } else {
@@ -634,28 +653,28 @@ void bme680_read_raw_registers(void)
     debug_print("Reading raw BME680 registers...\r\n");
     
     // Read temperature, pressure, and humidity registers (0x22-0x26)
-    HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, BME68X_I2C_ADDR_LOW << 1, 0x22, 
+    HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, bme680_sensors[0].health.address << 1, 0x22, 
                                                 I2C_MEMADD_SIZE_8BIT, raw_data, 8, 1000);
     
     if (status == HAL_OK) {
-        snprintf(debug_msg, sizeof(debug_msg), 
-                 "Raw registers: 0x22=0x%02X, 0x23=0x%02X, 0x24=0x%02X, 0x25=0x%02X, 0x26=0x%02X\r\n",
-                 raw_data[0], raw_data[1], raw_data[2], raw_data[3], raw_data[4]);
+        fmt_format(debug_msg, sizeof(debug_msg), 
+                   "Raw registers: 0x22=0x%02X, 0x23=0x%02X, 0x24=0x%02X, 0x25=0x%02X, 0x26=0x%02X\r\n",
+                   raw_data[0], raw_data[1], raw_data[2], raw_data[3], raw_data[4]);
         debug_print(debug_msg);
         
         // Calculate raw temperature (24-bit value)
         uint32_t temp_raw = ((uint32_t)raw_data[0] << 12) | ((uint32_t)raw_data[1] << 4) | ((uint32_t)raw_data[2] >> 4);
-        snprintf(debug_msg, sizeof(debug_msg), "Raw temperature value: 0x%06lX (%lu)\r\n", temp_raw, temp_raw);
+        fmt_format(debug_msg, sizeof(debug_msg), "Raw temperature value: 0x%06lX (%lu)\r\n", temp_raw, temp_raw);
         debug_print(debug_msg);
         
         // Calculate raw pressure (24-bit value)
         uint32_t press_raw = ((uint32_t)raw_data[3] << 12) | ((uint32_t)raw_data[4] << 4) | ((uint32_t)raw_data[5] >> 4);
-        snprintf(debug_msg, sizeof(debug_msg), "Raw pressure value: 0x%06lX (%lu)\r\n", press_raw, press_raw);
+        fmt_format(debug_msg, sizeof(debug_msg), "Raw pressure value: 0x%06lX (%lu)\r\n", press_raw, press_raw);
         debug_print(debug_msg);
         
         // Calculate raw humidity (16-bit value)
         uint16_t hum_raw = ((uint16_t)raw_data[6] << 8) | raw_data[7];
-        snprintf(debug_msg, sizeof(debug_msg), "Raw humidity value: 0x%04X (%u)\r\n", hum_raw, hum_raw);
+        fmt_format(debug_msg, sizeof(debug_msg), "Raw humidity value: 0x%04X (%u)\r\n", hum_raw, hum_raw);
         debug_print(debug_msg);
     } else {
         debug_print("Failed to read raw registers\r\n");
@@ -666,82 +685,1072 @@ void bme680_read_raw_registers(void)
 void bme680_test_sensor(void)
 {
     struct bme68x_data sensor_data;
+    bme680_sample_t sample;
     char test_msg[256];
+    fmt_t line;
     
     debug_print("Testing BME680 sensor...\r\n");
     
     if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        // Decode all sensor values
-        uint32_t temp_mem = *(uint32_t*)&sensor_data.temperature;
-        uint32_t press_mem = *(uint32_t*)&sensor_data.pressure;
-        uint32_t hum_mem = *(uint32_t*)&sensor_data.humidity;
-        
-        float temp_decoded = 0.0f, press_decoded = 0.0f, hum_decoded = 0.0f;
-        
-        // Decode temperature
-        uint32_t temp_sign = (temp_mem >> 31) & 0x1;
-        uint32_t temp_exp = (temp_mem >> 23) & 0xFF;
-        uint32_t temp_mant = temp_mem & 0x7FFFFF;
-        
-        if (temp_exp != 0 && temp_exp != 0xFF) {
-            int temp_exp_val = (int)temp_exp - 127;
-            float temp_result = 1.0f;
-            for (int i = 22; i >= 0; i--) {
-                if (temp_mant & (1 << i)) {
-                    temp_result += 1.0f / (1 << (23 - i));
-                }
-            }
-            if (temp_exp_val > 0) temp_result *= (1 << temp_exp_val);
-            else if (temp_exp_val < 0) temp_result /= (1 << (-temp_exp_val));
-            if (temp_sign) temp_result = -temp_result;
-            temp_decoded = temp_result;
-        }
-        
-        // Decode pressure
-        uint32_t press_sign = (press_mem >> 31) & 0x1;
-        uint32_t press_exp = (press_mem >> 23) & 0xFF;
-        uint32_t press_mant = press_mem & 0x7FFFFF;
-        
-        if (press_exp != 0 && press_exp != 0xFF) {
-            int press_exp_val = (int)press_exp - 127;
-            float press_result = 1.0f;
-            for (int i = 22; i >= 0; i--) {
-                if (press_mant & (1 << i)) {
-                    press_result += 1.0f / (1 << (23 - i));
-                }
-            }
-            if (press_exp_val > 0) press_result *= (1 << press_exp_val);
-            else if (press_exp_val < 0) press_result /= (1 << (-press_exp_val));
-            if (press_sign) press_result = -press_result;
-            press_decoded = press_result;
-        }
-        
-        // Decode humidity
-        uint32_t hum_sign = (hum_mem >> 31) & 0x1;
-        uint32_t hum_exp = (hum_mem >> 23) & 0xFF;
-        uint32_t hum_mant = hum_mem & 0x7FFFFF;
-        
-        if (hum_exp != 0 && hum_exp != 0xFF) {
-            int hum_exp_val = (int)hum_exp - 127;
-            float hum_result = 1.0f;
-            for (int i = 22; i >= 0; i--) {
-                if (hum_mant & (1 << i)) {
-                    hum_result += 1.0f / (1 << (23 - i));
-                }
-            }
-            if (hum_exp_val > 0) hum_result *= (1 << hum_exp_val);
-            else if (hum_exp_val < 0) hum_result /= (1 << (-hum_exp_val));
-            if (hum_sign) hum_result = -hum_result;
-            hum_decoded = hum_result;
-        }
-        
-        snprintf(test_msg, sizeof(test_msg), 
-                 "Test successful!\r\nTemperature: %.2f°C\r\nPressure: %.2f Pa\r\nHumidity: %.2f%%\r\n",
-                 temp_decoded, press_decoded, hum_decoded);
+        bme680_to_sample(&sensor_data, HAL_GetTick(), &sample);
+        fmt_init(&line, test_msg, sizeof(test_msg));
+        fmt_str(&line, "Test successful!\r\n");
+        bme680_format_reading(&line, &sample, "\r\n");
     } else {
-        snprintf(test_msg, sizeof(test_msg), "Test failed! Error reading sensor data.\r\n");
+        fmt_format(test_msg, sizeof(test_msg), "Test failed! Error reading sensor data.\r\n");
     }
     
-    HAL_UART_Transmit(&huart2, (uint8_t*)test_msg, strlen(test_msg), HAL_MAX_DELAY);
-    HAL_UART_Transmit(&huart4, (uint8_t*)test_msg, strlen(test_msg), HAL_MAX_DELAY);
-} 
\ No newline at end of file
+    command_interface_broadcast(test_msg);
+}
+
+// Sensor by id, NULL if there is no such sensor
+static bme680_sensor_t* bme680_sensor(uint8_t id)
+{
+    return (id < bme680_sensor_slots) ? &bme680_sensors[id] : NULL;
+}
+
+// The heater profile owns this sensor's conversions
+static uint8_t bme680_profile_owns(const bme680_sensor_t* s)
+{
+    return s == bme680_prof_sensor && bme680_prof.stats.running;
+}
+
+// Start a forced conversion and release the sensor task when it should be done
+static int8_t bme680_trigger(bme680_sensor_t* s)
+{
+    uint32_t duration_us;
+    int8_t rslt;
+
+    rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &s->dev);
+    if (rslt != BME68X_OK) {
+        LOG_ERROR(BME680, "Sensor %u failed to set forced mode: %d", s->id, rslt);
+        return rslt;
+    }
+
+    duration_us = bme68x_get_meas_dur(BME68X_FORCED_MODE, &s->conf, &s->dev);
+    LOG_DEBUG(BME680, "Sensor %u measurement duration: %lu us", s->id, duration_us);
+    s->meas.running = 1;
+    s->meas.start_tick = HAL_GetTick();
+    s->meas.due_tick = s->meas.start_tick + (duration_us + 999) / 1000;
+    s->meas.timeout_tick = s->meas.due_tick + BME680_MEAS_TIMEOUT_MS;
+    bme680_wake_at(s->meas.due_tick);
+    return BME68X_OK;
+}
+
+// Start a forced-mode measurement on a sensor and return at once; done(arg)
+// is called from the sensor task with the result. Returns BME68X_OK if done
+// will be called, otherwise an error and done is not called. While a heater
+// profile runs on the sensor, done gets its next field instead. Conversions
+// on different sensors run at the same time.
+int8_t bme680_start_measurement(uint8_t sensor, bme680_callback_t done, void* arg)
+{
+    bme680_sensor_t* s = bme680_sensor(sensor);
+    int8_t rslt;
+
+    // Known bad: fail without touching the bus until a re-probe succeeds
+    if (s == NULL || s->health.state != BME680_HEALTH_OK) {
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+    if (s->meas.waiter_count >= BME680_MAX_WAITERS) {
+        return BME680_E_BUSY;
+    }
+
+    if (!s->meas.running && !bme680_profile_owns(s)) {
+        rslt = bme680_trigger(s);
+        if (rslt != BME68X_OK) {
+            return rslt;
+        }
+    }
+
+    s->meas.waiters[s->meas.waiter_count].done = done;
+    s->meas.waiters[s->meas.waiter_count].arg = arg;
+    s->meas.waiter_count++;
+    return BME68X_OK;
+}
+
+// Latest sample of a sensor if it is no older than max_age_ms (age counted
+// from the start of its conversion), otherwise start a conversion (or join
+// the one running) and call done when it ends. Returns BME68X_OK with sample
+// filled, BME680_W_PENDING if done will be called, or an error.
+int8_t bme680_get_sample(uint8_t sensor, uint32_t max_age_ms, bme680_sample_t* sample,
+                         bme680_callback_t done, void* arg)
+{
+    bme680_sensor_t* s = bme680_sensor(sensor);
+    int8_t rslt;
+
+    if (s != NULL && s->cache_valid && HAL_GetTick() - s->cache.timestamp <= max_age_ms) {
+        *sample = s->cache;
+        return BME68X_OK;
+    }
+
+    rslt = bme680_start_measurement(sensor, done, arg);
+    return (rslt == BME68X_OK) ? BME680_W_PENDING : rslt;
+}
+
+// Sensors found (at least 1: sensor 0 exists even when nothing answered)
+uint8_t bme680_sensor_count(void)
+{
+    return bme680_sensor_slots;
+}
+
+// The sensor answered its last probe and recent transfers
+uint8_t bme680_is_available(uint8_t sensor)
+{
+    bme680_sensor_t* s = bme680_sensor(sensor);
+
+    return s != NULL && s->health.state == BME680_HEALTH_OK;
+}
+
+// Health of a sensor, returns -1 if there is no such sensor
+int8_t bme680_get_health(uint8_t sensor, bme680_health_t* health)
+{
+    bme680_sensor_t* s = bme680_sensor(sensor);
+
+    if (s == NULL) {
+        return -1;
+    }
+    *health = s->health;
+    return 0;
+}
+
+// Background re-probe of a failed sensor at its address (both addresses
+// while nothing was ever found); on success it is initialized again,
+// otherwise the next probe is scheduled twice as far out
+static void bme680_health_probe(bme680_sensor_t* s, uint32_t now)
+{
+    uint8_t discovered = bme680_discovered;
+    int8_t rslt;
+
+    s->health.probes++;
+    rslt = discovered ? bme680_probe_address(s->health.address) : bme680_check_sensor_presence();
+    if (rslt == BME68X_OK && bme680_sensor_init(s) == BME68X_OK) {
+        LOG_INFO(BME680, "Sensor %u back after %lu probes", s->id, s->health.probes);
+
+        // First discovery may have found a second sensor as well
+        for (uint8_t i = 1; !discovered && i < bme680_sensor_slots; i++) {
+            (void)bme680_sensor_init(&bme680_sensors[i]);
+        }
+        return;
+    }
+
+    s->health.state = BME680_HEALTH_FAILED;
+    s->health.backoff_ms *= 2;
+    if (s->health.backoff_ms > BME680_PROBE_MAX_MS) {
+        s->health.backoff_ms = BME680_PROBE_MAX_MS;
+    }
+    s->health.next_probe = now + s->health.backoff_ms;
+    bme680_wake_at(s->health.next_probe);
+}
+
+// A conversion is in progress on the sensor
+uint8_t bme680_measurement_busy(uint8_t sensor)
+{
+    bme680_sensor_t* s = bme680_sensor(sensor);
+
+    return s != NULL && s->meas.running;
+}
+
+// Hand the result to every waiter of a sensor. The state is cleared first so
+// a callback may start the next measurement.
+static void bme680_complete(bme680_sensor_t* s, int8_t rslt, const bme680_sample_t* sample)
+{
+    bme680_waiter_t waiters[BME680_MAX_WAITERS];
+    uint8_t count = s->meas.waiter_count;
+
+    memcpy(waiters, s->meas.waiters, sizeof(waiters));
+    s->meas.running = 0;
+    s->meas.waiter_count = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        waiters[i].done(rslt, sample, waiters[i].arg);
+    }
+}
+
+// Gas heater profiles
+
+// Run the profile state machine at tick
+static void bme680_profile_wake(uint32_t tick)
+{
+    bme680_prof.next_tick = tick;
+    bme680_wake_at(tick);
+}
+
+// Take one field of the profile: it becomes the latest sample and goes to
+// every waiting request
+static void bme680_profile_take(const bme680_sample_t* sample)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+
+    bme680_prof.stats.fields++;
+    bme680_prof.stats.step = sample->gas_step;
+    if ((sample->status & (BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK)) ==
+        (BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK)) {
+        bme680_prof.stats.gas_valid++;
+    }
+
+    s->cache = *sample;
+    s->cache_valid = 1;
+    if (s->meas.waiter_count != 0) {
+        bme680_complete(s, BME68X_OK, sample);
+    }
+}
+
+// A profile read failed: waiting requests get the error, and a sensor marked
+// failed ends the profile (the re-probe initializes it again)
+static void bme680_profile_error(int8_t rslt)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    bme680_sample_t sample;
+
+    LOG_ERROR(BME680, "Profile read failed: %d", rslt);
+    bme680_prof.stats.errors++;
+    if (s->health.state != BME680_HEALTH_OK) {
+        bme680_prof.stats.running = 0;
+    }
+    if (s->meas.waiter_count != 0) {
+        memset(&sample, 0, sizeof(sample));
+        bme680_complete(s, rslt, &sample);
+    }
+}
+
+// Forced-mode profile: heat for the current step and start its conversion
+static int8_t bme680_profile_forced_step(uint32_t now)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    struct bme68x_heatr_conf heatr_conf = { 0 };
+    uint8_t step = bme680_prof.stats.step;
+    uint32_t duration_ms;
+    int8_t rslt;
+
+    heatr_conf.enable = BME68X_ENABLE;
+    heatr_conf.heatr_temp = bme680_prof.profile.temp_c[step];
+    heatr_conf.heatr_dur = bme680_prof.profile.dur_ms[step];
+    rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &s->dev);
+    if (rslt == BME68X_OK) {
+        rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &s->dev);
+    }
+    if (rslt != BME68X_OK) {
+        return rslt;
+    }
+
+    duration_ms = (bme68x_get_meas_dur(BME68X_FORCED_MODE, &s->conf, &s->dev) + 999) / 1000 +
+                  heatr_conf.heatr_dur;
+    bme680_prof.step_pending = 1;
+    bme680_prof.step_start = now;
+    bme680_prof.step_timeout = now + duration_ms + BME680_MEAS_TIMEOUT_MS;
+    bme680_profile_wake(now + duration_ms);
+    return BME68X_OK;
+}
+
+// Sequential/parallel profile: load every step into the heater registers and
+// let the sensor cycle through them on its own. Reads come every two fields
+// of the shortest step, so the three-field FIFO never overflows.
+static int8_t bme680_profile_continuous_start(uint32_t now)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    struct bme68x_heatr_conf heatr_conf = { 0 };
+    bme680_profile_t* profile = &bme680_prof.profile;
+    uint32_t meas_ms = (bme68x_get_meas_dur(profile->mode, &s->conf, &s->dev) + 999) / 1000;
+    uint32_t field_ms;
+    uint32_t min_ms = 0;
+    int8_t rslt;
+
+    for (uint8_t i = 0; i < profile->steps; i++) {
+        if (profile->mode == BME68X_PARALLEL_MODE) {
+            // Multiples of the shared cycle time
+            bme680_prof.reg_dur[i] = profile->dur_ms[i] / BME680_PARALLEL_CYCLE_MS;
+            if (bme680_prof.reg_dur[i] == 0) {
+                bme680_prof.reg_dur[i] = 1;
+            }
+            field_ms = bme680_prof.reg_dur[i] * BME680_PARALLEL_CYCLE_MS;
+        } else {
+            bme680_prof.reg_dur[i] = profile->dur_ms[i];
+            field_ms = meas_ms + profile->dur_ms[i] + bme680_odr_ms[s->conf.odr];
+        }
+        if (min_ms == 0 || field_ms < min_ms) {
+            min_ms = field_ms;
+        }
+    }
+
+    heatr_conf.enable = BME68X_ENABLE;
+    heatr_conf.heatr_temp_prof = profile->temp_c;
+    heatr_conf.heatr_dur_prof = bme680_prof.reg_dur;
+    heatr_conf.profile_len = profile->steps;
+    heatr_conf.shared_heatr_dur = (uint16_t)(BME680_PARALLEL_CYCLE_MS - meas_ms);
+    rslt = bme68x_set_heatr_conf(profile->mode, &heatr_conf, &s->dev);
+    if (rslt == BME68X_OK) {
+        rslt = bme68x_set_op_mode(profile->mode, &s->dev);
+    }
+    if (rslt != BME68X_OK) {
+        return rslt;
+    }
+
+    bme680_prof.poll_ms = (uint16_t)(2 * min_ms);
+    bme680_profile_wake(now + bme680_prof.poll_ms);
+    return BME68X_OK;
+}
+
+// Sequential/parallel profile: one burst read of the three fields, every
+// field not taken before becomes a sample
+static void bme680_profile_harvest(uint32_t now)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    struct bme68x_data data[3];
+    bme680_sample_t sample;
+    uint8_t n_data = 0;
+    int8_t rslt;
+
+    rslt = bme68x_get_data(bme680_prof.profile.mode, data, &n_data, &s->dev);
+    bme680_prof.stats.reads++;
+    if (rslt != BME68X_OK && rslt != BME68X_W_NO_NEW_DATA) {
+        bme680_profile_error(rslt);
+    }
+
+    // New fields come first, oldest first
+    for (uint8_t i = 0; i < n_data && rslt == BME68X_OK; i++) {
+        if (bme680_prof.have_index) {
+            if (data[i].meas_index == bme680_prof.last_index) {
+                continue;   // Still flagged new from the previous read
+            }
+            bme680_prof.stats.lost += (uint8_t)(data[i].meas_index - bme680_prof.last_index - 1);
+        }
+        bme680_prof.last_index = data[i].meas_index;
+        bme680_prof.have_index = 1;
+
+        bme680_apply_temp_offset(&data[i]);
+        bme680_to_sample(&data[i], now, &sample);
+        bme680_profile_take(&sample);
+    }
+
+    if (bme680_prof.stats.running) {
+        bme680_profile_wake(now + bme680_prof.poll_ms);
+    }
+}
+
+// Forced-mode profile: fetch the step's conversion, then heat for the next
+// step. A step that could not be started is retried a second later.
+static void bme680_profile_forced(uint32_t now)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    struct bme68x_data data;
+    bme680_sample_t sample;
+    int8_t rslt;
+
+    if (bme680_prof.step_pending) {
+        rslt = bme680_fetch_measurement(s->id, &data);
+        bme680_prof.stats.reads++;
+        if (rslt == BME68X_W_NO_NEW_DATA) {
+            if ((int32_t)(now - bme680_prof.step_timeout) < 0) {
+                bme680_profile_wake(now + BME680_POLL_MS);
+                return;
+            }
+            rslt = BME680_E_TIMEOUT;
+        }
+        bme680_prof.step_pending = 0;
+
+        if (rslt == BME68X_OK) {
+            bme680_to_sample(&data, bme680_prof.step_start, &sample);
+            sample.gas_step = bme680_prof.stats.step;   // Forced mode always uses heater set 0
+            bme680_profile_take(&sample);
+        } else {
+            bme680_profile_error(rslt);
+            if (!bme680_prof.stats.running) {
+                return;
+            }
+        }
+        bme680_prof.stats.step = (uint8_t)((bme680_prof.stats.step + 1) % bme680_prof.profile.steps);
+    }
+
+    rslt = bme680_profile_forced_step(now);
+    if (rslt != BME68X_OK) {
+        bme680_profile_error(rslt);
+        if (bme680_prof.stats.running) {
+            bme680_profile_wake(now + BME680_PROBE_MIN_MS);
+        }
+    }
+}
+
+static void bme680_profile_task(uint32_t now)
+{
+    if (bme680_prof.profile.mode == BME68X_FORCED_MODE) {
+        bme680_profile_forced(now);
+    } else {
+        bme680_profile_harvest(now);
+    }
+}
+
+// Start a heater profile, replacing any running one. Returns BME68X_OK,
+// BME680_E_PROFILE for a bad profile (sequential and parallel modes need a
+// BME688), BME680_E_BUSY while a single conversion runs, or a driver error.
+int8_t bme680_profile_start(const bme680_profile_t* profile)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    uint32_t now = HAL_GetTick();
+    int8_t rslt;
+
+    if (s->health.state != BME680_HEALTH_OK) {
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+    if (s->meas.running) {
+        return BME680_E_BUSY;
+    }
+    if (profile->steps == 0 || profile->steps > BME680_PROFILE_MAX_STEPS) {
+        return BME680_E_PROFILE;
+    }
+    if (profile->mode != BME68X_FORCED_MODE &&
+        ((profile->mode != BME68X_SEQUENTIAL_MODE && profile->mode != BME68X_PARALLEL_MODE) ||
+         s->dev.variant_id != BME68X_VARIANT_GAS_HIGH)) {
+        return BME680_E_PROFILE;
+    }
+    for (uint8_t i = 0; i < profile->steps; i++) {
+        if (profile->temp_c[i] < BME680_HEATER_MIN_C || profile->temp_c[i] > BME680_HEATER_MAX_C ||
+            profile->dur_ms[i] == 0 || profile->dur_ms[i] > BME680_HEATER_MAX_MS) {
+            return BME680_E_PROFILE;
+        }
+    }
+
+    memset(&bme680_prof, 0, sizeof(bme680_prof));
+    bme680_prof.profile = *profile;
+    rslt = (profile->mode == BME68X_FORCED_MODE) ? bme680_profile_forced_step(now)
+                                                  : bme680_profile_continuous_start(now);
+    if (rslt != BME68X_OK) {
+        bme680_sample_t sample;
+
+        // Requests that waited for the replaced profile are not served by this one
+        LOG_ERROR(BME680, "Heater profile start failed: %d", rslt);
+        (void)bme680_heater_off(s);
+        if (s->meas.waiter_count != 0) {
+            memset(&sample, 0, sizeof(sample));
+            bme680_complete(s, rslt, &sample);
+        }
+        return rslt;
+    }
+
+    bme680_prof.stats.running = 1;
+    LOG_INFO(BME680, "Heater profile started: %u steps, mode %u", profile->steps, profile->mode);
+    return BME68X_OK;
+}
+
+// Stop the heater profile. Requests still waiting for a field get a forced
+// conversion of their own.
+void bme680_profile_stop(void)
+{
+    bme680_sensor_t* s = bme680_prof_sensor;
+    bme680_sample_t sample;
+    int8_t rslt;
+
+    if (!bme680_prof.stats.running) {
+        return;
+    }
+    bme680_prof.stats.running = 0;
+
+    rslt = bme680_heater_off(s);
+    if (rslt == BME68X_OK && s->meas.waiter_count != 0) {
+        rslt = bme680_trigger(s);
+    }
+    if (rslt != BME68X_OK && s->meas.waiter_count != 0) {
+        memset(&sample, 0, sizeof(sample));
+        bme680_complete(s, rslt, &sample);
+    }
+    LOG_INFO(BME680, "Heater profile stopped after %lu fields", bme680_prof.stats.fields);
+}
+
+void bme680_get_profile(bme680_profile_t* profile, bme680_profile_stats_t* stats)
+{
+    if (profile != NULL) {
+        *profile = bme680_prof.profile;
+    }
+    if (stats != NULL) {
+        *stats = bme680_prof.stats;
+    }
+}
+
+// Switch the measurement profile of every sensor. Returns BME68X_OK,
+// BME680_E_PROFILE for a bad id, BME680_E_BUSY while a conversion or heater
+// profile runs, or a driver error (sensors switched before it keep the new
+// profile, the profile id stays). Failed sensors take the profile when a
+// re-probe brings them back.
+int8_t bme680_set_meas_profile(uint8_t id)
+{
+    struct bme68x_conf conf;
+    int8_t rslt;
+
+    if (id >= BME680_MEAS_PROFILE_COUNT) {
+        return BME680_E_PROFILE;
+    }
+    if (bme680_prof.stats.running) {
+        return BME680_E_BUSY;
+    }
+    for (uint8_t i = 0; i < bme680_sensor_slots; i++) {
+        if (bme680_sensors[i].meas.running) {
+            return BME680_E_BUSY;
+        }
+    }
+
+    bme680_meas_conf(id, &conf);
+    for (uint8_t i = 0; i < bme680_sensor_slots; i++) {
+        bme680_sensor_t* s = &bme680_sensors[i];
+
+        if (s->health.state != BME680_HEALTH_OK) {
+            continue;
+        }
+        rslt = bme68x_set_conf(&conf, &s->dev);
+        if (rslt != BME68X_OK) {
+            LOG_ERROR(BME680, "Sensor %u measurement profile %u failed: %d", s->id, id, rslt);
+            return rslt;
+        }
+
+        // Earlier samples had other noise and filter settling
+        s->conf = conf;
+        s->cache_valid = 0;
+    }
+    bme680_meas_id = id;
+    LOG_INFO(BME680, "Measurement profile %u, conversion %lu us", id, bme680_meas_duration_us(id));
+    return BME68X_OK;
+}
+
+uint8_t bme680_get_meas_profile(void)
+{
+    return bme680_meas_id;
+}
+
+// Settings of a measurement profile, NULL for a bad id
+const bme680_meas_profile_t* bme680_meas_profile_info(uint8_t id)
+{
+    return (id < BME680_MEAS_PROFILE_COUNT) ? &bme680_meas_profiles[id] : NULL;
+}
+
+// Forced conversion time of a measurement profile (heater off)
+uint32_t bme680_meas_duration_us(uint8_t id)
+{
+    struct bme68x_conf conf;
+
+    if (id >= BME680_MEAS_PROFILE_COUNT) {
+        return 0;
+    }
+    bme680_meas_conf(id, &conf);
+    return bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &bme680_sensors[0].dev);
+}
+
+// Supply charge of one forced conversion in nC (heater off): each channel's
+// oversampling cycles at its conversion current, the rest of the conversion
+// time at the temperature current. At one sample per second the charge in nC
+// is the average current in nA, on top of the sleep current.
+uint32_t bme680_meas_charge_nc(uint8_t id)
+{
+    static const uint8_t os_cycles[] = { 0, 1, 2, 4, 8, 16 };
+    const bme680_meas_profile_t* profile = bme680_meas_profile_info(id);
+    uint32_t cycles;
+    uint32_t charge;
+
+    if (profile == NULL) {
+        return 0;
+    }
+
+    // us x uA = pC
+    cycles = os_cycles[profile->os_temp] + os_cycles[profile->os_pres] + os_cycles[profile->os_hum];
+    charge = BME680_OS_CYCLE_US * (os_cycles[profile->os_temp] * BME680_IDD_TEMP_UA +
+                                   os_cycles[profile->os_pres] * BME680_IDD_PRES_UA +
+                                   os_cycles[profile->os_hum] * BME680_IDD_HUM_UA);
+    charge += (bme680_meas_duration_us(id) - cycles * BME680_OS_CYCLE_US) * BME680_IDD_TEMP_UA;
+    return (charge + 500) / 1000;
+}
+
+// Service one sensor: fetch its conversion once it should be done, then poll
+// the new_data bit every BME680_POLL_MS until the timeout. A failed sensor is
+// re-probed, and sensor 0 runs the heater profile while one is started.
+// Anything not due yet asks for a later task run.
+static void bme680_service(bme680_sensor_t* s, uint32_t now)
+{
+    struct bme68x_data data;
+    bme680_sample_t sample;
+    int8_t rslt;
+
+    if (s->health.state == BME680_HEALTH_FAILED && !s->meas.running) {
+        if ((int32_t)(now - s->health.next_probe) >= 0) {
+            bme680_health_probe(s, now);
+        } else {
+            bme680_wake_at(s->health.next_probe);
+        }
+        return;
+    }
+    if (bme680_profile_owns(s)) {
+        if ((int32_t)(now - bme680_prof.next_tick) >= 0) {
+            bme680_profile_task(now);
+        } else {
+            bme680_wake_at(bme680_prof.next_tick);
+        }
+        return;
+    }
+    if (!s->meas.running) {
+        return;
+    }
+    if ((int32_t)(now - s->meas.due_tick) < 0) {
+        bme680_wake_at(s->meas.due_tick);
+        return;
+    }
+
+    rslt = bme680_fetch_measurement(s->id, &data);
+    if (rslt == BME68X_W_NO_NEW_DATA) {
+        if ((int32_t)(now - s->meas.timeout_tick) < 0) {
+            s->meas.due_tick = now + BME680_POLL_MS;
+            bme680_wake_at(s->meas.due_tick);
+            return;
+        }
+        LOG_ERROR(BME680, "Sensor %u measurement timed out after %lu ms", s->id, now - s->meas.start_tick);
+        rslt = BME680_E_TIMEOUT;
+    } else if (rslt != BME68X_OK) {
+        LOG_ERROR(BME680, "Sensor %u failed to read data: %d", s->id, rslt);
+    }
+
+    if (rslt == BME68X_OK) {
+        bme680_to_sample(&data, s->meas.start_tick, &sample);
+        sample.sensor_id = s->id;
+        s->cache = sample;
+        s->cache_valid = 1;
+    } else {
+        memset(&sample, 0, sizeof(sample));
+        sample.sensor_id = s->id;
+    }
+    bme680_complete(s, rslt, &sample);
+}
+
+// Sensor task: released at the earliest tick any sensor asked for, it walks
+// all sensors and re-arms the release for those still waiting. The walk
+// starts one sensor further on every run, so when several conversions end
+// together each sensor's callbacks get to run first in turn.
+static void bme680_task(uint32_t events)
+{
+    uint32_t now = HAL_GetTick();
+    uint8_t slots = bme680_sensor_slots;
+    uint8_t first = bme680_first_sensor;
+
+    bme680_wake_armed = 0;
+    bme680_first_sensor = (uint8_t)((first + 1) % slots);
+    for (uint8_t n = 0; n < slots; n++) {
+        bme680_service(&bme680_sensors[(first + n) % slots], now);
+    }
+}
+
+static const sched_task_def_t bme680_task_def = {
+    .name = "bme680", .run = bme680_task, .period_ms = 0, .deadline_ms = 0, .priority = 0
+};
+
+// Run the measurement state machine from the scheduler
+int8_t bme680_register_task(void)
+{
+    bme680_task_id = sched_add_task(&bme680_task_def);
+    if (bme680_task_id < 0) {
+        return -1;
+    }
+
+    // Wakes asked for before the task existed went nowhere; sensors not
+    // found at boot start their background re-probes
+    bme680_wake_armed = 0;
+    for (uint8_t i = 0; i < bme680_sensor_slots; i++) {
+        bme680_sensor_t* s = &bme680_sensors[i];
+
+        if (s->health.state == BME680_HEALTH_UNKNOWN) {
+            bme680_health_fail(s);
+        } else if (s->health.state == BME680_HEALTH_FAILED) {
+            bme680_wake_at(s->health.next_probe);
+        }
+    }
+    return 0;
+}
+
+// Read the result of a finished forced-mode measurement on a sensor
+int8_t bme680_fetch_measurement(uint8_t sensor, struct bme68x_data* data)
+{
+    bme680_sensor_t* s = bme680_sensor(sensor);
+    uint8_t n_data = 0;
+    int8_t rslt;
+
+    if (s == NULL) {
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+    rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, &s->dev);
+
+    if (rslt == BME68X_OK && n_data == 0) {
+        rslt = BME68X_W_NO_NEW_DATA;
+    }
+    if (rslt == BME68X_OK) {
+        bme680_apply_temp_offset(data);
+    }
+    return rslt;
+}
+
+// Convert a driver result to fixed units
+void bme680_to_sample(const struct bme68x_data* data, uint32_t timestamp, bme680_sample_t* sample)
+{
+    sample->timestamp = timestamp;
+    sample->sensor_id = 0;      // Callers converting for another sensor set it
+    sample->status = data->status;
+    sample->gas_step = data->gas_index;
+#ifdef BME68X_USE_FPU
+    sample->temperature = (int16_t)(data->temperature * 100.0f + ((data->temperature < 0) ? -0.5f : 0.5f));
+    sample->pressure = (uint32_t)(data->pressure + 0.5f);
+    sample->humidity = (uint16_t)(data->humidity * 100.0f + 0.5f);
+    sample->gas_resistance = (uint32_t)(data->gas_resistance + 0.5f);
+#else
+    sample->temperature = data->temperature;                     // Already 0.01 degC
+    sample->pressure = data->pressure;
+    sample->humidity = (uint16_t)((data->humidity + 5) / 10);    // 0.001 %RH to 0.01 %RH, rounded
+    sample->gas_resistance = data->gas_resistance;
+#endif
+}
+
+// Console commands
+
+// Text of a console reading, appended to line
+typedef void (*bme680_text_t)(fmt_t* line, int8_t rslt, const bme680_sample_t* sample);
+
+static void bme680_temperature_text(fmt_t* line, int8_t rslt, const bme680_sample_t* sample)
+{
+    if (rslt == BME68X_OK) {
+        fmt_str(line, "Temperature: ");
+        fmt_fixed(line, sample->temperature, 2);
+        fmt_str(line, "°C\r\n");
+    } else {
+        fmt_str(line, "Error reading temperature from BME680\r\n");
+    }
+}
+
+static void bme680_pressure_text(fmt_t* line, int8_t rslt, const bme680_sample_t* sample)
+{
+    if (rslt == BME68X_OK) {
+        fmt_str(line, "Pressure: ");
+        fmt_u32(line, sample->pressure);
+        fmt_str(line, " Pa\r\n");
+    } else {
+        fmt_str(line, "Error reading pressure from BME680\r\n");
+    }
+}
+
+static void bme680_humidity_text(fmt_t* line, int8_t rslt, const bme680_sample_t* sample)
+{
+    if (rslt == BME68X_OK) {
+        fmt_str(line, "Humidity: ");
+        fmt_fixed(line, sample->humidity, 2);
+        fmt_str(line, "%\r\n");
+    } else {
+        fmt_str(line, "Error reading humidity from BME680\r\n");
+    }
+}
+
+static void bme680_test_text(fmt_t* line, int8_t rslt, const bme680_sample_t* sample)
+{
+    if (rslt == BME68X_OK) {
+        fmt_str(line, "Test successful!\r\nTemperature: ");
+        fmt_fixed(line, sample->temperature, 2);
+        fmt_str(line, "°C\r\nPressure: ");
+        fmt_u32(line, sample->pressure);
+        fmt_str(line, " Pa\r\nHumidity: ");
+        fmt_fixed(line, sample->humidity, 2);
+        fmt_str(line, "%\r\n");
+    } else {
+        fmt_str(line, "Test failed! Error reading sensor data.\r\n");
+    }
+}
+
+// Print a console reading, prefixed with the sensor when there are several.
+// A deferred reply (conversion finished after the command returned) goes
+// over the prompt and shows a new one after it.
+static void bme680_console_reply(console_ctx_t* ctx, bme680_text_t text, int8_t rslt,
+                                 const bme680_sample_t* sample, uint8_t deferred)
+{
+    char buffer[128];
+    fmt_t line;
+
+    fmt_init(&line, buffer, sizeof(buffer));
+    if (deferred) {
+        fmt_char(&line, '\r');
+    }
+    if (bme680_sensor_slots > 1) {
+        fmt_str(&line, "Sensor ");
+        fmt_u32(&line, sample->sensor_id);
+        fmt_str(&line, ": ");
+    }
+    text(&line, rslt, sample);
+    if (deferred) {
+        fmt_str(&line, "> ");
+    }
+    console_write(ctx, buffer);
+}
+
+// Conversion callbacks for the console commands (arg is the console)
+static void bme680_temperature_done(int8_t rslt, const bme680_sample_t* sample, void* arg) { bme680_console_reply(arg, bme680_temperature_text, rslt, sample, 1); }
+static void bme680_pressure_done(int8_t rslt, const bme680_sample_t* sample, void* arg) { bme680_console_reply(arg, bme680_pressure_text, rslt, sample, 1); }
+static void bme680_humidity_done(int8_t rslt, const bme680_sample_t* sample, void* arg) { bme680_console_reply(arg, bme680_humidity_text, rslt, sample, 1); }
+static void bme680_test_done(int8_t rslt, const bme680_sample_t* sample, void* arg) { bme680_console_reply(arg, bme680_test_text, rslt, sample, 1); }
+
+// Answer a console read from a sample no older than max_age_ms, or start a
+// conversion whose callback answers later. The optional argument picks the
+// sensor (default 0).
+static void bme680_cmd_read(console_ctx_t* ctx, int argc, char* argv[], uint32_t max_age_ms,
+                            bme680_text_t text, bme680_callback_t done)
+{
+    bme680_sample_t sample;
+    uint8_t sensor = (argc > 1) ? (uint8_t)strtoul(argv[1], NULL, 10) : 0;
+    int8_t rslt;
+
+    if (sensor >= bme680_sensor_slots) {
+        console_printf(ctx, "Error: no sensor %s (%u found)\r\n", argv[1], bme680_sensor_slots);
+        return;
+    }
+
+    rslt = bme680_get_sample(sensor, max_age_ms, &sample, done, ctx);
+    if (rslt == BME68X_OK) {
+        bme680_console_reply(ctx, text, rslt, &sample, 0);
+    } else if (rslt != BME680_W_PENDING) {
+        console_write(ctx, "Error: BME680 sensor not available\r\n");
+    }
+}
+
+// Command handlers for reading the sensor, served from the sample cache
+static void cmd_read_temperature(console_ctx_t* ctx, int argc, char* argv[]) { bme680_cmd_read(ctx, argc, argv, BME680_READ_MAX_AGE_MS, bme680_temperature_text, bme680_temperature_done); }
+static void cmd_read_pressure(console_ctx_t* ctx, int argc, char* argv[]) { bme680_cmd_read(ctx, argc, argv, BME680_READ_MAX_AGE_MS, bme680_pressure_text, bme680_pressure_done); }
+static void cmd_read_humidity(console_ctx_t* ctx, int argc, char* argv[]) { bme680_cmd_read(ctx, argc, argv, BME680_READ_MAX_AGE_MS, bme680_humidity_text, bme680_humidity_done); }
+
+// Command handler for testing sensor (always a fresh conversion)
+static void cmd_test_sensor(console_ctx_t* ctx, int argc, char* argv[])
+{
+    console_printf(ctx, "Testing BME680 sensor (%s)...\r\n", ctx->name);
+    bme680_cmd_read(ctx, argc, argv, 0, bme680_test_text, bme680_test_done);
+}
+
+// Command handler showing the health and I2C error counters of every sensor
+static void cmd_sensor_health(console_ctx_t* ctx, int argc, char* argv[])
+{
+    static const char* const state_names[] = { "not probed", "ok", "failed" };
+    bme680_health_t health;
+
+    for (uint8_t i = 0; bme680_get_health(i, &health) == 0; i++) {
+        console_printf(ctx, "BME680 %u: %s at 0x%02X, transfers=%lu errors=%lu (%u in a row)\r\n", i,
+                       state_names[health.state], health.address, health.transfers, health.errors,
+                       health.consecutive_errors);
+        if (health.state == BME680_HEALTH_OK) {
+            console_printf(ctx, "  Bring-up %lu us, calibration from %s\r\n", health.init_us,
+                           health.calib_from_flash ? "flash" : "sensor");
+        }
+        if (health.state == BME680_HEALTH_FAILED) {
+            console_printf(ctx, "  Re-probe in %ld ms (interval %lu ms, %lu probes so far)\r\n",
+                           (int32_t)(health.next_probe - HAL_GetTick()), health.backoff_ms, health.probes);
+        }
+    }
+}
+
+// Parse "<degC>:<ms>,<degC>:<ms>,..." into profile steps, returns 0 if invalid
+static uint8_t bme680_parse_steps(const char* text, bme680_profile_t* profile)
+{
+    const char* p = text;
+    char* end;
+
+    profile->steps = 0;
+    while (*p != '\0') {
+        if (profile->steps >= BME680_PROFILE_MAX_STEPS) {
+            return 0;
+        }
+        profile->temp_c[profile->steps] = (uint16_t)strtoul(p, &end, 10);
+        if (end == p || *end != ':') {
+            return 0;
+        }
+        p = end + 1;
+        profile->dur_ms[profile->steps] = (uint16_t)strtoul(p, &end, 10);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        profile->steps++;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return profile->steps;
+}
+
+// Command handler for starting, stopping and inspecting the gas heater profile
+static void cmd_gas_profile(console_ctx_t* ctx, int argc, char* argv[])
+{
+    static const char* const mode_names[] = { "off", "forced", "parallel", "sequential" };
+    bme680_profile_t profile;
+    bme680_profile_stats_t stats;
+    int8_t rslt;
+
+    if (argc < 2) {
+        bme680_get_profile(&profile, &stats);
+        if (!stats.running) {
+            console_write(ctx, "Heater profile: off\r\n");
+            return;
+        }
+        console_printf(ctx, "Heater profile: %s,", mode_names[profile.mode & 3]);
+        for (uint8_t i = 0; i < profile.steps; i++) {
+            console_printf(ctx, " %uC/%ums", profile.temp_c[i], profile.dur_ms[i]);
+        }
+        console_printf(ctx, "\r\nreads=%lu fields=%lu (%lu.%02lu per read) gas valid=%lu lost=%lu errors=%lu\r\n",
+                       stats.reads, stats.fields, stats.reads ? stats.fields / stats.reads : 0,
+                       stats.reads ? (stats.fields * 100 / stats.reads) % 100 : 0, stats.gas_valid,
+                       stats.lost, stats.errors);
+        return;
+    }
+
+    if (strcmp(argv[1], "off") == 0) {
+        bme680_profile_stop();
+        console_write(ctx, "Heater profile stopped\r\n");
+        return;
+    }
+
+    memset(&profile, 0, sizeof(profile));
+    if (strcmp(argv[1], "single") == 0) {
+        bme680_parse_steps("320:150", &profile);
+    } else if (strcmp(argv[1], "ramp") == 0) {
+        bme680_parse_steps("200:100,240:100,280:100,320:100,360:100,400:100", &profile);
+    } else if (bme680_parse_steps(argv[1], &profile) == 0) {
+        console_printf(ctx, "Usage: gas profile [off|single|ramp|<C:ms>,...] [forced|seq|par] (up to %u steps)\r\n",
+                       BME680_PROFILE_MAX_STEPS);
+        return;
+    }
+
+    // Default: the most the sensor can do
+    profile.mode = (bme680_prof_sensor->dev.variant_id == BME68X_VARIANT_GAS_HIGH) ? BME68X_SEQUENTIAL_MODE : BME68X_FORCED_MODE;
+    if (argc > 2) {
+        if (strcmp(argv[2], "forced") == 0) {
+            profile.mode = BME68X_FORCED_MODE;
+        } else if (strcmp(argv[2], "seq") == 0) {
+            profile.mode = BME68X_SEQUENTIAL_MODE;
+        } else if (strcmp(argv[2], "par") == 0) {
+            profile.mode = BME68X_PARALLEL_MODE;
+        } else {
+            console_write(ctx, "Mode must be forced, seq or par\r\n");
+            return;
+        }
+    }
+
+    rslt = bme680_profile_start(&profile);
+    if (rslt == BME68X_OK) {
+        console_printf(ctx, "Heater profile started: %u steps, %s mode\r\n", profile.steps, mode_names[profile.mode & 3]);
+    } else if (rslt == BME680_E_PROFILE) {
+        console_printf(ctx, "Error: steps must be %u-%u C for 1-%u ms; seq/par need a BME688\r\n",
+                       BME680_HEATER_MIN_C, BME680_HEATER_MAX_C, BME680_HEATER_MAX_MS);
+    } else if (rslt == BME680_E_BUSY) {
+        console_write(ctx, "Error: measurement in progress, try again\r\n");
+    } else {
+        console_printf(ctx, "Error: heater profile start failed (%d)\r\n", rslt);
+    }
+}
+
+// Print one row of the measurement profile table
+static void bme680_print_meas_profile(console_ctx_t* ctx, uint8_t id)
+{
+    const bme680_meas_profile_t* profile = bme680_meas_profile_info(id);
+    uint32_t duration_us = bme680_meas_duration_us(id);
+    uint32_t charge_nc = bme680_meas_charge_nc(id);
+    uint32_t na_1hz = charge_nc + BME680_IDD_SLEEP_NA;
+    uint32_t na_10hz = 10 * charge_nc + BME680_IDD_SLEEP_NA;
+    char odr[8];
+
+    if (profile->odr == BME68X_ODR_NONE) {
+        strcpy(odr, "-");
+    } else {
+        fmt_format(odr, sizeof(odr), "%u", bme680_odr_ms[profile->odr]);
+    }
+
+    // Oversampling setting n is 2^(n-1) cycles, filter setting n is 2^n - 1
+    console_printf(ctx, "%c %-14s %2u/%2u/%2u %4u %6s %4lu.%lu %8lu %4lu.%02lu %5lu.%02lu\r\n",
+                   (id == bme680_meas_id) ? '*' : ' ', profile->name,
+                   profile->os_temp ? 1u << (profile->os_temp - 1) : 0,
+                   profile->os_pres ? 1u << (profile->os_pres - 1) : 0,
+                   profile->os_hum ? 1u << (profile->os_hum - 1) : 0,
+                   (1u << profile->filter) - 1, odr, duration_us / 1000, (duration_us % 1000) / 100,
+                   charge_nc, na_1hz / 1000, (na_1hz % 1000) / 10, na_10hz / 1000, (na_10hz % 1000) / 10);
+}
+
+// Command handler listing the measurement profiles, or switching to one
+static void cmd_sensor_profile(console_ctx_t* ctx, int argc, char* argv[])
+{
+    uint8_t id;
+    int8_t rslt;
+
+    if (argc < 2) {
+        console_write(ctx, "  Profile        T/ P/ H  IIR ODR ms  Conv ms  nC/conv  uA@1Hz  uA@10Hz\r\n");
+        for (id = 0; id < BME680_MEAS_PROFILE_COUNT; id++) {
+            bme680_print_meas_profile(ctx, id);
+        }
+        return;
+    }
+
+    for (id = 0; id < BME680_MEAS_PROFILE_COUNT; id++) {
+        if (strcmp(argv[1], bme680_meas_profiles[id].name) == 0) {
+            break;
+        }
+    }
+    if (id == BME680_MEAS_PROFILE_COUNT) {
+        console_write(ctx, "Usage: sensor profile [low-power|balanced|high-precision|fast-stream]\r\n");
+        return;
+    }
+
+    rslt = bme680_set_meas_profile(id);
+    if (rslt == BME68X_OK) {
+        console_printf(ctx, "Measurement profile %s: %lu us per conversion\r\n", bme680_meas_profiles[id].name,
+                       bme680_meas_duration_us(id));
+    } else if (rslt == BME680_E_BUSY) {
+        console_write(ctx, "Error: measurement or heater profile running, try again\r\n");
+    } else {
+        console_printf(ctx, "Error: measurement profile change failed (%d)\r\n", rslt);
+    }
+}
+
+// Command handler showing or clearing the flash calibration cache
+static void cmd_calib_cache(console_ctx_t* ctx, int argc, char* argv[])
+{
+    bme680_calib_stats_t stats;
+    bme680_calib_key_t key;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "clear") != 0) {
+            console_write(ctx, "Usage: calib cache [clear]\r\n");
+        } else if (bme680_calib_erase() != 0) {
+            console_write(ctx, "Error: flash erase failed\r\n");
+        } else {
+            console_write(ctx, "Calibration cache cleared, the next bring-up reads the sensor\r\n");
+        }
+        return;
+    }
+
+    for (uint8_t slot = 0; slot < BME680_CALIB_SLOTS; slot++) {
+        if (bme680_calib_stored(slot, &key)) {
+            console_printf(ctx, "Calibration cache %u: chip 0x%02X variant %u at 0x%02X, trim %02X %02X %02X %02X %02X\r\n",
+                           slot, key.chip_id, key.variant_id, key.address, key.coeff3[0], key.coeff3[1],
+                           key.coeff3[2], key.coeff3[3], key.coeff3[4]);
+        } else {
+            console_printf(ctx, "Calibration cache %u: empty\r\n", slot);
+        }
+    }
+    bme680_calib_get_stats(&stats);
+    console_printf(ctx, "loads=%lu misses=%lu saves=%lu save errors=%lu\r\n", stats.loads, stats.misses,
+                   stats.saves, stats.save_errors);
+}
+
+static void cmd_raw_registers(console_ctx_t* ctx, int argc, char* argv[]) { bme680_read_raw_registers(); }
+static void cmd_raw_adc(console_ctx_t* ctx, int argc, char* argv[]) { bme680_read_raw_adc_values(); }
+static void cmd_calib_data(console_ctx_t* ctx, int argc, char* argv[]) { bme680_check_calibration_data(); }
+
+static const console_command_t bme680_commands[] = {
+    { "read temperature", "rt", "[sensor]", cmd_read_temperature, "Read temperature from BME680" },
+    { "read pressure",    "rp", "[sensor]", cmd_read_pressure,    "Read pressure from BME680" },
+    { "read humidity",    "rh", "[sensor]", cmd_read_humidity,    "Read humidity from BME680" },
+    { "test sensor",      "ts", "[sensor]", cmd_test_sensor,      "Test BME680 sensor" },
+    { "sensor health",    "sh", NULL, cmd_sensor_health,    "Show health and I2C error counters of every BME680" },
+    { "gas profile",      "gp", "[off|single|ramp|C:ms,...] [forced|seq|par]", cmd_gas_profile,
+      "Run a gas heater profile on sensor 0, or show its counters" },
+    { "sensor profile",   "sp", "[low-power|balanced|high-precision|fast-stream]", cmd_sensor_profile,
+      "Select the oversampling/filter profile, or list them with timing and current" },
+    { "raw registers",    "rr", NULL, cmd_raw_registers,    "Read raw BME680 registers" },
+    { "raw adc",          "ra", NULL, cmd_raw_adc,          "Read raw BME680 ADC values" },
+    { "calib data",       "cd", NULL, cmd_calib_data,       "Check BME680 calibration data" },
+    { "calib cache",      "cc", "[clear]", cmd_calib_cache, "Show or clear the flash calibration cache" },
+};
+
+// Register the sensor commands with the console
+int8_t bme680_register_commands(void)
+{
+    return console_register_commands("Sensor Commands", bme680_commands,
+                                     sizeof(bme680_commands) / sizeof(bme680_commands[0]));
+}
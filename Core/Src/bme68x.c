@@ -888,9 +888,10 @@ static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
 
     var1 = ((int32_t)dev->calib.par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
     var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)dev->calib.par_p8) >> 13;
+    /* The cube times par_p10 exceeds int32 above ~1060 hPa (par_p10 = 30), so the last product is 64-bit */
     var3 =
-        ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
-         (int32_t)dev->calib.par_p10) >> 17;
+        (int32_t)(((int64_t)((pressure_comp >> 8) * (pressure_comp >> 8) * (pressure_comp >> 8)) *
+                   (int32_t)dev->calib.par_p10) >> 17);
     pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)dev->calib.par_p7 << 7)) >> 4);
 
     /*lint -restore */
@@ -1,776 +1,627 @@
 #include "command_interface.h"
-#include "bme680_interface.h"
-#include "lora_interface.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "host_protocol.h"
+#include "fmt.h"
+#include "scheduler.h"
 #include <string.h>
-#include <stdio.h>
+#include <strings.h>
 #include <stdlib.h>
+#include <stdarg.h>
 
 extern UART_HandleTypeDef huart2;
 extern UART_HandleTypeDef huart4;
+extern UART_HandleTypeDef hlpuart1;
 
-// Global variables
-static char cmd_buffer[CMD_BUFFER_SIZE];
-static char cmd_buffer_usart4[CMD_BUFFER_SIZE];
-static uint8_t cmd_index = 0;
-static uint8_t cmd_index_usart4 = 0;
-static uint8_t system_started = 0;
-static uint8_t system_started_usart4 = 0;
+// Console ports (one context per UART)
+static console_ctx_t consoles[CONSOLE_MAX_PORTS];
+static uint8_t console_count = 0;
 
-// Initialize command interface
+// Command registry. Tables stay in flash; the key index (every name and
+// alias, sorted) is built in RAM at registration so lookup is a binary search.
+typedef struct {
+    const char* key;
+    const console_command_t* cmd;
+} console_key_t;
+
+typedef struct {
+    const char* name;
+    const console_command_t* table;
+    uint8_t count;
+} console_group_t;
+
+static console_group_t console_groups[CONSOLE_MAX_GROUPS];
+static uint8_t console_group_count = 0;
+static console_key_t console_keys[CONSOLE_MAX_KEYS];
+static uint16_t console_key_count = 0;
+
+// Built-in command handlers
+static void cmd_help(console_ctx_t* ctx, int argc, char* argv[]);
+static void cmd_math_operation(console_ctx_t* ctx, int argc, char* argv[]);
+static void cmd_uart_stats(console_ctx_t* ctx, int argc, char* argv[]);
+static void cmd_uart_policy(console_ctx_t* ctx, int argc, char* argv[]);
+static void cmd_mirror(console_ctx_t* ctx, int argc, char* argv[]);
+static void cmd_protocol(console_ctx_t* ctx, int argc, char* argv[]);
+
+static const console_command_t math_commands[] = {
+    { "sum", NULL, "<num1> <num2>", cmd_math_operation, "Add two numbers" },
+    { "sub", NULL, "<num1> <num2>", cmd_math_operation, "Subtract num2 from num1" },
+    { "mul", NULL, "<num1> <num2>", cmd_math_operation, "Multiply two numbers" },
+    { "div", NULL, "<num1> <num2>", cmd_math_operation, "Divide num1 by num2" },
+};
+
+static const console_command_t system_commands[] = {
+    { "uart stats", "us", NULL,          cmd_uart_stats, "Show UART transmit queue counters" },
+    { "uart policy", "up", "<port> <block|drop-oldest|truncate>", cmd_uart_policy,
+      "Set what a port does when its transmit queue is full" },
+    { "mirror",     NULL, "<port|off>",  cmd_mirror,     "Copy this console's responses to another port" },
+    { "protocol",   "proto", "[text|binary]", cmd_protocol, "Switch this port to the binary host protocol" },
+    { "help",       NULL, "[command]",   cmd_help,       "Show this help menu" },
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+// Initialize command interface on every console UART
 void command_interface_init(void)
 {
-    // Initialize USART2 command interface
-    cmd_index = 0;
-    system_started = 0;
-    memset(cmd_buffer, 0, CMD_BUFFER_SIZE);
-    
-    // Initialize USART4 command interface
-    cmd_index_usart4 = 0;
-    system_started_usart4 = 0;
-    memset(cmd_buffer_usart4, 0, CMD_BUFFER_SIZE);
-    
-    // Send welcome message on both UARTs
-    command_interface_send_response("IoT Prototype System Ready (USART2)\r\n");
-    command_interface_send_response("Type 'start' to begin\r\n");
-    
-    command_interface_send_response_usart4("IoT Prototype System Ready (USART4)\r\n");
-    command_interface_send_response_usart4("Type 'start' to begin\r\n");
+    console_count = 0;
+    console_group_count = 0;
+    console_key_count = 0;
+
+    console_register_commands("Math Operations", math_commands, ARRAY_SIZE(math_commands));
+    console_register_commands("System", system_commands, ARRAY_SIZE(system_commands));
+
+    command_interface_add_port(&huart2, "USART2");
+    command_interface_add_port(&huart4, "USART4");
+    command_interface_add_port(&hlpuart1, "LPUART1");
 }
 
-// Process incoming commands
-void command_interface_process(void)
+// Compare a key with the first len characters of a line
+static int console_key_compare(const char* key, const char* line, size_t len)
 {
-    uint8_t rx_byte;
-    
-    // Check if data is available on USART2
-    if (HAL_UART_Receive(&huart2, &rx_byte, 1, 10) == HAL_OK) {
-        // Handle backspace
-        if (rx_byte == '\b' || rx_byte == 127) {
-            if (cmd_index > 0) {
-                cmd_index--;
-                cmd_buffer[cmd_index] = '\0';
-                command_interface_send_response("\b \b"); // Backspace, space, backspace
-            }
-        }
-        // Handle enter key
-        else if (rx_byte == '\r' || rx_byte == '\n') {
-            if (cmd_index > 0) {
-                cmd_buffer[cmd_index] = '\0';
-                command_interface_send_response("\r\n");
-                
-                // Process command
-                command_interface_handle_command(cmd_buffer);
-                
-                // Reset buffer
-                cmd_index = 0;
-                memset(cmd_buffer, 0, CMD_BUFFER_SIZE);
-            }
-            command_interface_send_response("> ");
-        }
-        // Handle regular characters
-        else if (cmd_index < CMD_BUFFER_SIZE - 1 && rx_byte >= 32 && rx_byte <= 126) {
-            cmd_buffer[cmd_index++] = rx_byte;
-            // Echo character back
-            HAL_UART_Transmit(&huart2, &rx_byte, 1, HAL_MAX_DELAY);
-        }
-    }
-    
-    // Check if data is available on USART4
-    if (HAL_UART_Receive(&huart4, &rx_byte, 1, 10) == HAL_OK) {
-        // Handle backspace
-        if (rx_byte == '\b' || rx_byte == 127) {
-            if (cmd_index_usart4 > 0) {
-                cmd_index_usart4--;
-                cmd_buffer_usart4[cmd_index_usart4] = '\0';
-                command_interface_send_response_usart4("\b \b"); // Backspace, space, backspace
-            }
-        }
-        // Handle enter key
-        else if (rx_byte == '\r' || rx_byte == '\n') {
-            if (cmd_index_usart4 > 0) {
-                cmd_buffer_usart4[cmd_index_usart4] = '\0';
-                command_interface_send_response_usart4("\r\n");
-                
-                // Process command
-                command_interface_handle_command_usart4(cmd_buffer_usart4);
-                
-                // Reset buffer
-                cmd_index_usart4 = 0;
-                memset(cmd_buffer_usart4, 0, CMD_BUFFER_SIZE);
-            }
-            command_interface_send_response_usart4("> ");
-        }
-        // Handle regular characters
-        else if (cmd_index_usart4 < CMD_BUFFER_SIZE - 1 && rx_byte >= 32 && rx_byte <= 126) {
-            cmd_buffer_usart4[cmd_index_usart4++] = rx_byte;
-            // Echo character back
-            HAL_UART_Transmit(&huart4, &rx_byte, 1, HAL_MAX_DELAY);
-        }
+    int result = strncmp(key, line, len);
+
+    if (result == 0 && key[len] != '\0') {
+        result = 1; // Key is longer than the word being looked up
     }
+    return result;
 }
 
-// Show help menu
-void command_interface_show_help(void)
+// Binary search of the key index for the first len characters of a line
+static const console_command_t* console_lookup(const char* line, size_t len)
 {
-    command_interface_send_response("\r\n=== Available Commands ===\r\n");
-    command_interface_send_response("Sensor Commands:\r\n");
-    command_interface_send_response("  read temperature (rt) - Read temperature from BME680\r\n");
-    command_interface_send_response("  read pressure (rp)    - Read pressure from BME680\r\n");
-    command_interface_send_response("  read humidity (rh)    - Read humidity from BME680\r\n");
-    command_interface_send_response("  test sensor (ts)      - Test BME680 sensor\r\n");
-    command_interface_send_response("  raw registers (rr)    - Read raw BME680 registers\r\n");
-    command_interface_send_response("  raw adc (ra)          - Read raw BME680 ADC values\r\n");
-    command_interface_send_response("  calib data (cd)       - Check BME680 calibration data\r\n");
-    command_interface_send_response("  scan i2c (si)         - Scan I2C bus for devices\r\n");
-    command_interface_send_response("\r\nLoRa Commands:\r\n");
-    command_interface_send_response("  lora broadcast (lb)   - Broadcast sensor data via LoRa\r\n");
-    command_interface_send_response("  lora config (lc)      - Show LoRa configuration\r\n");
-    command_interface_send_response("  lora test (lt)        - Test LoRa transmission\r\n");
-    command_interface_send_response("  lora scan (ls)        - Scan for LoRa signals (5s)\r\n");
-    command_interface_send_response("  lora monitor (lm)     - Start continuous monitoring\r\n");
-    command_interface_send_response("  lora stop (lst)       - Stop LoRa monitoring\r\n");
-    command_interface_send_response("  lora rssi (lr)        - Get current RSSI\r\n");
-    command_interface_send_response("\r\nMath Operations:\r\n");
-    command_interface_send_response("  sum <num1> <num2>     - Add two numbers\r\n");
-    command_interface_send_response("  sub <num1> <num2>     - Subtract num2 from num1\r\n");
-    command_interface_send_response("  mul <num1> <num2>     - Multiply two numbers\r\n");
-    command_interface_send_response("  div <num1> <num2>     - Divide num1 by num2\r\n");
-    command_interface_send_response("\r\nSystem:\r\n");
-    command_interface_send_response("  help                  - Show this help menu\r\n");
-    command_interface_send_response("========================\r\n");
-}
+    uint16_t low = 0;
+    uint16_t high = console_key_count;
 
-// Handle incoming commands
-void command_interface_handle_command(char* command)
-{
-    char response[256];
-    
-    // Check if system is started
-    if (!system_started) {
-        if (strcmp(command, "start") == 0) {
-            system_started = 1;
-            command_interface_send_response("System started! Type 'help' for available commands.\r\n");
-            command_interface_send_response("> ");
-            return;
+    while (low < high) {
+        uint16_t mid = (uint16_t)((low + high) / 2);
+        int result = console_key_compare(console_keys[mid].key, line, len);
+
+        if (result == 0) {
+            return console_keys[mid].cmd;
+        }
+        if (result < 0) {
+            low = mid + 1;
         } else {
-            command_interface_send_response("Please type 'start' to begin.\r\n");
-            return;
+            high = mid;
         }
     }
-    
-    // Parse commands (full and abbreviated versions)
-    if (strcmp(command, "read temperature") == 0 || strcmp(command, "rt") == 0) {
-        cmd_read_temperature();
-    }
-    else if (strcmp(command, "read pressure") == 0 || strcmp(command, "rp") == 0) {
-        cmd_read_pressure();
-    }
-    else if (strcmp(command, "read humidity") == 0 || strcmp(command, "rh") == 0) {
-        cmd_read_humidity();
-    }
-    else if (strcmp(command, "test sensor") == 0 || strcmp(command, "ts") == 0) {
-        cmd_test_sensor();
-    }
-    else if (strcmp(command, "raw registers") == 0 || strcmp(command, "rr") == 0) {
-        bme680_read_raw_registers();
-    }
-    else if (strcmp(command, "raw adc") == 0 || strcmp(command, "ra") == 0) {
-        bme680_read_raw_adc_values();
-    }
-    else if (strcmp(command, "calib data") == 0 || strcmp(command, "cd") == 0) {
-        bme680_check_calibration_data();
-    }
-    else if (strcmp(command, "scan i2c") == 0 || strcmp(command, "si") == 0) {
-        i2c_scan_bus();
-    }
-    else if (strcmp(command, "lora broadcast") == 0 || strcmp(command, "lb") == 0) {
-        cmd_lora_broadcast();
-    }
-    else if (strcmp(command, "lora config") == 0 || strcmp(command, "lc") == 0) {
-        lora_print_config();
-    }
-    else if (strcmp(command, "lora test") == 0 || strcmp(command, "lt") == 0) {
-        lora_test_transmission();
-    }
-    else if (strcmp(command, "lora scan") == 0 || strcmp(command, "ls") == 0) {
-        lora_scan_signals(5000); // 5 second scan
-    }
-    else if (strcmp(command, "lora monitor") == 0 || strcmp(command, "lm") == 0) {
-        lora_start_monitoring();
-    }
-    else if (strcmp(command, "lora stop") == 0 || strcmp(command, "lst") == 0) {
-        lora_stop_monitoring();
-    }
-    else if (strcmp(command, "lora rssi") == 0 || strcmp(command, "lr") == 0) {
-        lora_get_rssi();
+    return NULL;
+}
+
+// Insert one key into the sorted index
+static int8_t console_add_key(const char* key, const console_command_t* cmd)
+{
+    uint16_t pos = console_key_count;
+
+    if (console_key_count >= CONSOLE_MAX_KEYS) {
+        return -1;
     }
-    else if (strcmp(command, "lora redetect") == 0 || strcmp(command, "lrd") == 0) {
-        lora_force_redetect();
+
+    while (pos > 0 && strcmp(console_keys[pos - 1].key, key) > 0) {
+        pos--;
     }
-    else if (strncmp(command, "sum ", 4) == 0) {
-        cmd_math_operation(command);
+    if (pos > 0 && strcmp(console_keys[pos - 1].key, key) == 0) {
+        return -1; // Name already taken
     }
-    else if (strncmp(command, "sub ", 4) == 0) {
-        cmd_math_operation(command);
+
+    memmove(&console_keys[pos + 1], &console_keys[pos], (console_key_count - pos) * sizeof(console_key_t));
+    console_keys[pos].key = key;
+    console_keys[pos].cmd = cmd;
+    console_key_count++;
+    return 0;
+}
+
+// Register a module's command table (the table must stay valid, normally const)
+int8_t console_register_commands(const char* group, const console_command_t* table, uint8_t count)
+{
+    int8_t result = 0;
+
+    if (console_group_count >= CONSOLE_MAX_GROUPS) {
+        return -1;
     }
-    else if (strncmp(command, "mul ", 4) == 0) {
-        cmd_math_operation(command);
+
+    console_groups[console_group_count].name = group;
+    console_groups[console_group_count].table = table;
+    console_groups[console_group_count].count = count;
+    console_group_count++;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (console_add_key(table[i].name, &table[i]) != 0) {
+            result = -1;
+        }
+        if (table[i].alias != NULL && console_add_key(table[i].alias, &table[i]) != 0) {
+            result = -1;
+        }
     }
-    else if (strncmp(command, "div ", 4) == 0) {
-        cmd_math_operation(command);
+    return result;
+}
+
+// Find a command by its full name or alias
+const console_command_t* console_find_command(const char* name)
+{
+    return console_lookup(name, strlen(name));
+}
+
+// Attach a console to a UART: queued DMA output, DMA input, fresh session
+int8_t command_interface_add_port(UART_HandleTypeDef* huart, const char* name)
+{
+    if (console_count >= CONSOLE_MAX_PORTS) {
+        return -1;
     }
-    else if (strcmp(command, "help") == 0) {
-        command_interface_show_help();
+
+    console_ctx_t* ctx = &consoles[console_count];
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->name = name;
+    ctx->huart = huart;
+    ctx->sink_mask = (uint8_t)(1u << console_count);
+    ctx->index = console_count;
+    ctx->mode = CONSOLE_MODE_TEXT;
+    host_protocol_reset(ctx);
+
+    if (uart_tx_init(huart, UART_TX_POLICY_BLOCK) != 0 || uart_rx_start(huart) != 0) {
+        return -1;
     }
-    else {
-        snprintf(response, sizeof(response), "Unknown command: %s\r\nType 'help' for available commands.\r\n", command);
-        command_interface_send_response(response);
+
+    console_count++;
+    return 0;
+}
+
+// Send the welcome message on every console
+void command_interface_announce(void)
+{
+    for (uint8_t i = 0; i < console_count; i++) {
+        console_printf(&consoles[i], "IoT Prototype System Ready (%s)\r\n", consoles[i].name);
+        console_write(&consoles[i], "Type 'start' to begin\r\n");
     }
 }
 
-// Send response via USART2
-void command_interface_send_response(const char* response)
+// Number of attached consoles
+uint8_t command_interface_port_count(void)
 {
-    HAL_UART_Transmit(&huart2, (uint8_t*)response, strlen(response), HAL_MAX_DELAY);
+    return console_count;
 }
 
-// Send response via USART4
-void command_interface_send_response_usart4(const char* response)
+// Console context by index (NULL if out of range)
+console_ctx_t* command_interface_get_port(uint8_t index)
 {
-    HAL_UART_Transmit(&huart4, (uint8_t*)response, strlen(response), HAL_MAX_DELAY);
+    return (index < console_count) ? &consoles[index] : NULL;
 }
 
-// Command handler for reading temperature
-void cmd_read_temperature(void)
+// Echo pending characters in one write, returns the new (empty) echo length
+static uint16_t command_interface_flush_echo(console_ctx_t* ctx, uint8_t* echo, uint16_t len)
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    char debug_msg[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response(response);
-        return;
+    if (len > 0) {
+        uart_tx_write(ctx->huart, echo, len);
     }
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        // Decode the IEEE 754 value from memory
-        uint32_t temp_mem = *(uint32_t*)&sensor_data.temperature;
-        float temp_decoded = decode_ieee754(temp_mem);
-        
-        // Direct IEEE 754 calculation for temperature
-        uint32_t temp_sign = (temp_mem >> 31) & 0x1;
-        uint32_t temp_exp = (temp_mem >> 23) & 0xFF;
-        uint32_t temp_mant = temp_mem & 0x7FFFFF;
-        
-        if (temp_exp != 0 && temp_exp != 0xFF) {
-            int temp_exp_val = (int)temp_exp - 127;
-            float temp_result = 1.0f;
-            
-            // Calculate mantissa
-            for (int i = 22; i >= 0; i--) {
-                if (temp_mant & (1 << i)) {
-                    temp_result += 1.0f / (1 << (23 - i));
-                }
-            }
-            
-            // Apply exponent
-            if (temp_exp_val > 0) {
-                temp_result *= (1 << temp_exp_val);
-            } else if (temp_exp_val < 0) {
-                temp_result /= (1 << (-temp_exp_val));
-            }
-            
-            // Apply sign
-            if (temp_sign) temp_result = -temp_result;
-            
-            temp_decoded = temp_result;
-        }
-        
-        // Debug: Print the raw value before formatting
-        snprintf(debug_msg, sizeof(debug_msg), "DEBUG: Raw temperature value: %.6f\r\n", temp_decoded);
-        command_interface_send_response(debug_msg);
-        
-        snprintf(response, sizeof(response), "Temperature: %.2f°C\r\n", temp_decoded);
-        
-        // Debug: Print the formatted string
-        snprintf(debug_msg, sizeof(debug_msg), "DEBUG: Formatted string: '%.80s'\r\n", response);
-        command_interface_send_response(debug_msg);
-    } else {
-        snprintf(response, sizeof(response), "Error reading temperature from BME680\r\n");
-    }
-    
-    command_interface_send_response(response);
+    return 0;
 }
 
-// Command handler for reading pressure
-void cmd_read_pressure(void)
+// Line editor: consume received bytes for a console in text mode.
+// Returns the bytes used; stops early if a command switched the port to binary.
+static uint16_t command_interface_feed(console_ctx_t* ctx, const uint8_t* data, uint16_t len)
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response(response);
-        return;
-    }
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        // Decode the IEEE 754 value from memory
-        uint32_t press_mem = *(uint32_t*)&sensor_data.pressure;
-        uint32_t press_sign = (press_mem >> 31) & 0x1;
-        uint32_t press_exp = (press_mem >> 23) & 0xFF;
-        uint32_t press_mant = press_mem & 0x7FFFFF;
-        
-        float press_decoded = 0.0f;
-        if (press_exp != 0 && press_exp != 0xFF) {
-            int press_exp_val = (int)press_exp - 127;
-            float press_result = 1.0f;
-            
-            for (int i = 22; i >= 0; i--) {
-                if (press_mant & (1 << i)) {
-                    press_result += 1.0f / (1 << (23 - i));
-                }
+    uint8_t echo[CMD_RX_CHUNK_SIZE];
+    uint16_t echo_len = 0;
+
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t rx_byte = data[i];
+
+        // Handle backspace
+        if (rx_byte == '\b' || rx_byte == 127) {
+            if (ctx->line_len > 0) {
+                ctx->line_len--;
+                ctx->line[ctx->line_len] = '\0';
+                echo_len = command_interface_flush_echo(ctx, echo, echo_len);
+                uart_tx_write_string(ctx->huart, "\b \b"); // Backspace, space, backspace
             }
-            
-            if (press_exp_val > 0) {
-                press_result *= (1 << press_exp_val);
-            } else if (press_exp_val < 0) {
-                press_result /= (1 << (-press_exp_val));
+        }
+        // Handle enter key
+        else if (rx_byte == '\r' || rx_byte == '\n') {
+            echo_len = command_interface_flush_echo(ctx, echo, echo_len);
+            if (ctx->line_len > 0) {
+                ctx->line[ctx->line_len] = '\0';
+                uart_tx_write_string(ctx->huart, "\r\n");
+
+                // Process command
+                command_interface_handle_command(ctx, ctx->line);
+
+                // Reset buffer
+                ctx->line_len = 0;
+                memset(ctx->line, 0, CMD_BUFFER_SIZE);
+
+                // The rest of the chunk belongs to the binary protocol
+                if (ctx->mode != CONSOLE_MODE_TEXT) {
+                    return i + 1;
+                }
             }
-            
-            if (press_sign) press_result = -press_result;
-            press_decoded = press_result;
+            uart_tx_write_string(ctx->huart, "> ");
+        }
+        // Handle regular characters (echoed back once per chunk)
+        else if (ctx->line_len < CMD_BUFFER_SIZE - 1 && rx_byte >= 32 && rx_byte <= 126) {
+            ctx->line[ctx->line_len++] = rx_byte;
+            echo[echo_len++] = rx_byte;
         }
-        
-        snprintf(response, sizeof(response), "Pressure: %.2f Pa\r\n", press_decoded);
-    } else {
-        snprintf(response, sizeof(response), "Error reading pressure from BME680\r\n");
     }
-    
-    command_interface_send_response(response);
+    command_interface_flush_echo(ctx, echo, echo_len);
+    return len;
 }
 
-// Command handler for reading humidity
-void cmd_read_humidity(void)
+// Hand received bytes to the line editor or the binary protocol
+static void command_interface_receive(console_ctx_t* ctx, const uint8_t* data, uint16_t len)
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response(response);
-        return;
-    }
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        // Decode the IEEE 754 value from memory
-        uint32_t hum_mem = *(uint32_t*)&sensor_data.humidity;
-        uint32_t hum_sign = (hum_mem >> 31) & 0x1;
-        uint32_t hum_exp = (hum_mem >> 23) & 0xFF;
-        uint32_t hum_mant = hum_mem & 0x7FFFFF;
-        
-        float hum_decoded = 0.0f;
-        if (hum_exp != 0 && hum_exp != 0xFF) {
-            int hum_exp_val = (int)hum_exp - 127;
-            float hum_result = 1.0f;
-            
-            for (int i = 22; i >= 0; i--) {
-                if (hum_mant & (1 << i)) {
-                    hum_result += 1.0f / (1 << (23 - i));
-                }
-            }
-            
-            if (hum_exp_val > 0) {
-                hum_result *= (1 << hum_exp_val);
-            } else if (hum_exp_val < 0) {
-                hum_result /= (1 << (-hum_exp_val));
-            }
-            
-            if (hum_sign) hum_result = -hum_result;
-            hum_decoded = hum_result;
+    while (len > 0) {
+        uint16_t used;
+
+        if (ctx->mode == CONSOLE_MODE_BINARY) {
+            used = host_protocol_feed(ctx, data, len);
+        } else {
+            used = command_interface_feed(ctx, data, len);
         }
-        
-        snprintf(response, sizeof(response), "Humidity: %.2f%%\r\n", hum_decoded);
-    } else {
-        snprintf(response, sizeof(response), "Error reading humidity from BME680\r\n");
+        data += used;
+        len -= used;
     }
-    
-    command_interface_send_response(response);
 }
 
-// Command handler for testing sensor
-void cmd_test_sensor(void)
+// Switch a console between the text console and the binary protocol
+void command_interface_set_mode(console_ctx_t* ctx, uint8_t mode)
 {
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        command_interface_send_response("Error: BME680 sensor not available\r\n");
-        return;
+    ctx->mode = mode;
+    ctx->line_len = 0;
+    memset(ctx->line, 0, CMD_BUFFER_SIZE);
+    host_protocol_reset(ctx);
+
+    if (mode == CONSOLE_MODE_TEXT) {
+        uart_tx_write_string(ctx->huart, "> ");
     }
-    
-    bme680_test_sensor();
 }
 
-// Command handler for mathematical operations
-void cmd_math_operation(char* command)
+// Process incoming commands on every console
+void command_interface_process(void)
 {
-    char* operation = strtok(command, " ");
-    char* num1_str = strtok(NULL, " ");
-    char* num2_str = strtok(NULL, " ");
-    char response[128];
-    
-    if (num1_str == NULL || num2_str == NULL) {
-        command_interface_send_response("Usage: <operation> <num1> <num2>\r\n");
-        return;
-    }
-    
-    float num1 = atof(num1_str);
-    float num2 = atof(num2_str);
-    float result;
-    
-    if (strcmp(operation, "sum") == 0) {
-        result = num1 + num2;
-        snprintf(response, sizeof(response), "%.2f + %.2f = %.2f\r\n", num1, num2, result);
-    }
-    else if (strcmp(operation, "sub") == 0) {
-        result = num1 - num2;
-        snprintf(response, sizeof(response), "%.2f - %.2f = %.2f\r\n", num1, num2, result);
-    }
-    else if (strcmp(operation, "mul") == 0) {
-        result = num1 * num2;
-        snprintf(response, sizeof(response), "%.2f * %.2f = %.2f\r\n", num1, num2, result);
-    }
-    else if (strcmp(operation, "div") == 0) {
-        if (num2 != 0) {
-            result = num1 / num2;
-            snprintf(response, sizeof(response), "%.2f / %.2f = %.2f\r\n", num1, num2, result);
-        } else {
-            snprintf(response, sizeof(response), "Error: Division by zero\r\n");
+    uint8_t rx_chunk[CMD_RX_CHUNK_SIZE];
+    uint16_t rx_len;
+
+    // Drain everything DMA has received since the last pass
+    for (uint8_t i = 0; i < console_count; i++) {
+        while ((rx_len = uart_rx_read(consoles[i].huart, rx_chunk, sizeof(rx_chunk))) > 0) {
+            command_interface_receive(&consoles[i], rx_chunk, rx_len);
         }
     }
-    else {
-        snprintf(response, sizeof(response), "Unknown operation: %s\r\n", operation);
+}
+
+// Console task: runs when a UART reports received bytes
+static int8_t console_task_id = -1;
+
+static void console_task(uint32_t events)
+{
+    command_interface_process();
+}
+
+static void console_rx_notify(void)
+{
+    sched_wake(console_task_id);
+}
+
+static const sched_task_def_t console_task_def = {
+    .name = "console", .run = console_task, .period_ms = 0, .deadline_ms = 50, .priority = 1
+};
+
+// Run the console from the scheduler, woken by UART reception
+int8_t command_interface_register_task(void)
+{
+    console_task_id = sched_add_task(&console_task_def);
+    if (console_task_id < 0) {
+        return -1;
     }
-    
-    command_interface_send_response(response);
+    uart_rx_set_notify(console_rx_notify);
+    sched_wake(console_task_id); // Bytes may have arrived during boot
+    return 0;
 }
 
-// Show help menu for USART4
-void command_interface_show_help_usart4(void)
+// Number of required and optional arguments in a usage schema
+static void console_schema_limits(const char* args, int* required, int* optional)
 {
-    command_interface_send_response_usart4("\r\n=== Available Commands (USART4) ===\r\n");
-    command_interface_send_response_usart4("Sensor Commands:\r\n");
-    command_interface_send_response_usart4("  read temperature (rt) - Read temperature from BME680\r\n");
-    command_interface_send_response_usart4("  read pressure (rp)    - Read pressure from BME680\r\n");
-    command_interface_send_response_usart4("  read humidity (rh)    - Read humidity from BME680\r\n");
-    command_interface_send_response_usart4("  test sensor (ts)      - Test BME680 sensor\r\n");
-    command_interface_send_response_usart4("  raw registers (rr)    - Read raw BME680 registers\r\n");
-    command_interface_send_response_usart4("  raw adc (ra)          - Read raw BME680 ADC values\r\n");
-    command_interface_send_response_usart4("  calib data (cd)       - Check BME680 calibration data\r\n");
-    command_interface_send_response_usart4("  scan i2c (si)         - Scan I2C bus for devices\r\n");
-    command_interface_send_response_usart4("  lora broadcast (lb)   - Broadcast sensor data via LoRa\r\n");
-    command_interface_send_response_usart4("  lora config (lc)      - Show LoRa configuration\r\n");
-    command_interface_send_response_usart4("  lora test (lt)        - Test LoRa transmission\r\n");
-    command_interface_send_response_usart4("\r\nMath Operations:\r\n");
-    command_interface_send_response_usart4("  sum <num1> <num2>     - Add two numbers\r\n");
-    command_interface_send_response_usart4("  sub <num1> <num2>     - Subtract num2 from num1\r\n");
-    command_interface_send_response_usart4("  mul <num1> <num2>     - Multiply two numbers\r\n");
-    command_interface_send_response_usart4("  div <num1> <num2>     - Divide num1 by num2\r\n");
-    command_interface_send_response_usart4("\r\nSystem:\r\n");
-    command_interface_send_response_usart4("  help                  - Show this help menu\r\n");
-    command_interface_send_response_usart4("========================\r\n");
+    *required = 0;
+    *optional = 0;
+
+    for (const char* p = args; p != NULL && *p != '\0'; p++) {
+        if (*p == '<') {
+            (*required)++;
+        } else if (*p == '[') {
+            (*optional)++;
+        }
+    }
 }
 
-// Handle incoming commands for USART4
-void command_interface_handle_command_usart4(char* command)
+// Handle incoming commands
+void command_interface_handle_command(console_ctx_t* ctx, char* command)
 {
-    char response[256];
-    
+    const console_command_t* cmd = NULL;
+    char* argv[CONSOLE_MAX_ARGS];
+    char* args;
+    char* token;
+    int argc = 1;
+    int required;
+    int optional;
+    size_t len;
+
     // Check if system is started
-    if (!system_started_usart4) {
+    if (!ctx->started) {
         if (strcmp(command, "start") == 0) {
-            system_started_usart4 = 1;
-            command_interface_send_response_usart4("System started! Type 'help' for available commands.\r\n");
-            command_interface_send_response_usart4("> ");
-            return;
+            ctx->started = 1;
+            console_write(ctx, "System started! Type 'help' for available commands.\r\n");
+            console_write(ctx, "> ");
         } else {
-            command_interface_send_response_usart4("Please type 'start' to begin.\r\n");
-            return;
+            console_write(ctx, "Please type 'start' to begin.\r\n");
         }
+        return;
     }
-    
-    // Parse commands (full and abbreviated versions)
-    if (strcmp(command, "read temperature") == 0 || strcmp(command, "rt") == 0) {
-        cmd_read_temperature_usart4();
-    }
-    else if (strcmp(command, "read pressure") == 0 || strcmp(command, "rp") == 0) {
-        cmd_read_pressure_usart4();
-    }
-    else if (strcmp(command, "read humidity") == 0 || strcmp(command, "rh") == 0) {
-        cmd_read_humidity_usart4();
-    }
-    else if (strcmp(command, "test sensor") == 0 || strcmp(command, "ts") == 0) {
-        cmd_test_sensor_usart4();
-    }
-    else if (strcmp(command, "raw registers") == 0 || strcmp(command, "rr") == 0) {
-        bme680_read_raw_registers();
-    }
-    else if (strcmp(command, "raw adc") == 0 || strcmp(command, "ra") == 0) {
-        bme680_read_raw_adc_values();
-    }
-    else if (strcmp(command, "calib data") == 0 || strcmp(command, "cd") == 0) {
-        bme680_check_calibration_data();
-    }
-    else if (strcmp(command, "scan i2c") == 0 || strcmp(command, "si") == 0) {
-        i2c_scan_bus();
-    }
-    else if (strcmp(command, "lora broadcast") == 0 || strcmp(command, "lb") == 0) {
-        cmd_lora_broadcast_usart4();
-    }
-    else if (strcmp(command, "lora config") == 0 || strcmp(command, "lc") == 0) {
-        lora_print_config();
-    }
-    else if (strcmp(command, "lora test") == 0 || strcmp(command, "lt") == 0) {
-        lora_test_transmission();
-    }
-    else if (strcmp(command, "lora scan") == 0 || strcmp(command, "ls") == 0) {
-        lora_scan_signals(5000); // 5 second scan
-    }
-    else if (strcmp(command, "lora monitor") == 0 || strcmp(command, "lm") == 0) {
-        lora_start_monitoring();
-    }
-    else if (strcmp(command, "lora stop") == 0 || strcmp(command, "lst") == 0) {
-        lora_stop_monitoring();
-    }
-    else if (strcmp(command, "lora rssi") == 0 || strcmp(command, "lr") == 0) {
-        lora_get_rssi();
-    }
-    else if (strcmp(command, "lora redetect") == 0 || strcmp(command, "lrd") == 0) {
-        lora_force_redetect();
-    }
-    else if (strncmp(command, "sum ", 4) == 0) {
-        cmd_math_operation_usart4(command);
+
+    // Names are one or two words: try the two-word form first
+    len = strcspn(command, " ");
+    if (command[len] == ' ') {
+        size_t len2 = len + 1 + strcspn(&command[len + 1], " ");
+        cmd = console_lookup(command, len2);
+        if (cmd != NULL) {
+            len = len2;
+        }
     }
-    else if (strncmp(command, "sub ", 4) == 0) {
-        cmd_math_operation_usart4(command);
+    if (cmd == NULL) {
+        cmd = console_lookup(command, len);
     }
-    else if (strncmp(command, "mul ", 4) == 0) {
-        cmd_math_operation_usart4(command);
+    if (cmd == NULL) {
+        console_printf(ctx, "Unknown command: %s\r\nType 'help' for available commands.\r\n", command);
+        return;
     }
-    else if (strncmp(command, "div ", 4) == 0) {
-        cmd_math_operation_usart4(command);
+
+    // argv[0] is the command as typed, the rest are space-separated arguments
+    args = &command[len];
+    if (*args != '\0') {
+        *args++ = '\0';
     }
-    else if (strcmp(command, "help") == 0) {
-        command_interface_show_help_usart4();
+    argv[0] = command;
+    token = strtok(args, " ");
+    while (token != NULL && argc < CONSOLE_MAX_ARGS) {
+        argv[argc++] = token;
+        token = strtok(NULL, " ");
     }
-    else {
-        snprintf(response, sizeof(response), "Unknown command: %s\r\nType 'help' for available commands.\r\n", command);
-        command_interface_send_response_usart4(response);
+
+    console_schema_limits(cmd->args, &required, &optional);
+    if (token != NULL || argc - 1 < required || argc - 1 > required + optional) {
+        console_printf(ctx, "Usage: %s %s\r\n", cmd->name, cmd->args ? cmd->args : "");
+        return;
     }
-}
 
-// USART4 Command handlers
+    cmd->handler(ctx, argc, argv);
+}
 
-// Command handler for reading temperature (USART4)
-void cmd_read_temperature_usart4(void)
+// Write text to every sink of a console (binary-mode ports only take frames)
+void console_write(console_ctx_t* ctx, const char* text)
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response_usart4(response);
-        return;
-    }
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        snprintf(response, sizeof(response), "Temperature: %.2f°C\r\n", sensor_data.temperature);
-    } else {
-        snprintf(response, sizeof(response), "Error reading temperature from BME680\r\n");
+    uint16_t len = strlen(text);
+
+    for (uint8_t i = 0; i < console_count; i++) {
+        if ((ctx->sink_mask & (1u << i)) && consoles[i].mode == CONSOLE_MODE_TEXT) {
+            uart_tx_write(consoles[i].huart, (const uint8_t*)text, len);
+        }
     }
-    
-    command_interface_send_response_usart4(response);
 }
 
-// Command handler for reading pressure (USART4)
-void cmd_read_pressure_usart4(void)
+// Format once (fmt.c, no float support), then write the result to every sink of a console
+void console_printf(console_ctx_t* ctx, const char* format, ...)
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response_usart4(response);
-        return;
-    }
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        snprintf(response, sizeof(response), "Pressure: %.2f Pa\r\n", sensor_data.pressure);
-    } else {
-        snprintf(response, sizeof(response), "Error reading pressure from BME680\r\n");
+    char buffer[CONSOLE_FORMAT_SIZE];
+    va_list args;
+
+    va_start(args, format);
+    fmt_vformat(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    console_write(ctx, buffer);
+}
+
+// Send text to every text-mode console port (boot and driver messages)
+void command_interface_broadcast(const char* text)
+{
+    uint16_t len = strlen(text);
+
+    for (uint8_t i = 0; i < console_count; i++) {
+        if (consoles[i].mode == CONSOLE_MODE_TEXT) {
+            uart_tx_write(consoles[i].huart, (const uint8_t*)text, len);
+        }
     }
-    
-    command_interface_send_response_usart4(response);
 }
 
-// Command handler for reading humidity (USART4)
-void cmd_read_humidity_usart4(void)
+// Print the help line of one command. The usage is written piece by piece,
+// so no buffer limits its length; short ones are padded to a column.
+static void console_print_usage(console_ctx_t* ctx, const console_command_t* cmd)
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response_usart4(response);
-        return;
+    static const char pad[] = "                     ";  // Usage column width
+    uint16_t len = strlen(cmd->name);
+
+    console_printf(ctx, "  %s", cmd->name);
+    if (cmd->alias != NULL) {
+        console_printf(ctx, " (%s)", cmd->alias);
+        len += strlen(cmd->alias) + 3;
     }
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        snprintf(response, sizeof(response), "Humidity: %.2f%%\r\n", sensor_data.humidity);
-    } else {
-        snprintf(response, sizeof(response), "Error reading humidity from BME680\r\n");
+    if (cmd->args != NULL) {
+        console_printf(ctx, " %s", cmd->args);
+        len += strlen(cmd->args) + 1;
     }
-    
-    command_interface_send_response_usart4(response);
+    console_printf(ctx, "%s - %s\r\n", (len < sizeof(pad) - 1) ? &pad[len] : "", cmd->help);
 }
 
-// Command handler for testing sensor (USART4)
-void cmd_test_sensor_usart4(void)
+// Show help menu, generated from the registered tables
+static void cmd_help(console_ctx_t* ctx, int argc, char* argv[])
 {
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        command_interface_send_response_usart4("Error: BME680 sensor not available\r\n");
+    if (argc > 1) {
+        const console_command_t* cmd = console_find_command(argv[1]);
+        if (cmd == NULL) {
+            console_printf(ctx, "Unknown command: %s\r\n", argv[1]);
+        } else {
+            console_print_usage(ctx, cmd);
+        }
         return;
     }
-    
-    // Create a custom test function for USART4
-    struct bme68x_data sensor_data;
-    char test_msg[256];
-    
-    snprintf(test_msg, sizeof(test_msg), "Testing BME680 sensor (USART4)...\r\n");
-    command_interface_send_response_usart4(test_msg);
-    
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        snprintf(test_msg, sizeof(test_msg), 
-                 "Test successful!\r\nTemperature: %.2f°C\r\nPressure: %.2f Pa\r\nHumidity: %.2f%%\r\n",
-                 sensor_data.temperature, sensor_data.pressure, sensor_data.humidity);
-    } else {
-        snprintf(test_msg, sizeof(test_msg), "Test failed! Error reading sensor data.\r\n");
-    }
-    
-    command_interface_send_response_usart4(test_msg);
+
+    console_printf(ctx, "\r\n=== Available Commands (%s) ===\r\n", ctx->name);
+    for (uint8_t g = 0; g < console_group_count; g++) {
+        console_printf(ctx, "%s%s:\r\n", (g > 0) ? "\r\n" : "", console_groups[g].name);
+        for (uint8_t i = 0; i < console_groups[g].count; i++) {
+            console_print_usage(ctx, &console_groups[g].table[i]);
+        }
+    }
+    console_write(ctx, "========================\r\n");
 }
 
-// Command handler for mathematical operations (USART4)
-void cmd_math_operation_usart4(char* command)
+// Command handler for mathematical operations
+static void cmd_math_operation(console_ctx_t* ctx, int argc, char* argv[])
 {
-    char* operation = strtok(command, " ");
-    char* num1_str = strtok(NULL, " ");
-    char* num2_str = strtok(NULL, " ");
-    char response[128];
-    
-    if (num1_str == NULL || num2_str == NULL) {
-        command_interface_send_response_usart4("Usage: <operation> <num1> <num2>\r\n");
-        return;
-    }
-    
-    float num1 = atof(num1_str);
-    float num2 = atof(num2_str);
+    const char* operation = argv[0];
+    float num1 = atof(argv[1]);
+    float num2 = atof(argv[2]);
     float result;
-    
+    const char* symbol;
+    char text[64];
+    fmt_t line;
+
     if (strcmp(operation, "sum") == 0) {
+        symbol = " + ";
         result = num1 + num2;
-        snprintf(response, sizeof(response), "%.2f + %.2f = %.2f\r\n", num1, num2, result);
     }
     else if (strcmp(operation, "sub") == 0) {
+        symbol = " - ";
         result = num1 - num2;
-        snprintf(response, sizeof(response), "%.2f - %.2f = %.2f\r\n", num1, num2, result);
     }
     else if (strcmp(operation, "mul") == 0) {
+        symbol = " * ";
         result = num1 * num2;
-        snprintf(response, sizeof(response), "%.2f * %.2f = %.2f\r\n", num1, num2, result);
     }
     else if (strcmp(operation, "div") == 0) {
-        if (num2 != 0) {
-            result = num1 / num2;
-            snprintf(response, sizeof(response), "%.2f / %.2f = %.2f\r\n", num1, num2, result);
-        } else {
-            snprintf(response, sizeof(response), "Error: Division by zero\r\n");
+        if (num2 == 0) {
+            console_write(ctx, "Error: Division by zero\r\n");
+            return;
         }
+        symbol = " / ";
+        result = num1 / num2;
     }
     else {
-        snprintf(response, sizeof(response), "Unknown operation: %s\r\n", operation);
+        console_printf(ctx, "Unknown operation: %s\r\n", operation);
+        return;
+    }
+
+    fmt_init(&line, text, sizeof(text));
+    fmt_float(&line, num1, 2);
+    fmt_str(&line, symbol);
+    fmt_float(&line, num2, 2);
+    fmt_str(&line, " = ");
+    fmt_float(&line, result, 2);
+    fmt_str(&line, "\r\n");
+    console_write(ctx, text);
+}
+
+// Command handler for UART transmit queue statistics
+static void cmd_uart_stats(console_ctx_t* ctx, int argc, char* argv[])
+{
+    uart_tx_stats_t stats;
+
+    console_write(ctx, "=== UART TX Queues ===\r\n");
+    for (uint8_t i = 0; i < console_count; i++) {
+        if (uart_tx_get_stats(consoles[i].huart, &stats) != 0) {
+            continue;
+        }
+        console_printf(ctx,
+                       "%s: policy=%s queued=%lu dropped=%lu pending=%u high-water=%u/%u rx-overflow=%lu\r\n",
+                       consoles[i].name, uart_tx_policy_name(stats.policy), stats.bytes_queued, stats.bytes_dropped, stats.pending,
+                       stats.high_water, UART_TX_RING_SIZE - 1, uart_rx_get_overflows(consoles[i].huart));
     }
-    
-    command_interface_send_response_usart4(response);
 }
 
-// Command handler for LoRa broadcast (USART2)
-void cmd_lora_broadcast(void)
+// Command handler for the full-queue policy of a port
+static void cmd_uart_policy(console_ctx_t* ctx, int argc, char* argv[])
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response(response);
+    uart_tx_policy_t policy;
+
+    for (policy = UART_TX_POLICY_BLOCK; policy <= UART_TX_POLICY_TRUNCATE; policy++) {
+        if (strcmp(argv[2], uart_tx_policy_name(policy)) == 0) {
+            break;
+        }
+    }
+    if (policy > UART_TX_POLICY_TRUNCATE) {
+        console_printf(ctx, "Unknown policy: %s\r\n", argv[2]);
         return;
     }
-    
-    // Read sensor data
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        snprintf(response, sizeof(response), 
-                 "Broadcasting sensor data via LoRa...\r\nTemperature: %.2f°C, Pressure: %.2f Pa, Humidity: %.2f%%\r\n",
-                 sensor_data.temperature, sensor_data.pressure, sensor_data.humidity);
-        command_interface_send_response(response);
-        
-        // Send via LoRa
-        if (lora_send_sensor_data(sensor_data.temperature, sensor_data.pressure, sensor_data.humidity) == 0) {
-            command_interface_send_response("✓ LoRa broadcast successful\r\n");
-        } else {
-            command_interface_send_response("✗ LoRa broadcast failed\r\n");
+
+    for (uint8_t i = 0; i < console_count; i++) {
+        if (strcasecmp(argv[1], consoles[i].name) == 0) {
+            uart_tx_set_policy(consoles[i].huart, policy);
+            console_printf(ctx, "%s: full-queue policy %s\r\n", consoles[i].name, uart_tx_policy_name(policy));
+            return;
         }
-    } else {
-        snprintf(response, sizeof(response), "Error reading sensor data for LoRa broadcast\r\n");
-        command_interface_send_response(response);
     }
+
+    console_printf(ctx, "Unknown port: %s\r\n", argv[1]);
 }
 
-// Command handler for LoRa broadcast (USART4)
-void cmd_lora_broadcast_usart4(void)
+// Command handler for mirroring a console's responses to another port
+static void cmd_mirror(console_ctx_t* ctx, int argc, char* argv[])
 {
-    struct bme68x_data sensor_data;
-    char response[128];
-    
-    // Check if sensor is available
-    if (bme680_check_sensor_presence() != BME68X_OK) {
-        snprintf(response, sizeof(response), "Error: BME680 sensor not available\r\n");
-        command_interface_send_response_usart4(response);
+    uint8_t self = (uint8_t)(ctx - consoles);
+
+    if (strcmp(argv[1], "off") == 0) {
+        ctx->sink_mask = (uint8_t)(1u << self);
+        console_write(ctx, "Mirroring disabled\r\n");
         return;
     }
-    
-    // Read sensor data
-    if (bme680_read_sensor_data(&sensor_data) == BME68X_OK) {
-        snprintf(response, sizeof(response), 
-                 "Broadcasting sensor data via LoRa...\r\nTemperature: %.2f°C, Pressure: %.2f Pa, Humidity: %.2f%%\r\n",
-                 sensor_data.temperature, sensor_data.pressure, sensor_data.humidity);
-        command_interface_send_response_usart4(response);
-        
-        // Send via LoRa
-        if (lora_send_sensor_data(sensor_data.temperature, sensor_data.pressure, sensor_data.humidity) == 0) {
-            command_interface_send_response_usart4("✓ LoRa broadcast successful\r\n");
-        } else {
-            command_interface_send_response_usart4("✗ LoRa broadcast failed\r\n");
+
+    for (uint8_t i = 0; i < console_count; i++) {
+        if (strcasecmp(argv[1], consoles[i].name) == 0) {
+            ctx->sink_mask |= (uint8_t)(1u << i);
+            console_printf(ctx, "Responses from %s are mirrored to %s\r\n", ctx->name, consoles[i].name);
+            return;
         }
-    } else {
-        snprintf(response, sizeof(response), "Error reading sensor data for LoRa broadcast\r\n");
-        command_interface_send_response_usart4(response);
     }
-}
\ No newline at end of file
+
+    console_printf(ctx, "Unknown port: %s\r\n", argv[1]);
+}
+
+// Command handler for the binary host protocol mode
+static void cmd_protocol(console_ctx_t* ctx, int argc, char* argv[])
+{
+    host_protocol_stats_t stats;
+
+    if (argc < 2) {
+        host_protocol_get_stats(ctx, &stats);
+        console_printf(ctx, "%s: text mode, frames rx=%lu tx=%lu crc-errors=%lu framing-errors=%lu\r\n",
+                       ctx->name, stats.frames_rx, stats.frames_tx, stats.crc_errors, stats.framing_errors);
+        return;
+    }
+
+    if (strcmp(argv[1], "binary") == 0) {
+        console_write(ctx, "Binary protocol enabled (send SET_MODE to return)\r\n");
+        command_interface_set_mode(ctx, CONSOLE_MODE_BINARY);
+    } else if (strcmp(argv[1], "text") != 0) {
+        console_printf(ctx, "Unknown mode: %s\r\n", argv[1]);
+    }
+}
@@ -0,0 +1,321 @@
+#include "fmt.h"
+#include <stddef.h>
+
+static const uint32_t fmt_pow10[10] = {
+    1000000000u, 100000000u, 10000000u, 1000000u, 100000u,
+    10000u, 1000u, 100u, 10u, 1u
+};
+
+static const char fmt_hex_digits[] = "0123456789ABCDEF";
+
+// Decimal digits of value into out (no terminator), returns the digit count
+static uint8_t fmt_digits(uint32_t value, char* out)
+{
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < 10; i++) {
+        char digit = '0';
+
+        while (value >= fmt_pow10[i]) {
+            value -= fmt_pow10[i];
+            digit++;
+        }
+        if (digit != '0' || n > 0 || i == 9) {
+            out[n++] = digit;
+        }
+    }
+    return n;
+}
+
+// Hex digits of value into out (lower or upper case), returns the digit count
+static uint8_t fmt_hex_of(uint32_t value, char* out, uint8_t upper)
+{
+    uint8_t n = 0;
+
+    for (int8_t shift = 28; shift >= 0; shift -= 4) {
+        uint8_t nibble = (value >> shift) & 0x0F;
+
+        if (nibble != 0 || n > 0 || shift == 0) {
+            char c = fmt_hex_digits[nibble];
+            out[n++] = (!upper && c >= 'A') ? (char)(c + ('a' - 'A')) : c;
+        }
+    }
+    return n;
+}
+
+void fmt_init(fmt_t* f, char* buf, uint16_t size)
+{
+    f->buf = buf;
+    f->size = size;
+    f->len = 0;
+    f->truncated = 0;
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+}
+
+void fmt_char(fmt_t* f, char c)
+{
+    if (f->len + 1 >= f->size) {
+        f->truncated = 1;
+        return;
+    }
+    f->buf[f->len++] = c;
+    f->buf[f->len] = '\0';
+}
+
+// Append n characters
+static void fmt_put(fmt_t* f, const char* s, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        fmt_char(f, s[i]);
+    }
+}
+
+// Append the pad character n times
+static void fmt_fill(fmt_t* f, char pad, int16_t n)
+{
+    while (n-- > 0) {
+        fmt_char(f, pad);
+    }
+}
+
+void fmt_str(fmt_t* f, const char* s)
+{
+    while (*s != '\0') {
+        fmt_char(f, *s++);
+    }
+}
+
+void fmt_str_pad(fmt_t* f, const char* s, uint8_t width)
+{
+    uint16_t start = f->len;
+
+    fmt_str(f, s);
+    fmt_fill(f, ' ', (int16_t)(width - (f->len - start)));
+}
+
+void fmt_u32(fmt_t* f, uint32_t value)
+{
+    char digits[10];
+    fmt_put(f, digits, fmt_digits(value, digits));
+}
+
+void fmt_i32(fmt_t* f, int32_t value)
+{
+    if (value < 0) {
+        fmt_char(f, '-');
+        fmt_u32(f, 0u - (uint32_t)value);
+    } else {
+        fmt_u32(f, (uint32_t)value);
+    }
+}
+
+void fmt_u32_pad(fmt_t* f, uint32_t value, uint8_t width, char pad)
+{
+    char digits[10];
+    uint8_t n = fmt_digits(value, digits);
+
+    fmt_fill(f, pad, (int16_t)(width - n));
+    fmt_put(f, digits, n);
+}
+
+void fmt_hex(fmt_t* f, uint32_t value, uint8_t digits)
+{
+    char hex[8];
+    uint8_t n = fmt_hex_of(value, hex, 1);
+
+    fmt_fill(f, '0', (int16_t)(digits - n));
+    fmt_put(f, hex, n);
+}
+
+void fmt_fixed(fmt_t* f, int32_t value, uint8_t decimals)
+{
+    char digits[10];
+    uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    uint8_t n = fmt_digits(magnitude, digits);
+
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    if (value < 0) {
+        fmt_char(f, '-');
+    }
+
+    // Integer part (at least one digit)
+    if (n > decimals) {
+        fmt_put(f, digits, n - decimals);
+    } else {
+        fmt_char(f, '0');
+    }
+
+    // Fraction, zero-filled on the left when value < 10^decimals
+    if (decimals > 0) {
+        fmt_char(f, '.');
+        if (n < decimals) {
+            fmt_fill(f, '0', decimals - n);
+            fmt_put(f, digits, n);
+        } else {
+            fmt_put(f, &digits[n - decimals], decimals);
+        }
+    }
+}
+
+// Two soft-float conversions instead of printf's dtoa: the integer part and
+// the rounded fraction are formatted separately, so large values still work.
+void fmt_float(fmt_t* f, float value, uint8_t decimals)
+{
+    uint32_t scale;
+    uint32_t whole;
+    uint32_t frac;
+    uint8_t negative = 0;
+
+    if (value != value) {
+        fmt_str(f, "nan");
+        return;
+    }
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    if (value < 0.0f) {
+        negative = 1;
+        value = -value;
+    }
+    if (value >= 4294967296.0f) {
+        fmt_str(f, negative ? "-inf" : "inf");
+        return;
+    }
+
+    scale = fmt_pow10[9 - decimals];
+    whole = (uint32_t)value;
+    frac = (uint32_t)((value - (float)whole) * (float)scale + 0.5f);
+    if (frac >= scale) {
+        whole++;
+        frac -= scale;
+    }
+
+    if (negative && (whole != 0 || frac != 0)) {
+        fmt_char(f, '-');
+    }
+    fmt_u32(f, whole);
+    if (decimals > 0) {
+        fmt_char(f, '.');
+        fmt_u32_pad(f, frac, decimals, '0');
+    }
+}
+
+uint16_t fmt_vformat(char* buf, uint16_t size, const char* format, va_list args)
+{
+    fmt_t f;
+
+    fmt_init(&f, buf, size);
+
+    while (*format != '\0') {
+        char digits[11];
+        const char* text = digits;
+        uint16_t n = 0;
+        uint8_t left = 0;
+        char pad = ' ';
+        uint8_t width = 0;
+        uint8_t is_long = 0;
+        uint8_t negative = 0;
+
+        if (*format != '%') {
+            fmt_char(&f, *format++);
+            continue;
+        }
+        format++;
+
+        // Flags, width and length
+        for (; *format == '-' || *format == '0'; format++) {
+            if (*format == '-') {
+                left = 1;
+            } else {
+                pad = '0';
+            }
+        }
+        for (; *format >= '0' && *format <= '9'; format++) {
+            width = (uint8_t)(width * 10 + (*format - '0'));
+        }
+        for (; *format == 'l' || *format == 'h'; format++) {
+            is_long |= (*format == 'l');
+        }
+
+        switch (*format) {
+            case 'd':
+            case 'i': {
+                long value = is_long ? va_arg(args, long) : va_arg(args, int);
+                negative = (value < 0);
+                n = fmt_digits(negative ? 0u - (uint32_t)value : (uint32_t)value, digits);
+                break;
+            }
+            case 'u':
+                n = fmt_digits(is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int), digits);
+                break;
+            case 'x':
+            case 'X':
+                n = fmt_hex_of(is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int),
+                               digits, *format == 'X');
+                break;
+            case 'c':
+                digits[0] = (char)va_arg(args, int);
+                n = 1;
+                break;
+            case 's':
+                text = va_arg(args, const char*);
+                if (text == NULL) {
+                    text = "(null)";
+                }
+                while (text[n] != '\0') {
+                    n++;
+                }
+                break;
+            case '%':
+                digits[0] = '%';
+                n = 1;
+                break;
+            default:
+                // Unsupported conversion: emit it unchanged
+                fmt_char(&f, '%');
+                if (*format == '\0') {
+                    return f.len;
+                }
+                fmt_char(&f, *format++);
+                continue;
+        }
+        format++;
+
+        // Sign goes before zero padding, after space padding
+        if (left) {
+            if (negative) {
+                fmt_char(&f, '-');
+            }
+            fmt_put(&f, text, n);
+            fmt_fill(&f, ' ', (int16_t)(width - n - negative));
+        } else if (pad == '0') {
+            if (negative) {
+                fmt_char(&f, '-');
+            }
+            fmt_fill(&f, '0', (int16_t)(width - n - negative));
+            fmt_put(&f, text, n);
+        } else {
+            fmt_fill(&f, ' ', (int16_t)(width - n - negative));
+            if (negative) {
+                fmt_char(&f, '-');
+            }
+            fmt_put(&f, text, n);
+        }
+    }
+    return f.len;
+}
+
+uint16_t fmt_format(char* buf, uint16_t size, const char* format, ...)
+{
+    va_list args;
+    uint16_t len;
+
+    va_start(args, format);
+    len = fmt_vformat(buf, size, format, args);
+    va_end(args);
+    return len;
+}
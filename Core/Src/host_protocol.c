@@ -0,0 +1,420 @@
+#include "host_protocol.h"
+#include "bme680_interface.h"
+#include "lora_interface.h"
+#include "sensor_stream.h"
+#include "uart_tx.h"
+#include <string.h>
+
+// Per-port receive state and counters
+typedef struct {
+    uint8_t rx[HOST_PROTO_MAX_ENCODED];
+    uint16_t rx_len;
+    uint8_t rx_overflow;
+    uint8_t tx_seq;
+    uint8_t read_pending;       // READ_SENSOR waiting for the conversion
+    uint8_t read_seq;
+    host_protocol_stats_t stats;
+} host_port_t;
+
+static host_port_t host_ports[CONSOLE_MAX_PORTS];
+
+// CRC16-CCITT (poly 0x1021, init 0xFFFF), one nibble per table lookup
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t host_protocol_crc16(const uint8_t* data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// COBS encode, returns the encoded length (at most len + len / 254 + 1, no delimiter)
+uint16_t host_protocol_cobs_encode(const uint8_t* in, uint16_t len, uint8_t* out)
+{
+    uint16_t write = 1;
+    uint16_t code_pos = 0;
+    uint8_t code = 1;
+
+    for (uint16_t read = 0; read < len; read++) {
+        if (in[read] == 0) {
+            out[code_pos] = code;
+            code_pos = write++;
+            code = 1;
+        } else {
+            out[write++] = in[read];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = write++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    return write;
+}
+
+// COBS decode (no delimiter), returns the decoded length or -1 if malformed
+int16_t host_protocol_cobs_decode(const uint8_t* in, uint16_t len, uint8_t* out)
+{
+    uint16_t read = 0;
+    uint16_t write = 0;
+
+    while (read < len) {
+        uint8_t code = in[read];
+
+        if (code == 0 || read + code > len) {
+            return -1;
+        }
+        read++;
+        for (uint8_t i = 1; i < code; i++) {
+            if (in[read] == 0) {
+                return -1;
+            }
+            out[write++] = in[read++];
+        }
+        if (code != 0xFF && read < len) {
+            out[write++] = 0;
+        }
+    }
+    return (int16_t)write;
+}
+
+void host_tlv_init(host_tlv_t* tlv)
+{
+    tlv->len = 0;
+    tlv->overflow = 0;
+}
+
+// Append one TLV with a little-endian value of size bytes
+static void host_tlv_put(host_tlv_t* tlv, uint8_t tag, uint32_t value, uint8_t size)
+{
+    if (tlv->len + 2 + size > HOST_PROTO_MAX_PAYLOAD) {
+        tlv->overflow = 1;
+        return;
+    }
+
+    tlv->data[tlv->len++] = tag;
+    tlv->data[tlv->len++] = size;
+    for (uint8_t i = 0; i < size; i++) {
+        tlv->data[tlv->len++] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+void host_tlv_put_u8(host_tlv_t* tlv, uint8_t tag, uint8_t value)
+{
+    host_tlv_put(tlv, tag, value, 1);
+}
+
+void host_tlv_put_u16(host_tlv_t* tlv, uint8_t tag, uint16_t value)
+{
+    host_tlv_put(tlv, tag, value, 2);
+}
+
+void host_tlv_put_u32(host_tlv_t* tlv, uint8_t tag, uint32_t value)
+{
+    host_tlv_put(tlv, tag, value, 4);
+}
+
+// Append the selected fields of a sample (timestamp and sensor always included)
+void host_tlv_put_sample(host_tlv_t* tlv, const bme680_sample_t* sample, uint8_t fields)
+{
+    host_tlv_put_u32(tlv, HOST_TAG_TIMESTAMP, sample->timestamp);
+    host_tlv_put_u8(tlv, HOST_TAG_SENSOR, sample->sensor_id);
+    if (fields & HOST_FIELD_TEMPERATURE) {
+        host_tlv_put_u16(tlv, HOST_TAG_TEMPERATURE, (uint16_t)sample->temperature);
+    }
+    if (fields & HOST_FIELD_PRESSURE) {
+        host_tlv_put_u32(tlv, HOST_TAG_PRESSURE, sample->pressure);
+    }
+    if (fields & HOST_FIELD_HUMIDITY) {
+        host_tlv_put_u16(tlv, HOST_TAG_HUMIDITY, sample->humidity);
+    }
+    if ((fields & HOST_FIELD_GAS) && (sample->status & BME68X_GASM_VALID_MSK)) {
+        host_tlv_put_u32(tlv, HOST_TAG_GAS, sample->gas_resistance);
+        host_tlv_put_u8(tlv, HOST_TAG_GAS_STEP, sample->gas_step);
+    }
+}
+
+// Find a TLV in a received payload, returns its value or NULL
+static const uint8_t* host_tlv_find(const uint8_t* payload, uint16_t len, uint8_t tag, uint8_t* size)
+{
+    uint16_t pos = 0;
+
+    while (pos + 2 <= len) {
+        uint8_t vlen = payload[pos + 1];
+        if (pos + 2 + vlen > len) {
+            return NULL;
+        }
+        if (payload[pos] == tag) {
+            *size = vlen;
+            return &payload[pos + 2];
+        }
+        pos += 2 + vlen;
+    }
+    return NULL;
+}
+
+// Forget any partial frame (on reset or mode switch)
+void host_protocol_reset(console_ctx_t* ctx)
+{
+    host_port_t* port = &host_ports[ctx->index];
+
+    port->rx_len = 0;
+    port->rx_overflow = 0;
+    port->read_pending = 0;
+}
+
+// Frame, encode and queue one message on the console's own UART
+int8_t host_protocol_send(console_ctx_t* ctx, uint8_t seq, uint8_t type, const host_tlv_t* tlv)
+{
+    uint8_t frame[HOST_PROTO_MAX_FRAME];
+    uint8_t encoded[HOST_PROTO_MAX_ENCODED + 1];
+    uint16_t len = 0;
+    uint16_t crc;
+
+    if (tlv != NULL && tlv->overflow) {
+        return -1;
+    }
+
+    frame[len++] = seq;
+    frame[len++] = type;
+    if (tlv != NULL) {
+        memcpy(&frame[len], tlv->data, tlv->len);
+        len += tlv->len;
+    }
+    crc = host_protocol_crc16(frame, len);
+    frame[len++] = (uint8_t)crc;
+    frame[len++] = (uint8_t)(crc >> 8);
+
+    len = host_protocol_cobs_encode(frame, len, encoded);
+    encoded[len++] = 0x00;
+
+    if (uart_tx_write(ctx->huart, encoded, len) != len) {
+        return -1;
+    }
+    host_ports[ctx->index].stats.frames_tx++;
+    return 0;
+}
+
+// Sequence number for unsolicited frames (samples) on this port
+uint8_t host_protocol_next_seq(console_ctx_t* ctx)
+{
+    return host_ports[ctx->index].tx_seq++;
+}
+
+void host_protocol_get_stats(console_ctx_t* ctx, host_protocol_stats_t* stats)
+{
+    *stats = host_ports[ctx->index].stats;
+}
+
+// Reply with an error code
+static void host_protocol_error(console_ctx_t* ctx, uint8_t seq, uint8_t code)
+{
+    host_tlv_t tlv;
+
+    host_tlv_init(&tlv);
+    host_tlv_put_u8(&tlv, HOST_TAG_ERROR, code);
+    host_protocol_send(ctx, seq, HOST_PROTO_ERROR | HOST_PROTO_RESPONSE, &tlv);
+}
+
+// Answer a READ_SENSOR request
+static void host_protocol_send_sample(console_ctx_t* ctx, uint8_t seq, const bme680_sample_t* sample)
+{
+    host_tlv_t tlv;
+
+    host_tlv_init(&tlv);
+    host_tlv_put_sample(&tlv, sample, HOST_FIELD_TPH | HOST_FIELD_GAS);
+    host_tlv_put_u8(&tlv, HOST_TAG_SENSOR_STATUS, sample->status);
+    host_protocol_send(ctx, seq, HOST_PROTO_READ_SENSOR | HOST_PROTO_RESPONSE, &tlv);
+}
+
+// Conversion for a READ_SENSOR request finished (called from the sensor task)
+static void host_protocol_read_done(int8_t rslt, const bme680_sample_t* sample, void* arg)
+{
+    console_ctx_t* ctx = arg;
+    host_port_t* port = &host_ports[ctx->index];
+
+    // Port reset or switched back to text meanwhile
+    if (!port->read_pending || ctx->mode != CONSOLE_MODE_BINARY) {
+        return;
+    }
+    port->read_pending = 0;
+
+    if (rslt != BME68X_OK) {
+        host_protocol_error(ctx, port->read_seq, HOST_ERR_SENSOR);
+        return;
+    }
+    host_protocol_send_sample(ctx, port->read_seq, sample);
+}
+
+// Execute one validated request
+static void host_protocol_dispatch(console_ctx_t* ctx, uint8_t seq, uint8_t type, const uint8_t* payload, uint16_t len)
+{
+    host_port_t* port = &host_ports[ctx->index];
+    host_tlv_t tlv;
+    bme680_sample_t sample;
+    lora_stats_t radio;
+    uart_tx_stats_t uart_stats;
+    const uint8_t* value;
+    uint8_t size;
+    int8_t rslt;
+
+    host_tlv_init(&tlv);
+
+    switch (type) {
+        case HOST_PROTO_PING:
+            break;
+
+        case HOST_PROTO_READ_SENSOR:
+            // From the sample cache, or from host_protocol_read_done() once
+            // a conversion ends
+            if (port->read_pending) {
+                host_protocol_error(ctx, seq, HOST_ERR_BUSY);
+                return;
+            }
+            value = host_tlv_find(payload, len, HOST_TAG_SENSOR, &size);
+            if (value != NULL && (size != 1 || value[0] >= bme680_sensor_count())) {
+                host_protocol_error(ctx, seq, HOST_ERR_BAD_PAYLOAD);
+                return;
+            }
+            rslt = bme680_get_sample((value != NULL) ? value[0] : 0, BME680_READ_MAX_AGE_MS, &sample,
+                                     host_protocol_read_done, ctx);
+            if (rslt == BME68X_OK) {
+                host_protocol_send_sample(ctx, seq, &sample);
+            } else if (rslt == BME680_W_PENDING) {
+                port->read_pending = 1;
+                port->read_seq = seq;
+            } else {
+                host_protocol_error(ctx, seq, HOST_ERR_SENSOR);
+            }
+            return;
+
+        case HOST_PROTO_RADIO_STATS:
+            lora_get_stats(&radio);
+            host_tlv_put_u8(&tlv, HOST_TAG_RADIO_STATE, (uint8_t)(radio.detected | (radio.initialized << 1)));
+            host_tlv_put_u32(&tlv, HOST_TAG_TX_OK, radio.tx_ok);
+            host_tlv_put_u32(&tlv, HOST_TAG_TX_FAILED, radio.tx_failed);
+            break;
+
+        case HOST_PROTO_GET_CONFIG:
+            lora_get_stats(&radio);
+            host_tlv_put_u32(&tlv, HOST_TAG_FREQUENCY, LORA_FREQUENCY_HZ);
+            host_tlv_put_u8(&tlv, HOST_TAG_SPREADING, radio.sf);
+            host_tlv_put_u16(&tlv, HOST_TAG_BANDWIDTH, LORA_BANDWIDTH);
+            host_tlv_put_u8(&tlv, HOST_TAG_TX_POWER, (uint8_t)radio.tx_power_dbm);
+            host_tlv_put_u8(&tlv, HOST_TAG_PORT, ctx->index);
+            host_tlv_put_u8(&tlv, HOST_TAG_MODE, ctx->mode);
+            break;
+
+        case HOST_PROTO_UART_STATS:
+            if (uart_tx_get_stats(ctx->huart, &uart_stats) == 0) {
+                host_tlv_put_u8(&tlv, HOST_TAG_PORT, ctx->index);
+                host_tlv_put_u32(&tlv, HOST_TAG_BYTES_QUEUED, uart_stats.bytes_queued);
+                host_tlv_put_u32(&tlv, HOST_TAG_BYTES_DROPPED, uart_stats.bytes_dropped);
+            }
+            break;
+
+        case HOST_PROTO_STREAM:
+            value = host_tlv_find(payload, len, HOST_TAG_RATE, &size);
+            if (value == NULL || size != 1) {
+                host_protocol_error(ctx, seq, HOST_ERR_BAD_PAYLOAD);
+                return;
+            }
+            if (*value == 0) {
+                sensor_stream_stop();
+            } else {
+                uint8_t rate = *value;
+                uint8_t fields = HOST_FIELD_TPH;
+                value = host_tlv_find(payload, len, HOST_TAG_FIELDS, &size);
+                if (value != NULL && size == 1) {
+                    fields = *value;
+                }
+                int8_t rslt = sensor_stream_start(ctx, rate, fields);
+                if (rslt != 0) {
+                    host_protocol_error(ctx, seq, (rslt == -2) ? HOST_ERR_SENSOR : HOST_ERR_BAD_PAYLOAD);
+                    return;
+                }
+            }
+            host_tlv_put_u8(&tlv, HOST_TAG_RATE, sensor_stream_get_rate());
+            break;
+
+        case HOST_PROTO_SET_MODE:
+            value = host_tlv_find(payload, len, HOST_TAG_MODE, &size);
+            if (value == NULL || size != 1 || *value > CONSOLE_MODE_BINARY) {
+                host_protocol_error(ctx, seq, HOST_ERR_BAD_PAYLOAD);
+                return;
+            }
+            // Acknowledge in the current mode, then switch
+            host_tlv_put_u8(&tlv, HOST_TAG_MODE, *value);
+            host_protocol_send(ctx, seq, type | HOST_PROTO_RESPONSE, &tlv);
+            command_interface_set_mode(ctx, *value);
+            return;
+
+        default:
+            host_protocol_error(ctx, seq, HOST_ERR_UNKNOWN_TYPE);
+            return;
+    }
+
+    host_protocol_send(ctx, seq, type | HOST_PROTO_RESPONSE, &tlv);
+}
+
+// Decode and check one delimited frame
+static void host_protocol_frame(console_ctx_t* ctx, host_port_t* port)
+{
+    uint8_t frame[HOST_PROTO_MAX_FRAME];
+    int16_t len = host_protocol_cobs_decode(port->rx, port->rx_len, frame);
+
+    if (len < 4) {
+        port->stats.framing_errors++;
+        return;
+    }
+
+    uint16_t crc = (uint16_t)(frame[len - 2] | (frame[len - 1] << 8));
+    if (host_protocol_crc16(frame, len - 2) != crc) {
+        port->stats.crc_errors++;
+        return;
+    }
+
+    port->stats.frames_rx++;
+    host_protocol_dispatch(ctx, frame[0], frame[1], &frame[2], len - 4);
+}
+
+// Consume received bytes in binary mode. Requests are handled as soon as their
+// delimiter arrives, so a host may pipeline several without waiting.
+// Returns the bytes used; stops early if a request switched the port to text.
+uint16_t host_protocol_feed(console_ctx_t* ctx, const uint8_t* data, uint16_t len)
+{
+    host_port_t* port = &host_ports[ctx->index];
+
+    for (uint16_t i = 0; i < len; i++) {
+        if (data[i] != 0x00) {
+            if (port->rx_len < sizeof(port->rx)) {
+                port->rx[port->rx_len++] = data[i];
+            } else {
+                port->rx_overflow = 1;
+            }
+            continue;
+        }
+
+        // Delimiter: a complete frame (empty frames are just resync markers)
+        if (port->rx_overflow) {
+            port->stats.framing_errors++;
+        } else if (port->rx_len > 0) {
+            host_protocol_frame(ctx, port);
+        }
+        port->rx_len = 0;
+        port->rx_overflow = 0;
+
+        if (ctx->mode != CONSOLE_MODE_BINARY) {
+            return i + 1;
+        }
+    }
+    return len;
+}
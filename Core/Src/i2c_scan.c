@@ -0,0 +1,251 @@
+#include "i2c_scan.h"
+#include "log.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include <string.h>
+
+extern I2C_HandleTypeDef hi2c1;
+
+// I2C1 lines (PA9 SCL, PA10 SDA), driven as open-drain GPIOs during recovery
+#define I2C_SCAN_PORT       GPIOA
+#define I2C_SCAN_SCL_PIN    GPIO_PIN_9
+#define I2C_SCAN_SDA_PIN    GPIO_PIN_10
+#define I2C_SCAN_HALF_US    5       // Recovery clock half period (100 kHz)
+
+static i2c_scan_result_t i2c_scan;
+static console_ctx_t* i2c_scan_reply;   // Console waiting for the running scan
+static int8_t i2c_scan_task_id = -1;
+
+static uint8_t i2c_scan_line_high(uint16_t pin)
+{
+    return HAL_GPIO_ReadPin(I2C_SCAN_PORT, pin) == GPIO_PIN_SET;
+}
+
+// Clock out a slave that holds SDA low: it stopped in the middle of a byte
+// and waits for the clocks it missed. Up to 9 SCL pulses until it lets go,
+// then a STOP; the peripheral is re-initialized around it. Returns the
+// pulses it took.
+static uint8_t i2c_scan_recover(void)
+{
+    GPIO_InitTypeDef gpio = { 0 };
+    uint8_t pulses = 0;
+
+    (void)HAL_I2C_DeInit(&hi2c1);
+    HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SCL_PIN | I2C_SCAN_SDA_PIN, GPIO_PIN_SET);
+    gpio.Pin = I2C_SCAN_SCL_PIN | I2C_SCAN_SDA_PIN;
+    gpio.Mode = GPIO_MODE_OUTPUT_OD;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(I2C_SCAN_PORT, &gpio);
+    timebase_delay_us(I2C_SCAN_HALF_US);
+
+    while (!i2c_scan_line_high(I2C_SCAN_SDA_PIN) && pulses < I2C_SCAN_RECOVERY_PULSES) {
+        HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SCL_PIN, GPIO_PIN_RESET);
+        timebase_delay_us(I2C_SCAN_HALF_US);
+        HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SCL_PIN, GPIO_PIN_SET);
+        timebase_delay_us(I2C_SCAN_HALF_US);
+        pulses++;
+    }
+
+    // STOP: SDA rises while SCL is high
+    HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SCL_PIN, GPIO_PIN_RESET);
+    timebase_delay_us(I2C_SCAN_HALF_US);
+    HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SDA_PIN, GPIO_PIN_RESET);
+    timebase_delay_us(I2C_SCAN_HALF_US);
+    HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SCL_PIN, GPIO_PIN_SET);
+    timebase_delay_us(I2C_SCAN_HALF_US);
+    HAL_GPIO_WritePin(I2C_SCAN_PORT, I2C_SCAN_SDA_PIN, GPIO_PIN_SET);
+    timebase_delay_us(I2C_SCAN_HALF_US);
+
+    // Back to I2C1 (the MSP init restores the alternate function)
+    (void)HAL_I2C_Init(&hi2c1);
+    return pulses;
+}
+
+// Check the idle bus levels and free a stuck SDA. Returns I2C_BUS_OK,
+// _RECOVERED, _SDA_STUCK or _SCL_STUCK; takes at most ~0.2 ms.
+uint8_t i2c_scan_bus_check(void)
+{
+    uint8_t pulses;
+
+    if (!i2c_scan_line_high(I2C_SCAN_SCL_PIN)) {
+        LOG_ERROR(I2C, "Bus stuck: SCL held low");
+        i2c_scan.bus = I2C_BUS_SCL_STUCK;
+        return i2c_scan.bus;
+    }
+    if (i2c_scan_line_high(I2C_SCAN_SDA_PIN)) {
+        i2c_scan.bus = I2C_BUS_OK;
+        return i2c_scan.bus;
+    }
+
+    pulses = i2c_scan_recover();
+    i2c_scan.recoveries++;
+    if (i2c_scan_line_high(I2C_SCAN_SDA_PIN)) {
+        LOG_WARN(I2C, "Bus recovered: SDA released after %u clock pulses", pulses);
+        i2c_scan.bus = I2C_BUS_RECOVERED;
+    } else {
+        LOG_ERROR(I2C, "Bus stuck: SDA still low after %u clock pulses", pulses);
+        i2c_scan.bus = I2C_BUS_SDA_STUCK;
+    }
+    return i2c_scan.bus;
+}
+
+// Start a background scan, restarting one that runs. A bus that is stuck
+// ends the scan at once with an empty bitmap.
+void i2c_scan_start(void)
+{
+    uint8_t bus = i2c_scan_bus_check();
+
+    memset(i2c_scan.present, 0, sizeof(i2c_scan.present));
+    i2c_scan.found = 0;
+    i2c_scan.duration_us = 0;
+    i2c_scan.next_addr = I2C_SCAN_FIRST_ADDR;
+    i2c_scan.scans++;
+    if (bus == I2C_BUS_SCL_STUCK || bus == I2C_BUS_SDA_STUCK) {
+        i2c_scan.state = I2C_SCAN_DONE;
+        i2c_scan.done_tick = HAL_GetTick();
+        return;
+    }
+    i2c_scan.state = I2C_SCAN_RUNNING;
+    sched_wake(i2c_scan_task_id);
+}
+
+// The address answered the last completed scan
+uint8_t i2c_scan_present(uint8_t address)
+{
+    return (address < 128) && (i2c_scan.present[address / 32] & (1u << (address % 32))) != 0;
+}
+
+void i2c_scan_get(i2c_scan_result_t* result)
+{
+    *result = i2c_scan;
+}
+
+// Print the scan result; deferred replies go over the prompt and show a new one
+static void i2c_scan_print(console_ctx_t* ctx, uint8_t deferred)
+{
+    static const char* const bus_names[] = {
+        "ok", "recovered", "SDA stuck low", "SCL stuck low", "fault during scan"
+    };
+
+    if (deferred) {
+        console_write(ctx, "\r");
+    }
+    console_printf(ctx, "I2C bus %s, %u device(s):", bus_names[i2c_scan.bus], i2c_scan.found);
+    for (uint8_t addr = I2C_SCAN_FIRST_ADDR; addr <= I2C_SCAN_LAST_ADDR; addr++) {
+        if (i2c_scan_present(addr)) {
+            console_printf(ctx, " 0x%02X", addr);
+        }
+    }
+    console_printf(ctx, "\r\nScanned %lu ms ago in %lu us of bus time (scan %lu, %lu recoveries)\r\n",
+                   HAL_GetTick() - i2c_scan.done_tick, i2c_scan.duration_us, i2c_scan.scans,
+                   i2c_scan.recoveries);
+    if (deferred) {
+        console_write(ctx, "> ");
+    }
+}
+
+// End the running scan and answer the console that asked for it
+static void i2c_scan_finish(void)
+{
+    i2c_scan.state = I2C_SCAN_DONE;
+    i2c_scan.done_tick = HAL_GetTick();
+    LOG_INFO(I2C, "Scan done: %u device(s) in %lu us", i2c_scan.found, i2c_scan.duration_us);
+    if (i2c_scan_reply != NULL) {
+        i2c_scan_print(i2c_scan_reply, 1);
+        i2c_scan_reply = NULL;
+    }
+}
+
+// Scan task: probes one batch of addresses per run, then yields to the other
+// tasks until it is run again
+static void i2c_scan_task(uint32_t events)
+{
+    uint64_t start_us = timebase_now_us();
+    HAL_StatusTypeDef status;
+
+    if (i2c_scan.state != I2C_SCAN_RUNNING) {
+        return;
+    }
+
+    for (uint8_t n = 0; n < I2C_SCAN_BATCH && i2c_scan.next_addr <= I2C_SCAN_LAST_ADDR; n++) {
+        uint8_t addr = i2c_scan.next_addr++;
+
+        status = HAL_I2C_IsDeviceReady(&hi2c1, addr << 1, 1, I2C_SCAN_TIMEOUT_MS);
+        if (status == HAL_OK) {
+            i2c_scan.present[addr / 32] |= 1u << (addr % 32);
+            i2c_scan.found++;
+        } else if (status == HAL_BUSY || (hi2c1.ErrorCode & ~(HAL_I2C_ERROR_AF | HAL_I2C_ERROR_TIMEOUT)) != 0 ||
+                   __HAL_I2C_GET_FLAG(&hi2c1, I2C_FLAG_BUSY)) {
+            // Not a NACK: the bus itself misbehaves. HAL_I2C_IsDeviceReady()
+            // reports a NACK on its last trial as HAL_I2C_ERROR_TIMEOUT, so
+            // that alone means absent; a hang leaves the bus busy after it.
+            LOG_ERROR(I2C, "Scan aborted at 0x%02X: status %d, error 0x%02X", addr, status,
+                      (unsigned)hi2c1.ErrorCode);
+            i2c_scan.duration_us += (uint32_t)(timebase_now_us() - start_us);
+            (void)i2c_scan_bus_check();
+            if (i2c_scan.bus == I2C_BUS_OK || i2c_scan.bus == I2C_BUS_RECOVERED) {
+                i2c_scan.bus = I2C_BUS_FAULT;
+            }
+            i2c_scan_finish();
+            return;
+        }
+    }
+    i2c_scan.duration_us += (uint32_t)(timebase_now_us() - start_us);
+
+    if (i2c_scan.next_addr > I2C_SCAN_LAST_ADDR) {
+        i2c_scan_finish();
+    } else {
+        sched_wake(i2c_scan_task_id);
+    }
+}
+
+static const sched_task_def_t i2c_scan_task_def = {
+    .name = "i2cscan", .run = i2c_scan_task, .period_ms = 0, .deadline_ms = 0, .priority = 3
+};
+
+// Run the scan from the scheduler (a scan started at boot begins here)
+int8_t i2c_scan_register_task(void)
+{
+    i2c_scan_task_id = sched_add_task(&i2c_scan_task_def);
+    if (i2c_scan_task_id < 0) {
+        return -1;
+    }
+    if (i2c_scan.state == I2C_SCAN_RUNNING) {
+        sched_wake(i2c_scan_task_id);
+    }
+    return 0;
+}
+
+// Console commands
+
+// Command handler showing the cached scan result; "rescan", or no result
+// yet, starts a scan that answers when it ends
+static void cmd_scan_i2c(console_ctx_t* ctx, int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "rescan") != 0) {
+        console_write(ctx, "Usage: scan i2c [rescan]\r\n");
+        return;
+    }
+
+    if (argc > 1 || i2c_scan.state == I2C_SCAN_IDLE) {
+        i2c_scan_start();
+    }
+    if (i2c_scan.state == I2C_SCAN_RUNNING) {
+        console_write(ctx, "Scanning I2C bus in the background...\r\n");
+        i2c_scan_reply = ctx;
+        return;
+    }
+    i2c_scan_print(ctx, 0);
+}
+
+static const console_command_t i2c_scan_commands[] = {
+    { "scan i2c", "si", "[rescan]", cmd_scan_i2c, "Show the last I2C bus scan, or start a new one" },
+};
+
+// Register the scan commands with the console
+int8_t i2c_scan_register_commands(void)
+{
+    return console_register_commands("I2C Bus", i2c_scan_commands,
+                                     sizeof(i2c_scan_commands) / sizeof(i2c_scan_commands[0]));
+}
@@ -0,0 +1,235 @@
+#include "log.h"
+#include "command_interface.h"
+#include "uart_tx.h"
+#include "fmt.h"
+#include "scheduler.h"
+#include <string.h>
+
+// Longest formatted log line, prefix included
+#define LOG_LINE_SIZE  128
+
+// Wait before printing again when the consoles are full
+#define LOG_RETRY_MS   20
+
+// One deferred log call
+typedef struct {
+    uint32_t tick;
+    const char* format;
+    uint8_t module;
+    uint8_t level;
+    uint8_t argc;
+    uint32_t args[LOG_MAX_ARGS];
+} log_entry_t;
+
+static const char* const log_module_names[LOG_MOD_COUNT] = { "i2c", "bme680", "lora" };
+static const char* const log_level_names[] = { "off", "error", "warn", "info", "debug" };
+static const char log_level_tags[] = { '-', 'E', 'W', 'I', 'D' };
+
+static const uint8_t log_build_levels[LOG_MOD_COUNT] = {
+    LOG_BUILD_LEVEL_I2C, LOG_BUILD_LEVEL_BME680, LOG_BUILD_LEVEL_LORA
+};
+
+uint8_t log_levels[LOG_MOD_COUNT] = { LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL };
+
+// Entries are claimed with interrupts off, so ISRs may log too
+static log_entry_t log_queue[LOG_QUEUE_SIZE];
+static volatile uint16_t log_head;
+static volatile uint16_t log_tail;
+static log_stats_t log_stats;
+static uint32_t log_dropped_reported;
+static int8_t log_task_id = -1;
+
+// Queue one log call, dropped (and counted) when the queue is full
+void log_write(uint8_t module, uint8_t level, const char* format, const uint32_t* args, uint8_t argc)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t used;
+
+    __disable_irq();
+    used = (uint16_t)(log_head - log_tail);
+    if (used >= LOG_QUEUE_SIZE) {
+        log_stats.dropped++;
+    } else {
+        log_entry_t* entry = &log_queue[log_head % LOG_QUEUE_SIZE];
+
+        entry->tick = HAL_GetTick();
+        entry->format = format;
+        entry->module = module;
+        entry->level = level;
+        entry->argc = argc;
+        memcpy(entry->args, args, argc * sizeof(uint32_t));
+        log_head++;
+        if (used + 1 > log_stats.high_water) {
+            log_stats.high_water = used + 1;
+        }
+    }
+    __set_PRIMASK(primask);
+    sched_wake(log_task_id);
+}
+
+// Never called, only lets the compiler check LOG_* format strings
+void log_check_format(const char* format, ...)
+{
+}
+
+// Room for len bytes on every text console
+static uint8_t log_output_room(uint16_t len)
+{
+    for (uint8_t i = 0; i < command_interface_port_count(); i++) {
+        console_ctx_t* port = command_interface_get_port(i);
+
+        if (port->mode == CONSOLE_MODE_TEXT && uart_tx_free(port->huart) < len) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Format one entry as "[tick] L module: message\r\n"
+static uint16_t log_format_entry(const log_entry_t* entry, char* line, uint16_t size)
+{
+    uint32_t a[LOG_MAX_ARGS] = { 0 };
+    uint16_t len;
+
+    memcpy(a, entry->args, entry->argc * sizeof(uint32_t));
+    len = fmt_format(line, size, "[%7lu] %c %s: ", entry->tick, log_level_tags[entry->level],
+                     log_module_names[entry->module]);
+    // Unused trailing arguments are ignored by the formatter
+    len += fmt_format(&line[len], size - len - 2, entry->format, a[0], a[1], a[2], a[3]);
+    line[len++] = '\r';
+    line[len++] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+// Format and print queued entries while the consoles have room for them.
+// Called from the main loop; entries stay queued rather than block.
+void log_process(void)
+{
+    char line[LOG_LINE_SIZE];
+
+    if (log_stats.dropped != log_dropped_reported) {
+        uint16_t len = fmt_format(line, sizeof(line), "[%7lu] W log: %lu messages dropped\r\n",
+                                  HAL_GetTick(), log_stats.dropped - log_dropped_reported);
+        if (!log_output_room(len)) {
+            return;
+        }
+        log_dropped_reported = log_stats.dropped;
+        command_interface_broadcast(line);
+    }
+
+    while (log_tail != log_head) {
+        uint16_t len = log_format_entry(&log_queue[log_tail % LOG_QUEUE_SIZE], line, sizeof(line));
+
+        if (!log_output_room(len)) {
+            return;
+        }
+        command_interface_broadcast(line);
+        log_tail++;
+        log_stats.written++;
+    }
+}
+
+// Log task: prints in the background at the lowest priority. Runs on new
+// entries only (so idle time can be spent in STOP), and retries later while
+// the consoles have no room.
+static void log_task(uint32_t events)
+{
+    log_process();
+    if (log_tail != log_head || log_stats.dropped != log_dropped_reported) {
+        sched_wake_at(log_task_id, HAL_GetTick() + LOG_RETRY_MS);
+    }
+}
+
+static const sched_task_def_t log_task_def = {
+    .name = "log", .run = log_task, .period_ms = 0, .deadline_ms = 0, .priority = 4
+};
+
+int8_t log_register_task(void)
+{
+    log_task_id = sched_add_task(&log_task_def);
+    return (log_task_id < 0) ? -1 : 0;
+}
+
+// Set a module's runtime level, returns -1 for a bad module or level
+int8_t log_set_level(uint8_t module, uint8_t level)
+{
+    if (module >= LOG_MOD_COUNT || level > LOG_LEVEL_DEBUG) {
+        return -1;
+    }
+    log_levels[module] = level;
+    return 0;
+}
+
+uint8_t log_build_level(uint8_t module)
+{
+    return (module < LOG_MOD_COUNT) ? log_build_levels[module] : LOG_LEVEL_OFF;
+}
+
+void log_get_stats(log_stats_t* stats)
+{
+    *stats = log_stats;
+    stats->queued = (uint16_t)(log_head - log_tail);
+}
+
+// Console commands
+
+// Index of a name in a table, -1 if not found
+static int8_t log_lookup(const char* const* names, uint8_t count, const char* name)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+// Command handler for showing and setting log levels
+static void cmd_log(console_ctx_t* ctx, int argc, char* argv[])
+{
+    uint8_t level_count = sizeof(log_level_names) / sizeof(log_level_names[0]);
+    int8_t module;
+    int8_t level;
+    log_stats_t stats;
+
+    if (argc < 3) {
+        for (uint8_t i = 0; i < LOG_MOD_COUNT; i++) {
+            console_printf(ctx, "  %-8s %-6s (built up to %s)\r\n", log_module_names[i],
+                           log_level_names[log_levels[i]], log_level_names[log_build_levels[i]]);
+        }
+        log_get_stats(&stats);
+        console_printf(ctx, "Queue: %u/%u used (peak %u), written=%lu dropped=%lu\r\n",
+                       stats.queued, LOG_QUEUE_SIZE, stats.high_water, stats.written, stats.dropped);
+        return;
+    }
+
+    module = (strcmp(argv[1], "all") == 0) ? LOG_MOD_COUNT : log_lookup(log_module_names, LOG_MOD_COUNT, argv[1]);
+    level = log_lookup(log_level_names, level_count, argv[2]);
+    if (module < 0 || level < 0) {
+        console_write(ctx, "Usage: log <i2c|bme680|lora|all> <off|error|warn|info|debug>\r\n");
+        return;
+    }
+
+    for (uint8_t i = 0; i < LOG_MOD_COUNT; i++) {
+        if (module == LOG_MOD_COUNT || module == i) {
+            log_set_level(i, (uint8_t)level);
+            if (level > log_build_levels[i]) {
+                console_printf(ctx, "Note: %s messages above %s are not in this build\r\n",
+                               log_module_names[i], log_level_names[log_build_levels[i]]);
+            }
+        }
+    }
+    console_printf(ctx, "Log level %s set to %s\r\n", argv[1], argv[2]);
+}
+
+static const console_command_t log_commands[] = {
+    { "log", NULL, "[module] [level]", cmd_log, "Show or set log levels (off/error/warn/info/debug)" },
+};
+
+// Register the logging commands with the console
+int8_t log_register_commands(void)
+{
+    return console_register_commands("Logging", log_commands,
+                                     sizeof(log_commands) / sizeof(log_commands[0]));
+}
@@ -0,0 +1,130 @@
+#include "lora_adr.h"
+
+// Lowest SNR each spreading factor demodulates, 0.1 dB (SF7-SF12)
+static const int16_t lora_adr_floor_db10[] = { -75, -100, -125, -150, -175, -200 };
+
+#define LORA_ADR_SF_STEP_DB10      25
+#define LORA_ADR_LDRO_SYMBOL_US    16380  // Symbols this long need low data rate optimization
+
+static lora_adr_state_t lora_adr;
+
+// Start from the configured settings, ADR off; the power never goes above
+// max_power_dbm
+void lora_adr_init(uint8_t sf, int8_t max_power_dbm)
+{
+    lora_adr.enabled = 0;
+    lora_adr.sf = sf;
+    lora_adr.power_dbm = max_power_dbm;
+    lora_adr.max_power_dbm = max_power_dbm;
+    lora_adr.samples = 0;
+    lora_adr.windows_unheard = 0;
+}
+
+void lora_adr_enable(uint8_t enable)
+{
+    lora_adr.enabled = enable;
+    lora_adr.samples = 0;
+    lora_adr.windows_unheard = 0;
+}
+
+// Low data rate optimization is required once a symbol lasts 16 ms or more
+// (SF11 and SF12 at 125 kHz), and costs airtime below that
+uint8_t lora_adr_ldro(uint8_t sf, uint16_t bw_khz)
+{
+    return ((1000u << sf) / bw_khz) >= LORA_ADR_LDRO_SYMBOL_US;
+}
+
+// Apply the margin of the SNR history in SF and power steps. Returns 1 if
+// the settings changed.
+static uint8_t lora_adr_evaluate(void)
+{
+    uint8_t sf = lora_adr.sf;
+    int8_t power = lora_adr.power_dbm;
+    int8_t min_power = (int8_t)(lora_adr.max_power_dbm - LORA_ADR_POWER_STEPS * LORA_ADR_POWER_STEP_DB);
+    int16_t steps;
+
+    lora_adr.margin_db10 = (int16_t)(lora_adr.best_snr_db * 10 - lora_adr_floor_db10[sf - LORA_ADR_SF_MIN] -
+                                     LORA_ADR_MARGIN_DB * 10);
+    lora_adr.samples = 0;
+
+    // Round towards minus infinity: a margin just below zero is a step up
+    steps = (lora_adr.margin_db10 >= 0) ? lora_adr.margin_db10 / LORA_ADR_SF_STEP_DB10
+                                        : -((LORA_ADR_SF_STEP_DB10 - 1 - lora_adr.margin_db10) / LORA_ADR_SF_STEP_DB10);
+    for (; steps > 0 && sf > LORA_ADR_SF_MIN; steps--) {
+        sf--;
+    }
+    for (; steps > 0 && power - LORA_ADR_POWER_STEP_DB >= min_power; steps--) {
+        power -= LORA_ADR_POWER_STEP_DB;
+    }
+    for (; steps < 0 && power < lora_adr.max_power_dbm; steps++) {
+        power += LORA_ADR_POWER_STEP_DB;
+    }
+    if (power > lora_adr.max_power_dbm) {
+        power = lora_adr.max_power_dbm;
+    }
+
+    if (sf == lora_adr.sf && power == lora_adr.power_dbm) {
+        return 0;
+    }
+    lora_adr.sf = sf;
+    lora_adr.power_dbm = power;
+    lora_adr.changes++;
+    return 1;
+}
+
+// A packet from the other end was heard. Returns 1 if the settings changed.
+uint8_t lora_adr_downlink(int8_t snr_db, int16_t rssi_dbm)
+{
+    lora_adr.last_snr_db = snr_db;
+    lora_adr.last_rssi_dbm = rssi_dbm;
+    lora_adr.windows_unheard = 0;
+    if (!lora_adr.enabled) {
+        return 0;
+    }
+
+    if (lora_adr.samples == 0 || snr_db > lora_adr.best_snr_db) {
+        lora_adr.best_snr_db = snr_db;
+    }
+    if (++lora_adr.samples < LORA_ADR_HISTORY) {
+        return 0;
+    }
+    return lora_adr_evaluate();
+}
+
+// One step more robust: maximum power first, then the next SF. Returns 1 if
+// the settings changed.
+static uint8_t lora_adr_back_off(void)
+{
+    lora_adr.samples = 0;
+    if (lora_adr.power_dbm < lora_adr.max_power_dbm) {
+        lora_adr.power_dbm = lora_adr.max_power_dbm;
+    } else if (lora_adr.sf < LORA_ADR_SF_MAX) {
+        lora_adr.sf++;
+    } else {
+        return 0;
+    }
+    lora_adr.changes++;
+    return 1;
+}
+
+// A receive window after an uplink closed with nothing heard. Returns 1 if
+// the back-off changed the settings.
+uint8_t lora_adr_lost(void)
+{
+    if (!lora_adr.enabled) {
+        return 0;
+    }
+    if (lora_adr.windows_unheard < UINT16_MAX) {
+        lora_adr.windows_unheard++;
+    }
+    if (lora_adr.windows_unheard >= LORA_ADR_ACK_LIMIT &&
+        (lora_adr.windows_unheard - LORA_ADR_ACK_LIMIT) % LORA_ADR_ACK_DELAY == 0) {
+        return lora_adr_back_off();
+    }
+    return 0;
+}
+
+void lora_adr_get(lora_adr_state_t* state)
+{
+    *state = lora_adr;
+}
@@ -0,0 +1,161 @@
+#include "lora_duty.h"
+#include "timebase.h"
+#include <string.h>
+
+#define LORA_DUTY_MINUTE_MS      60000u
+// The current minute and the 60 before it: the oldest is partly in the hour
+#define LORA_DUTY_BUCKETS        (LORA_DUTY_WINDOW_MIN + 1)
+
+typedef struct {
+    uint32_t low_hz;
+    uint32_t high_hz;
+    uint16_t limit_permille;
+} lora_duty_band_def_t;
+
+// EU868 sub-bands for non-specific short range devices (ERC Recommendation
+// 70-03, annex 1)
+static const lora_duty_band_def_t lora_duty_bands[LORA_DUTY_BANDS] = {
+    { 863000000, 865000000,   1 },
+    { 865000000, 868000000,  10 },
+    { 868000000, 868600000,  10 },
+    { 868700000, 869200000,   1 },
+    { 869400000, 869650000, 100 },
+    { 869700000, 870000000,  10 },
+};
+
+typedef struct {
+    uint16_t ms[LORA_DUTY_BUCKETS];     // Airtime per minute, index minute % 61
+    uint32_t minute;                    // Minute the buckets are current for
+    uint32_t transmissions;
+} lora_duty_ledger_t;
+
+static lora_duty_ledger_t lora_duty_ledgers[LORA_DUTY_BANDS];
+
+// Minutes since boot, from the 64-bit timebase (HAL_GetTick() wraps)
+static uint32_t lora_duty_minute(uint64_t now_ms)
+{
+    return (uint32_t)(now_ms / LORA_DUTY_MINUTE_MS);
+}
+
+// Clear the buckets of the minutes that passed since the last use
+static void lora_duty_advance(lora_duty_ledger_t* ledger, uint32_t now_min)
+{
+    if (now_min - ledger->minute >= LORA_DUTY_BUCKETS) {
+        memset(ledger->ms, 0, sizeof(ledger->ms));
+    } else {
+        while (ledger->minute != now_min) {
+            ledger->minute++;
+            ledger->ms[ledger->minute % LORA_DUTY_BUCKETS] = 0;
+        }
+    }
+    ledger->minute = now_min;
+}
+
+static uint32_t lora_duty_used(const lora_duty_ledger_t* ledger)
+{
+    uint32_t used = 0;
+
+    for (uint8_t i = 0; i < LORA_DUTY_BUCKETS; i++) {
+        used += ledger->ms[i];
+    }
+    return used;
+}
+
+static uint32_t lora_duty_budget(uint8_t band)
+{
+    return (LORA_DUTY_WINDOW_MIN * LORA_DUTY_MINUTE_MS / 1000u) * lora_duty_bands[band].limit_permille;
+}
+
+// Sub-band of a frequency, -1 if it is in none
+int8_t lora_duty_band(uint32_t freq_hz)
+{
+    for (uint8_t i = 0; i < LORA_DUTY_BANDS; i++) {
+        if (freq_hz >= lora_duty_bands[i].low_hz && freq_hz < lora_duty_bands[i].high_hz) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+// Time until a transmission of airtime_ms fits the budget of its sub-band:
+// 0 if it may go now, -1 if it never will (outside the sub-bands, or longer
+// than the whole budget)
+int32_t lora_duty_wait_ms(uint32_t freq_hz, uint32_t airtime_ms)
+{
+    int8_t band = lora_duty_band(freq_hz);
+    lora_duty_ledger_t* ledger;
+    uint64_t now_ms;
+    uint32_t now_min;
+    uint32_t budget;
+    uint32_t used;
+    uint32_t freed = 0;
+    uint32_t minute;
+
+    if (band < 0) {
+        return -1;
+    }
+    budget = lora_duty_budget((uint8_t)band);
+    if (airtime_ms > budget) {
+        return -1;
+    }
+
+    ledger = &lora_duty_ledgers[band];
+    now_ms = timebase_now_us() / 1000u;
+    now_min = lora_duty_minute(now_ms);
+    lora_duty_advance(ledger, now_min);
+    used = lora_duty_used(ledger);
+    if (used + airtime_ms <= budget) {
+        return 0;
+    }
+
+    // Oldest minutes first: bucket i (minute now_min - 60 + i) has left the
+    // sliding hour entirely when minute now_min + 1 + i begins
+    for (uint8_t i = 0; i < LORA_DUTY_BUCKETS; i++) {
+        minute = now_min + 1 + i;
+        freed += ledger->ms[minute % LORA_DUTY_BUCKETS];
+        if (used + airtime_ms - freed <= budget) {
+            return (int32_t)((uint64_t)minute * LORA_DUTY_MINUTE_MS - now_ms);
+        }
+    }
+    return -1;
+}
+
+// Book a transmission that started now
+void lora_duty_record(uint32_t freq_hz, uint32_t airtime_ms)
+{
+    int8_t band = lora_duty_band(freq_hz);
+    lora_duty_ledger_t* ledger;
+    uint16_t* bucket;
+    uint32_t now_min;
+
+    if (band < 0) {
+        return;
+    }
+    ledger = &lora_duty_ledgers[band];
+    now_min = lora_duty_minute(timebase_now_us() / 1000u);
+    lora_duty_advance(ledger, now_min);
+
+    bucket = &ledger->ms[now_min % LORA_DUTY_BUCKETS];
+    *bucket = (*bucket + airtime_ms > LORA_DUTY_MINUTE_MS) ? LORA_DUTY_MINUTE_MS : (uint16_t)(*bucket + airtime_ms);
+    ledger->transmissions++;
+}
+
+// Limits and current use of a sub-band; -1 for a bad index
+int8_t lora_duty_get(uint8_t band, lora_duty_band_info_t* info)
+{
+    lora_duty_ledger_t* ledger;
+
+    if (band >= LORA_DUTY_BANDS) {
+        return -1;
+    }
+    ledger = &lora_duty_ledgers[band];
+    lora_duty_advance(ledger, lora_duty_minute(timebase_now_us() / 1000u));
+
+    info->low_hz = lora_duty_bands[band].low_hz;
+    info->high_hz = lora_duty_bands[band].high_hz;
+    info->limit_permille = lora_duty_bands[band].limit_permille;
+    info->budget_ms = lora_duty_budget(band);
+    info->used_ms = lora_duty_used(ledger);
+    info->transmissions = ledger->transmissions;
+    return 0;
+}
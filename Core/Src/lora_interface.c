@@ -1,26 +1,93 @@
 #include "lora_interface.h"
+#include "lora_payload.h"
+#include "lora_duty.h"
+#include "lora_adr.h"
 #include "bme680_interface.h"
 #include "sx126x.h"
+#include "command_interface.h"
+#include "fmt.h"
+#include "log.h"
+#include "scheduler.h"
+#include "timebase.h"
 #include <string.h>
-#include <stdio.h>
 
 // External handles
 extern SPI_HandleTypeDef hspi1;
-extern UART_HandleTypeDef huart2;
-extern UART_HandleTypeDef huart4;
 
 // LoRa module status
 static uint8_t lora_module_detected = 0;
 static uint8_t lora_initialized = 0;
 
+// Transmission counters
+static uint32_t lora_tx_ok = 0;
+static uint32_t lora_tx_failed = 0;
+static uint32_t lora_rx_ok = 0;
+static uint32_t lora_rx_crc_errors = 0;
+static uint32_t lora_irq_missed = 0;
+static uint32_t lora_last_airtime_us = 0;
+static volatile uint32_t lora_irq_edges = 0;
+
+// Operation the radio is busy with
+#define LORA_OP_IDLE           0
+#define LORA_OP_TX             1
+#define LORA_OP_RX             2   // Single reception, ends with a packet or the timeout
+#define LORA_OP_RX_CONTINUOUS  3
+
+// Task event posted by the DIO1 interrupt
+#define LORA_EVENT_DIO1        (1u << 0)
+
+typedef struct {
+    uint8_t op;
+    lora_tx_callback_t tx_done;
+    void* tx_arg;
+    lora_rx_callback_t rx_event;
+    void* rx_arg;
+    uint64_t tx_start_us;
+    uint32_t tx_deadline;       // Tick the watchdog reads the flags at
+    uint8_t rx_paused;          // Continuous reception stopped for the queue
+    volatile uint64_t edge_us;  // Written by the DIO1 interrupt
+} lora_radio_t;
+
+static lora_radio_t lora_radio;
+static int8_t lora_task_id = -1;
+
+// Transmit queue: a static pool of packet slots
+typedef struct {
+    uint8_t data[LORA_PAYLOAD_LENGTH];
+    uint8_t length;
+    uint8_t priority;           // LORA_TX_PRIO_*
+    uint32_t seq;               // Queue order within a priority
+    uint32_t expires;           // Tick the packet is dropped at, 0 for never
+    uint8_t deferred;           // Held back by the duty cycle at least once
+    lora_tx_callback_t done;
+    void* arg;
+} lora_tx_slot_t;
+
+typedef struct {
+    uint8_t used;               // Bit i: slot i holds a packet
+    uint32_t seq;
+    uint32_t queued;
+    uint32_t expired;
+    uint32_t full;              // Packets refused with every slot taken
+    uint32_t duty_deferred;     // Packets held back until the duty cycle allowed them
+    uint32_t duty_rejected;     // Packets that could never fit the duty cycle
+    uint32_t last_gap_us;       // From a TX done edge to the start of the next queued packet
+} lora_tx_queue_t;
+
+static lora_tx_slot_t lora_tx_pool[LORA_TX_QUEUE_SLOTS];
+static lora_tx_queue_t lora_tx_queue;
+
 // SX126x configuration
 static sx126x_mod_params_lora_t lora_mod_params = {
     .sf = SX126X_LORA_SF7,
     .bw = SX126X_LORA_BW_125,
     .cr = SX126X_LORA_CR_4_5,
-    .ldro = 1
+    .ldro = 0   // Set from the symbol time, see lora_adr_ldro()
 };
 
+// TX power in use (ADR lowers it from LORA_TX_POWER_DBM)
+static int8_t lora_tx_power_dbm = LORA_TX_POWER_DBM;
+
 static sx126x_pkt_params_lora_t lora_pkt_params = {
     .preamble_len_in_symb = 8,
     .header_type = SX126X_LORA_PKT_EXPLICIT,
@@ -31,8 +98,30 @@ static sx126x_pkt_params_lora_t lora_pkt_params = {
 
 // Debug function
 static void lora_debug_print(const char* message) {
-    HAL_UART_Transmit(&huart2, (uint8_t*)message, strlen(message), 1000);
-    HAL_UART_Transmit(&huart4, (uint8_t*)message, strlen(message), 1000);
+    command_interface_broadcast(message);
+}
+
+// Radio IRQs routed to DIO1
+#define LORA_DIO1_IRQS  (SX126X_IRQ_TX_DONE | SX126X_IRQ_RX_DONE | SX126X_IRQ_TIMEOUT | \
+                         SX126X_IRQ_CRC_ERROR | SX126X_IRQ_HEADER_ERROR)
+
+static void lora_tx_flush(int8_t rslt);
+
+// Drop the operation in progress (the radio is being reset): a pending
+// transmission and the queued packets fail
+static void lora_abort(void) {
+    lora_tx_callback_t done = lora_radio.tx_done;
+    uint8_t op = lora_radio.op;
+    
+    lora_radio.op = LORA_OP_IDLE;
+    lora_radio.rx_paused = 0;
+    if (op == LORA_OP_TX) {
+        lora_tx_failed++;
+        if (done != NULL) {
+            done(-1, 0, lora_radio.tx_arg);
+        }
+    }
+    lora_tx_flush(-1);
 }
 
 // Detect LoRa module presence using real SX126x commands
@@ -40,13 +129,14 @@ static int8_t lora_detect_module(void) {
     sx126x_chip_status_t chip_status;
     
     // Reset module first
+    lora_abort();
     sx126x_reset(NULL);
-    HAL_Delay(50); // Give reset time to take effect
+    timebase_delay_ms(50); // Give reset time to take effect
     
     // Test 1: Try to get chip status
     sx126x_status_t status = sx126x_get_status(NULL, &chip_status);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ LoRa detection failed: get_status returned error\r\n");
+        LOG_ERROR(LORA, "Detection failed: get_status returned error");
         lora_module_detected = 0;
         return -1;
     }
@@ -54,7 +144,7 @@ static int8_t lora_detect_module(void) {
     // Test 2: Try to set standby mode
     status = sx126x_set_standby(NULL, SX126X_STANDBY_CFG_RC);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ LoRa detection failed: set_standby returned error\r\n");
+        LOG_ERROR(LORA, "Detection failed: set_standby returned error");
         lora_module_detected = 0;
         return -1;
     }
@@ -63,7 +153,7 @@ static int8_t lora_detect_module(void) {
     uint8_t test_buffer[1];
     status = sx126x_read_register(NULL, 0x0000, test_buffer, 1);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ LoRa detection failed: read_register returned error\r\n");
+        LOG_ERROR(LORA, "Detection failed: read_register returned error");
         lora_module_detected = 0;
         return -1;
     }
@@ -71,7 +161,7 @@ static int8_t lora_detect_module(void) {
     // Test 4: Try to set packet type (this requires actual chip response)
     status = sx126x_set_pkt_type(NULL, SX126X_PKT_TYPE_LORA);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ LoRa detection failed: set_pkt_type returned error\r\n");
+        LOG_ERROR(LORA, "Detection failed: set_pkt_type returned error");
         lora_module_detected = 0;
         return -1;
     }
@@ -80,14 +170,14 @@ static int8_t lora_detect_module(void) {
     sx126x_pkt_type_t pkt_type;
     status = sx126x_get_pkt_type(NULL, &pkt_type);
     if (status != SX126X_STATUS_OK || pkt_type != SX126X_PKT_TYPE_LORA) {
-        lora_debug_print("✗ LoRa detection failed: get_pkt_type verification failed\r\n");
+        LOG_ERROR(LORA, "Detection failed: get_pkt_type verification failed");
         lora_module_detected = 0;
         return -1;
     }
     
     // All tests passed - module is definitely present
     lora_module_detected = 1;
-    lora_debug_print("✓ LoRa module detected successfully\r\n");
+    LOG_INFO(LORA, "Module detected successfully");
     return 0;
 }
 
@@ -97,7 +187,7 @@ int8_t lora_init(void) {
     
     // First detect if module is present
     if (lora_detect_module() != 0) {
-        lora_debug_print("✗ LoRa initialization failed - no module detected\r\n");
+        LOG_ERROR(LORA, "Initialization failed - no module detected");
         lora_initialized = 0;
         return -1;
     }
@@ -105,7 +195,7 @@ int8_t lora_init(void) {
     // Set standby mode
     status = sx126x_set_standby(NULL, SX126X_STANDBY_CFG_RC);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set standby mode\r\n");
+        LOG_ERROR(LORA, "Failed to set standby mode");
         lora_initialized = 0;
         return -1;
     }
@@ -113,7 +203,7 @@ int8_t lora_init(void) {
     // Set regulator mode to LDO
     status = sx126x_set_reg_mode(NULL, SX126X_REG_MODE_LDO);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set regulator mode\r\n");
+        LOG_ERROR(LORA, "Failed to set regulator mode");
         lora_initialized = 0;
         return -1;
     }
@@ -121,7 +211,7 @@ int8_t lora_init(void) {
     // Set packet type to LoRa
     status = sx126x_set_pkt_type(NULL, SX126X_PKT_TYPE_LORA);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set packet type\r\n");
+        LOG_ERROR(LORA, "Failed to set packet type");
         lora_initialized = 0;
         return -1;
     }
@@ -129,15 +219,19 @@ int8_t lora_init(void) {
     // Set RF frequency (868 MHz)
     status = sx126x_set_rf_freq(NULL, LORA_FREQUENCY_HZ);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set RF frequency\r\n");
+        LOG_ERROR(LORA, "Failed to set RF frequency");
         lora_initialized = 0;
         return -1;
     }
     
-    // Set LoRa modulation parameters
+    // Set LoRa modulation parameters; ADR starts again from the configured ones
+    lora_adr_init(LORA_SPREADING_FACTOR, LORA_TX_POWER_DBM);
+    lora_mod_params.sf = (sx126x_lora_sf_t)LORA_SPREADING_FACTOR;
+    lora_mod_params.ldro = lora_adr_ldro(LORA_SPREADING_FACTOR, LORA_BANDWIDTH);
+    lora_tx_power_dbm = LORA_TX_POWER_DBM;
     status = sx126x_set_lora_mod_params(NULL, &lora_mod_params);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set LoRa modulation parameters\r\n");
+        LOG_ERROR(LORA, "Failed to set LoRa modulation parameters");
         lora_initialized = 0;
         return -1;
     }
@@ -145,7 +239,7 @@ int8_t lora_init(void) {
     // Set LoRa packet parameters
     status = sx126x_set_lora_pkt_params(NULL, &lora_pkt_params);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set LoRa packet parameters\r\n");
+        LOG_ERROR(LORA, "Failed to set LoRa packet parameters");
         lora_initialized = 0;
         return -1;
     }
@@ -153,7 +247,7 @@ int8_t lora_init(void) {
     // Set TX parameters
     status = sx126x_set_tx_params(NULL, LORA_TX_POWER_DBM, SX126X_RAMP_10_US);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set TX parameters\r\n");
+        LOG_ERROR(LORA, "Failed to set TX parameters");
         lora_initialized = 0;
         return -1;
     }
@@ -161,7 +255,7 @@ int8_t lora_init(void) {
     // Set LoRa sync word
     status = sx126x_set_lora_sync_word(NULL, LORA_SYNC_WORD);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set LoRa sync word\r\n");
+        LOG_ERROR(LORA, "Failed to set LoRa sync word");
         lora_initialized = 0;
         return -1;
     }
@@ -169,138 +263,593 @@ int8_t lora_init(void) {
     // Set buffer base address
     status = sx126x_set_buffer_base_address(NULL, 0x00, 0x00);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set buffer base address\r\n");
+        LOG_ERROR(LORA, "Failed to set buffer base address");
         lora_initialized = 0;
         return -1;
     }
     
-    // Set DIO IRQ parameters
-    status = sx126x_set_dio_irq_params(NULL, SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT, 
-                                       SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT, 0, 0);
+    // Every event the task dispatches raises DIO1
+    status = sx126x_set_dio_irq_params(NULL, LORA_DIO1_IRQS, LORA_DIO1_IRQS, 0, 0);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to set DIO IRQ parameters\r\n");
+        LOG_ERROR(LORA, "Failed to set DIO IRQ parameters");
         lora_initialized = 0;
         return -1;
     }
     
-    lora_debug_print("✓ LoRa module initialized successfully\r\n");
+    LOG_INFO(LORA, "Module initialized successfully");
     lora_initialized = 1;
     return 0;
 }
 
-// Send sensor data via LoRa
-int8_t lora_send_sensor_data(float temperature, float pressure, float humidity) {
-    if (!lora_module_detected) {
-        lora_debug_print("✗ LoRa transmission failed - no module detected\r\n");
-        return -1;
-    }
+// Node ID sent in the payload header: the 96-bit device UID folded to 16 bits
+static uint16_t lora_node_id(void) {
+    uint32_t uid = HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2();
     
-    if (!lora_initialized) {
-        lora_debug_print("✗ LoRa transmission failed - module not initialized\r\n");
+    return (uint16_t)(uid ^ (uid >> 16));
+}
+
+// Send sensor data via LoRa as a binary frame (lora_payload.h); done is
+// called when the packet is out (see lora_send_message())
+int8_t lora_send_sensor_data(const bme680_sample_t* sample, lora_tx_callback_t done, void* arg) {
+    static lora_payload_ctx_t encoders[BME680_MAX_SENSORS];
+    lora_payload_ctx_t* enc;
+    lora_payload_t reading;
+    uint8_t payload[LORA_PAYLOAD_MAX_LENGTH];
+    int16_t length;
+    int8_t rslt;
+    
+    if (sample->sensor_id >= BME680_MAX_SENSORS) {
         return -1;
     }
+    enc = &encoders[sample->sensor_id];
+    if (enc->keyframe_interval == 0) {
+        lora_payload_init(enc, lora_node_id(), sample->sensor_id, LORA_PAYLOAD_KEYFRAME_INTERVAL);
+    }
     
-    char payload[LORA_PAYLOAD_LENGTH];
-    int len;
-    
-    // Format sensor data as JSON-like string
-    len = snprintf(payload, sizeof(payload), 
-                   "{\"temp\":%.2f,\"press\":%.2f,\"hum\":%.2f,\"node\":\"STM32\"}",
-                   temperature, pressure, humidity);
+    reading.fields = LORA_PAYLOAD_F_DEFAULT;
+    reading.temperature = sample->temperature;
+    reading.pressure = sample->pressure;
+    reading.humidity = sample->humidity;
+    reading.gas_resistance = sample->gas_resistance;
+    if (sample->status & BME68X_GASM_VALID_MSK) {
+        reading.fields |= LORA_PAYLOAD_F_GAS;
+    }
     
-    if (len < 0 || len >= sizeof(payload)) {
-        lora_debug_print("Error: Payload too long\r\n");
+    length = lora_payload_encode(enc, &reading, payload, sizeof(payload));
+    if (length < 0) {
+        LOG_ERROR(LORA, "Payload encoding failed: %d", length);
         return -1;
     }
     
-    return lora_send_message((uint8_t*)payload, len);
+    rslt = lora_send_message(payload, (uint8_t)length, done, arg);
+    if (rslt != 0) {
+        // The receiver never sees this frame: the next one must not refer to it
+        lora_payload_force_keyframe(enc);
+    }
+    return rslt;
 }
 
-// Send message via LoRa using real SX126x driver
-int8_t lora_send_message(const uint8_t* data, uint8_t length) {
-    sx126x_status_t status;
-    sx126x_irq_mask_t irq_status;
-    
+// The radio can take a command: detected, initialized and idle
+static int8_t lora_ready(void) {
     if (!lora_module_detected) {
-        lora_debug_print("✗ LoRa transmission failed - no module detected\r\n");
+        LOG_ERROR(LORA, "Radio not available - no module detected");
         return -1;
     }
-    
     if (!lora_initialized) {
-        lora_debug_print("✗ LoRa transmission failed - module not initialized\r\n");
-        return -1;
-    }
-    
-    if (data == NULL || length == 0 || length > LORA_PAYLOAD_LENGTH) {
-        lora_debug_print("Invalid LoRa message parameters\r\n");
+        LOG_ERROR(LORA, "Radio not available - module not initialized");
         return -1;
     }
+    return (lora_radio.op == LORA_OP_IDLE) ? 0 : LORA_E_BUSY;
+}
+
+// Hand a packet to the radio and start the transmission; the DIO1 edge
+// reports the end. Returns 0 or -1.
+static int8_t lora_start_tx(const uint8_t* data, uint8_t length, lora_tx_callback_t done, void* arg) {
+    sx126x_status_t status;
+    uint32_t airtime_ms;
     
     // Update packet length
     lora_pkt_params.pld_len_in_bytes = length;
     status = sx126x_set_lora_pkt_params(NULL, &lora_pkt_params);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to update packet parameters\r\n");
+        LOG_ERROR(LORA, "Failed to update packet parameters");
         return -1;
     }
     
     // Write payload to buffer
     status = sx126x_write_buffer(NULL, 0x00, data, length);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to write payload to buffer\r\n");
+        LOG_ERROR(LORA, "Failed to write payload to buffer");
         return -1;
     }
     
     // Clear IRQ status
     status = sx126x_clear_irq_status(NULL, SX126X_IRQ_ALL);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to clear IRQ status\r\n");
+        LOG_ERROR(LORA, "Failed to clear IRQ status");
         return -1;
     }
     
-    // Start transmission
-    status = sx126x_set_tx(NULL, 1000); // 1 second timeout
+    // Start transmission; the radio-side timeout follows the time on air
+    // (over a second at SF12)
+    airtime_ms = sx126x_get_lora_time_on_air_in_ms(&lora_pkt_params, &lora_mod_params);
+    lora_radio.op = LORA_OP_TX;
+    lora_radio.tx_done = done;
+    lora_radio.tx_arg = arg;
+    lora_radio.tx_start_us = timebase_now_us();
+    status = sx126x_set_tx(NULL, airtime_ms + LORA_TX_TIMEOUT_SLACK_MS);
     if (status != SX126X_STATUS_OK) {
-        lora_debug_print("✗ Failed to start transmission\r\n");
+        LOG_ERROR(LORA, "Failed to start transmission");
+        lora_radio.op = LORA_OP_IDLE;
         return -1;
     }
     
-    // Wait for transmission to complete
-    uint32_t timeout = HAL_GetTick() + 2000; // 2 second timeout
-    while (HAL_GetTick() < timeout) {
-        status = sx126x_get_irq_status(NULL, &irq_status);
-        if (status == SX126X_STATUS_OK) {
-            if (irq_status & SX126X_IRQ_TX_DONE) {
-                return 0;
-            } else if (irq_status & SX126X_IRQ_TIMEOUT) {
-                lora_debug_print("✗ LoRa transmission timeout\r\n");
-                return -1;
+    // Book the airtime; watchdog in case the edge is lost (lora_tx_next()
+    // arms the release)
+    lora_duty_record(LORA_FREQUENCY_HZ, airtime_ms);
+    lora_radio.tx_deadline = HAL_GetTick() + airtime_ms + LORA_TX_WATCHDOG_MS;
+    LOG_DEBUG(LORA, "TX started: %u bytes, %lu ms on air", length, airtime_ms);
+    return 0;
+}
+
+// Time on air of a packet with the current modulation
+static uint32_t lora_airtime_ms(uint8_t length) {
+    sx126x_pkt_params_lora_t pkt = lora_pkt_params;
+    
+    pkt.pld_len_in_bytes = length;
+    return sx126x_get_lora_time_on_air_in_ms(&pkt, &lora_mod_params);
+}
+
+// Time until a packet of this length may start under the duty cycle: 0 for
+// now, -1 if it never will. Senders can use it to plan around the budget.
+int32_t lora_send_delay_ms(uint8_t length) {
+    return lora_duty_wait_ms(LORA_FREQUENCY_HZ, lora_airtime_ms(length));
+}
+
+// Put the radio in receive mode: single with a timeout in ms, or continuous
+// for 0
+static sx126x_status_t lora_set_rx(uint32_t timeout_ms) {
+    sx126x_status_t status = sx126x_clear_irq_status(NULL, SX126X_IRQ_ALL);
+    
+    if (status != SX126X_STATUS_OK) {
+        return status;
+    }
+    return (timeout_ms == 0) ? sx126x_set_rx_with_timeout_in_rtc_step(NULL, SX126X_RX_CONTINUOUS)
+                             : sx126x_set_rx(NULL, timeout_ms);
+}
+
+// Hand the radio of a continuous reception to the queue. The callback stays
+// registered and the reception resumes once no packet can go.
+static void lora_rx_pause(void) {
+    (void)sx126x_set_standby(NULL, SX126X_STANDBY_CFG_RC);
+    lora_radio.op = LORA_OP_IDLE;
+    lora_radio.rx_paused = 1;
+}
+
+static void lora_rx_resume(void) {
+    lora_radio.rx_paused = 0;
+    lora_radio.op = LORA_OP_RX_CONTINUOUS;
+    if (lora_set_rx(0) != SX126X_STATUS_OK) {
+        LOG_ERROR(LORA, "Failed to resume continuous reception");
+        lora_radio.op = LORA_OP_IDLE;
+    }
+}
+
+// The earlier of two release ticks, 0 standing for none
+static uint32_t lora_earlier(uint32_t a, uint32_t b) {
+    if (a == 0) {
+        return b;
+    }
+    if (b == 0) {
+        return a;
+    }
+    return ((int32_t)(a - b) <= 0) ? a : b;
+}
+
+// Queued packet waiting for the radio that comes first: highest priority,
+// then oldest. -1 if the queue is empty.
+static int8_t lora_tx_queue_head(void) {
+    int8_t head = -1;
+    
+    for (uint8_t i = 0; i < LORA_TX_QUEUE_SLOTS; i++) {
+        if (!(lora_tx_queue.used & (1u << i))) {
+            continue;
+        }
+        if (head < 0 || lora_tx_pool[i].priority < lora_tx_pool[head].priority ||
+            (lora_tx_pool[i].priority == lora_tx_pool[head].priority &&
+             (int32_t)(lora_tx_pool[i].seq - lora_tx_pool[head].seq) < 0)) {
+            head = (int8_t)i;
+        }
+    }
+    return head;
+}
+
+// Bring the radio to the SF and TX power ADR chose (radio idle only; the
+// modulation also applies to receptions)
+static void lora_adr_apply(void) {
+    lora_adr_state_t adr;
+    sx126x_mod_params_lora_t mod = lora_mod_params;
+    
+    lora_adr_get(&adr);
+    if (adr.sf == lora_mod_params.sf && adr.power_dbm == lora_tx_power_dbm) {
+        return;
+    }
+    
+    mod.sf = (sx126x_lora_sf_t)adr.sf;
+    mod.ldro = lora_adr_ldro(adr.sf, LORA_BANDWIDTH);
+    if (sx126x_set_lora_mod_params(NULL, &mod) != SX126X_STATUS_OK ||
+        sx126x_set_tx_params(NULL, adr.power_dbm, SX126X_RAMP_10_US) != SX126X_STATUS_OK) {
+        LOG_ERROR(LORA, "ADR: failed to set SF%u at %d dBm", adr.sf, adr.power_dbm);
+        return;
+    }
+    LOG_INFO(LORA, "ADR: SF%u -> SF%u, %d -> %d dBm", lora_mod_params.sf, adr.sf, lora_tx_power_dbm,
+             adr.power_dbm);
+    lora_mod_params = mod;
+    lora_tx_power_dbm = adr.power_dbm;
+}
+
+// Complete the queued packets whose time to live ran out, whatever the radio
+// is doing
+static void lora_tx_expire(void) {
+    uint32_t now = HAL_GetTick();
+    
+    for (uint8_t i = 0; i < LORA_TX_QUEUE_SLOTS; i++) {
+        if (!(lora_tx_queue.used & (1u << i)) || lora_tx_pool[i].expires == 0 ||
+            (int32_t)(now - lora_tx_pool[i].expires) < 0) {
+            continue;
+        }
+        lora_tx_queue.used &= (uint8_t)~(1u << i);
+        lora_tx_queue.expired++;
+        if (lora_tx_pool[i].done != NULL) {
+            lora_tx_pool[i].done(LORA_E_EXPIRED, 0, lora_tx_pool[i].arg);
+        }
+    }
+}
+
+// Start the next queued packet if the radio is idle, or held by a continuous
+// reception (paused for the packet, resumed when the queue has nothing that
+// can go). Expired packets and packets the radio refuses are completed with
+// an error on the way. When the duty cycle holds the head packet back, the
+// task is released when it fits; a packet that would expire first is dropped
+// now. The single timed release of the task is armed for the earliest of the
+// TX watchdog, the duty-cycle hold and the next expiry.
+static void lora_tx_next(void) {
+    static uint8_t running;
+    lora_tx_slot_t* slot;
+    uint32_t wake = 0;
+    int32_t wait_ms;
+    int8_t head;
+    int8_t rslt;
+    
+    // A callback below may queue another packet; the loop picks it up
+    if (running) {
+        return;
+    }
+    running = 1;
+    
+    lora_tx_expire();
+    head = lora_tx_queue_head();
+    if (lora_radio.op == LORA_OP_RX_CONTINUOUS && head >= 0 &&
+        lora_send_delay_ms(lora_tx_pool[head].length) == 0) {
+        lora_rx_pause();
+    }
+    
+    while (lora_radio.op == LORA_OP_IDLE && lora_initialized && (head = lora_tx_queue_head()) >= 0) {
+        lora_adr_apply();
+        slot = &lora_tx_pool[head];
+        wait_ms = lora_send_delay_ms(slot->length);
+        if (wait_ms < 0) {
+            lora_tx_queue.duty_rejected++;
+            rslt = LORA_E_DUTY_CYCLE;
+        } else if (slot->expires != 0 && (int32_t)(HAL_GetTick() + (uint32_t)wait_ms - slot->expires) >= 0) {
+            lora_tx_queue.expired++;
+            rslt = LORA_E_EXPIRED;
+        } else if (wait_ms > 0) {
+            if (!slot->deferred) {
+                slot->deferred = 1;
+                lora_tx_queue.duty_deferred++;
+                LOG_INFO(LORA, "Duty cycle: packet held back %ld ms", wait_ms);
+            }
+            wake = HAL_GetTick() + (uint32_t)wait_ms;
+            break;
+        } else {
+            rslt = lora_start_tx(slot->data, slot->length, slot->done, slot->arg);
+            if (rslt != 0) {
+                lora_tx_failed++;
             }
         }
-        HAL_Delay(1);
+        
+        // The data is in the radio buffer now; the slot is free for the next packet
+        lora_tx_queue.used &= (uint8_t)~(1u << head);
+        if (rslt != 0 && slot->done != NULL) {
+            slot->done(rslt, 0, slot->arg);
+        }
+    }
+    
+    if (lora_radio.op == LORA_OP_IDLE && lora_radio.rx_paused) {
+        lora_rx_resume();
     }
     
-    lora_debug_print("✗ LoRa transmission timeout\r\n");
-    return -1;
+    if (lora_radio.op == LORA_OP_TX) {
+        wake = lora_earlier(wake, lora_radio.tx_deadline);
+    }
+    for (uint8_t i = 0; i < LORA_TX_QUEUE_SLOTS; i++) {
+        if (lora_tx_queue.used & (1u << i)) {
+            wake = lora_earlier(wake, lora_tx_pool[i].expires);
+        }
+    }
+    if (wake != 0) {
+        sched_wake_at(lora_task_id, wake);
+    }
+    running = 0;
+}
+
+// Drop every queued packet, completing each with rslt
+static void lora_tx_flush(int8_t rslt) {
+    int8_t head;
+    
+    while ((head = lora_tx_queue_head()) >= 0) {
+        lora_tx_queue.used &= (uint8_t)~(1u << head);
+        if (lora_tx_pool[head].done != NULL) {
+            lora_tx_pool[head].done(rslt, 0, lora_tx_pool[head].arg);
+        }
+    }
 }
 
-// Process LoRa interrupts
-void lora_process_irq(void) {
+// Queue a packet for transmission and return at once. The payload is
+// copied into a free slot; packets go out by priority (LORA_TX_PRIO_*),
+// oldest first within one, and back to back while the queue holds more.
+// A packet still queued ttl_ms after this call (0: no limit) is dropped
+// with LORA_E_EXPIRED. done(arg) (may be NULL) is called from the LoRa task
+// when the packet is out or dropped. Returns 0 if done will be called,
+// LORA_E_FULL when every slot is taken, or -1.
+int8_t lora_queue_message(const uint8_t* data, uint8_t length, uint8_t priority, uint32_t ttl_ms,
+                          lora_tx_callback_t done, void* arg) {
+    lora_tx_slot_t* slot;
+    uint8_t free_slot;
+    
     if (!lora_module_detected) {
-        return; // No module to process interrupts for
+        LOG_ERROR(LORA, "Radio not available - no module detected");
+        return -1;
+    }
+    if (!lora_initialized) {
+        LOG_ERROR(LORA, "Radio not available - module not initialized");
+        return -1;
+    }
+    
+    if (data == NULL || length == 0 || length > LORA_PAYLOAD_LENGTH || priority > LORA_TX_PRIO_LOW) {
+        LOG_ERROR(LORA, "Invalid LoRa message parameters");
+        return -1;
+    }
+    
+    for (free_slot = 0; free_slot < LORA_TX_QUEUE_SLOTS; free_slot++) {
+        if (!(lora_tx_queue.used & (1u << free_slot))) {
+            break;
+        }
+    }
+    if (free_slot == LORA_TX_QUEUE_SLOTS) {
+        lora_tx_queue.full++;
+        return LORA_E_FULL;
+    }
+    if (lora_send_delay_ms(length) < 0) {
+        LOG_ERROR(LORA, "Packet of %u bytes can never fit the duty cycle", length);
+        lora_tx_queue.duty_rejected++;
+        return LORA_E_DUTY_CYCLE;
+    }
+    
+    slot = &lora_tx_pool[free_slot];
+    memcpy(slot->data, data, length);
+    slot->length = length;
+    slot->priority = priority;
+    slot->seq = lora_tx_queue.seq++;
+    slot->deferred = 0;
+    slot->expires = 0;
+    if (ttl_ms != 0) {
+        slot->expires = HAL_GetTick() + ttl_ms;
+        if (slot->expires == 0) {
+            slot->expires = 1;
+        }
+    }
+    slot->done = done;
+    slot->arg = arg;
+    lora_tx_queue.used |= (uint8_t)(1u << free_slot);
+    lora_tx_queue.queued++;
+    
+    lora_tx_next();
+    return 0;
+}
+
+// Queue a packet at normal priority without a time limit (see
+// lora_queue_message())
+int8_t lora_send_message(const uint8_t* data, uint8_t length, lora_tx_callback_t done, void* arg) {
+    return lora_queue_message(data, length, LORA_TX_PRIO_NORMAL, 0, done, arg);
+}
+
+// Start a reception and return at once: single with a timeout in ms, or
+// continuous for 0. callback(arg) gets every packet, CRC error and the
+// timeout from the LoRa task. A single reception is over when its callback
+// runs, so the callback may start the next one. Returns 0, LORA_E_BUSY or -1.
+int8_t lora_start_rx(uint32_t timeout_ms, lora_rx_callback_t callback, void* arg) {
+    sx126x_status_t status;
+    int8_t rslt;
+    
+    rslt = lora_ready();
+    if (rslt != 0) {
+        return rslt;
+    }
+    
+    lora_radio.op = (timeout_ms == 0) ? LORA_OP_RX_CONTINUOUS : LORA_OP_RX;
+    lora_radio.rx_event = callback;
+    lora_radio.rx_arg = arg;
+    lora_radio.rx_paused = 0;
+    status = lora_set_rx(timeout_ms);
+    if (status != SX126X_STATUS_OK) {
+        LOG_ERROR(LORA, "Failed to set receive mode");
+        lora_radio.op = LORA_OP_IDLE;
+        return -1;
+    }
+    return 0;
+}
+
+// A transmission or reception runs
+uint8_t lora_busy(void) {
+    return lora_radio.op != LORA_OP_IDLE;
+}
+
+// ADR receive window event: a packet heard already fed ADR on the way in,
+// a window that closes empty is a loss
+static void lora_adr_window_event(uint8_t event, const lora_packet_t* packet, void* arg) {
+    if (event == LORA_RX_TIMEOUT) {
+        (void)lora_adr_lost();
+    }
+}
+
+// End the transmission, start the next queued packet, then hand the result
+// to the callback: the radio is busy again before any callback work runs.
+// With ADR on, the last packet of a burst is followed by a receive window,
+// the only loss signal ADR backs off on.
+static void lora_tx_finish(int8_t rslt, uint32_t airtime_us, uint64_t edge_us) {
+    lora_tx_callback_t done = lora_radio.tx_done;
+    void* arg = lora_radio.tx_arg;
+    lora_adr_state_t adr;
+    
+    lora_radio.op = LORA_OP_IDLE;
+    if (rslt == 0) {
+        lora_tx_ok++;
+        lora_last_airtime_us = airtime_us;
+    } else {
+        LOG_ERROR(LORA, "Transmission timeout");
+        lora_tx_failed++;
+        (void)sx126x_set_standby(NULL, SX126X_STANDBY_CFG_RC);
+    }
+    
+    lora_tx_next();
+    if (edge_us != 0 && lora_radio.op == LORA_OP_TX) {
+        lora_tx_queue.last_gap_us = (uint32_t)(lora_radio.tx_start_us - edge_us);
+    }
+    lora_adr_get(&adr);
+    if (rslt == 0 && adr.enabled && lora_radio.op == LORA_OP_IDLE) {
+        (void)lora_start_rx(LORA_ADR_RX_WINDOW_MS, lora_adr_window_event, NULL);
+    }
+    
+    if (done != NULL) {
+        done(rslt, airtime_us, arg);
+    }
+}
+
+// Hand an RX event to the reception's callback; a single reception ends here
+static void lora_rx_dispatch(uint8_t event, const lora_packet_t* packet) {
+    if (lora_radio.op == LORA_OP_RX) {
+        lora_radio.op = LORA_OP_IDLE;
+    }
+    if (lora_radio.rx_event != NULL) {
+        lora_radio.rx_event(event, packet, lora_radio.rx_arg);
+    }
+}
+
+// Read a received packet (buffer status, payload, signal quality)
+static int8_t lora_read_packet(lora_packet_t* packet) {
+    sx126x_rx_buffer_status_t buffer;
+    sx126x_pkt_status_lora_t pkt_status;
+    
+    if (sx126x_get_rx_buffer_status(NULL, &buffer) != SX126X_STATUS_OK ||
+        sx126x_read_buffer(NULL, buffer.buffer_start_pointer, packet->data, buffer.pld_len_in_bytes) != SX126X_STATUS_OK ||
+        sx126x_get_lora_pkt_status(NULL, &pkt_status) != SX126X_STATUS_OK) {
+        return -1;
     }
+    packet->length = buffer.pld_len_in_bytes;
+    packet->rssi_dbm = pkt_status.rssi_pkt_in_dbm;
+    packet->snr_db = pkt_status.snr_pkt_in_db;
+    return 0;
+}
+
+// Read and clear the radio IRQ flags once and dispatch them. edge_us is the
+// time of the DIO1 edge, 0 when the watchdog reads the flags.
+static void lora_dispatch_irq(uint64_t edge_us) {
+    static lora_packet_t packet;
+    sx126x_irq_mask_t irq = 0;
     
-    sx126x_irq_mask_t irq_status;
-    sx126x_status_t status = sx126x_get_and_clear_irq_status(NULL, &irq_status);
+    if (sx126x_get_and_clear_irq_status(NULL, &irq) != SX126X_STATUS_OK || irq == 0) {
+        return;
+    }
+    
+    if (lora_radio.op == LORA_OP_TX) {
+        if (irq & SX126X_IRQ_TX_DONE) {
+            lora_tx_finish(0, edge_us ? (uint32_t)(edge_us - lora_radio.tx_start_us) : 0, edge_us);
+        } else if (irq & SX126X_IRQ_TIMEOUT) {
+            lora_tx_finish(LORA_E_TIMEOUT, 0, 0);
+        }
+        return;
+    }
+    if (lora_radio.op != LORA_OP_RX && lora_radio.op != LORA_OP_RX_CONTINUOUS) {
+        return;
+    }
     
-    if (status == SX126X_STATUS_OK && irq_status != 0) {
-        if (irq_status & SX126X_IRQ_TX_DONE) {
-            lora_debug_print("IRQ: Transmission completed\r\n");
+    if (irq & (SX126X_IRQ_CRC_ERROR | SX126X_IRQ_HEADER_ERROR)) {
+        lora_rx_crc_errors++;
+        lora_rx_dispatch(LORA_RX_CRC_ERROR, NULL);
+    } else if (irq & SX126X_IRQ_RX_DONE) {
+        if (lora_read_packet(&packet) != 0) {
+            LOG_ERROR(LORA, "Failed to read received packet");
+            return;
         }
-        if (irq_status & SX126X_IRQ_TIMEOUT) {
-            lora_debug_print("IRQ: Transmission timeout\r\n");
+        packet.edge_us = edge_us;
+        lora_rx_ok++;
+        // The link is reciprocal: what we hear tells the margin of what we send
+        (void)lora_adr_downlink(packet.snr_db, packet.rssi_dbm);
+        lora_rx_dispatch(LORA_RX_DONE, &packet);
+    } else if (irq & SX126X_IRQ_TIMEOUT) {
+        lora_rx_dispatch(LORA_RX_TIMEOUT, NULL);
+    }
+}
+
+// LoRa task: runs on a DIO1 edge, and on the timed release lora_tx_next()
+// arms (TX watchdog, duty-cycle hold or packet expiry)
+static void lora_task(uint32_t events)
+{
+    uint32_t primask;
+    uint64_t edge_us;
+    
+    if (!lora_module_detected) {
+        return;
+    }
+    
+    if (events & LORA_EVENT_DIO1) {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        edge_us = lora_radio.edge_us;
+        __set_PRIMASK(primask);
+        lora_dispatch_irq(edge_us);
+    } else if (lora_radio.op == LORA_OP_TX && (int32_t)(HAL_GetTick() - lora_radio.tx_deadline) >= 0) {
+        // Woken by the watchdog (not by an expiry): one read settles it either way
+        lora_irq_missed++;
+        lora_dispatch_irq(0);
+        if (lora_radio.op == LORA_OP_TX) {
+            lora_tx_finish(LORA_E_TIMEOUT, 0, 0);
         }
     }
+    
+    // A reception that ended releases the radio to the queue
+    lora_tx_next();
+}
+
+static const sched_task_def_t lora_task_def = {
+    .name = "lora", .run = lora_task, .period_ms = 0, .deadline_ms = 10, .priority = 2
+};
+
+// DIO1 interrupt: timestamp the edge and leave the SPI traffic to the task
+void lora_notify_irq(void)
+{
+    lora_radio.edge_us = timebase_now_us();
+    lora_irq_edges++;
+    sched_set_event(lora_task_id, LORA_EVENT_DIO1);
+}
+
+// Run the radio interrupt handling from the scheduler
+int8_t lora_register_task(void)
+{
+    lora_task_id = sched_add_task(&lora_task_def);
+    return (lora_task_id < 0) ? -1 : 0;
 }
 
 // Get LoRa status
@@ -365,6 +914,8 @@ int8_t lora_force_redetect(void) {
 
 // Print LoRa configuration
 void lora_print_config(void) {
+    char msg[64];
+    
     lora_debug_print("=== LoRa Configuration ===\r\n");
     
     if (!lora_module_detected) {
@@ -377,19 +928,39 @@ void lora_print_config(void) {
     lora_debug_print("Initialized: ");
     lora_debug_print(lora_initialized ? "Yes\r\n" : "No\r\n");
     lora_debug_print("Frequency: 868 MHz (EU band)\r\n");
-    lora_debug_print("Spreading Factor: SF7\r\n");
+    fmt_format(msg, sizeof(msg), "Spreading Factor: SF%u (low data rate optimization %s)\r\n",
+               lora_mod_params.sf, lora_mod_params.ldro ? "on" : "off");
+    lora_debug_print(msg);
     lora_debug_print("Bandwidth: 125 kHz\r\n");
     lora_debug_print("Coding Rate: 4/5\r\n");
-    lora_debug_print("TX Power: 14 dBm\r\n");
+    fmt_format(msg, sizeof(msg), "TX Power: %d dBm\r\n", lora_tx_power_dbm);
+    lora_debug_print(msg);
     lora_debug_print("Sync Word: 0x12\r\n");
-    lora_debug_print("Payload Length: 64 bytes\r\n");
+    // The length is set per packet; sensor readings go out as binary frames
+    fmt_format(msg, sizeof(msg), "Payload: sensor frame v%u, 11 bytes absolute, up to %u\r\n", LORA_PAYLOAD_VERSION,
+               LORA_PAYLOAD_MAX_LENGTH);
+    lora_debug_print(msg);
+    fmt_format(msg, sizeof(msg), "Payload Length: per packet, %u bytes max\r\n", LORA_PAYLOAD_LENGTH);
+    lora_debug_print(msg);
     lora_debug_print("Preamble Length: 8 symbols\r\n");
     lora_debug_print("CRC: Enabled\r\n");
     lora_debug_print("IQ Inversion: Disabled\r\n");
     lora_debug_print("========================\r\n");
 }
 
-// Test LoRa functionality
+// Result of a 'lora test' transmission
+static void lora_test_done(int8_t rslt, uint32_t airtime_us, void* arg) {
+    char msg[64];
+    
+    if (rslt == 0) {
+        fmt_format(msg, sizeof(msg), "✓ LoRa test transmission successful (%lu us on air)\r\n", airtime_us);
+        lora_debug_print(msg);
+    } else {
+        lora_debug_print("✗ LoRa test transmission failed\r\n");
+    }
+}
+
+// Test LoRa functionality; the result is printed when the packet is out
 int8_t lora_test_transmission(void) {
     if (!lora_module_detected) {
         lora_debug_print("✗ Test failed - no LoRa module detected\r\n");
@@ -403,25 +974,156 @@ int8_t lora_test_transmission(void) {
     
     // Test with a simple message
     const char* test_msg = "LoRa Test Message from STM32";
-    int8_t result = lora_send_message((uint8_t*)test_msg, strlen(test_msg));
+    int8_t result = lora_send_message((uint8_t*)test_msg, strlen(test_msg), lora_test_done, NULL);
     
-    if (result == 0) {
-        lora_debug_print("✓ LoRa test transmission successful\r\n");
-    } else {
+    if (result == LORA_E_FULL) {
+        lora_debug_print("✗ LoRa transmit queue full\r\n");
+    } else if (result != 0) {
         lora_debug_print("✗ LoRa test transmission failed\r\n");
     }
     
     return result;
 }
 
-// Scan for LoRa signals from other devices
-int8_t lora_scan_signals(uint32_t scan_time_ms) {
-    sx126x_status_t status;
-    sx126x_irq_mask_t irq_status;
-    uint8_t rx_buffer[256];
-    uint8_t payload_length;
-    sx126x_pkt_status_lora_t pkt_status;
+// Payload decoder references of the nodes heard last, for scan and monitor
+static lora_payload_ctx_t lora_rx_refs[LORA_RX_NODES];
+static uint8_t lora_rx_ref_next;
+
+// Decode a binary sensor frame and print the reading. Returns 0, or -1 if
+// the packet is not a frame this decoder can read.
+static int8_t lora_print_reading(const lora_packet_t* packet) {
+    lora_payload_ctx_t* ref = NULL;
+    lora_payload_t reading;
+    uint16_t node_id;
+    uint8_t sensor;
+    char msg[128];
+    fmt_t line;
+    int8_t rslt;
+    
+    if (lora_payload_peek(packet->data, packet->length, &node_id, &sensor) != 0) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < LORA_RX_NODES; i++) {
+        if (lora_rx_refs[i].keyframe_interval != 0 && lora_rx_refs[i].node_id == node_id &&
+            lora_rx_refs[i].sensor == sensor) {
+            ref = &lora_rx_refs[i];
+        }
+    }
+    if (ref == NULL) {
+        // keyframe_interval 1 only marks the entry as in use
+        ref = &lora_rx_refs[lora_rx_ref_next];
+        lora_rx_ref_next = (uint8_t)((lora_rx_ref_next + 1) % LORA_RX_NODES);
+        lora_payload_init(ref, node_id, sensor, 1);
+    }
+    
+    rslt = lora_payload_decode(ref, packet->data, packet->length, &reading);
+    if (rslt == LORA_PAYLOAD_E_REFERENCE) {
+        fmt_format(msg, sizeof(msg), "Reading: node %04X/%u delta frame, waiting for a keyframe\r\n",
+                   node_id, sensor);
+        lora_debug_print(msg);
+        return 0;
+    } else if (rslt != 0) {
+        return -1;
+    }
+    
+    fmt_init(&line, msg, sizeof(msg));
+    fmt_str(&line, "Reading: node ");
+    fmt_hex(&line, node_id, 4);
+    fmt_char(&line, '/');
+    fmt_u32(&line, sensor);
+    fmt_str(&line, " #");
+    fmt_u32(&line, reading.seq);
+    if (reading.fields & LORA_PAYLOAD_F_TEMPERATURE) {
+        fmt_str(&line, " T=");
+        fmt_fixed(&line, reading.temperature, 2);
+        fmt_str(&line, " C");
+    }
+    if (reading.fields & LORA_PAYLOAD_F_PRESSURE) {
+        fmt_str(&line, " P=");
+        fmt_u32(&line, reading.pressure);
+        fmt_str(&line, " Pa");
+    }
+    if (reading.fields & LORA_PAYLOAD_F_HUMIDITY) {
+        fmt_str(&line, " H=");
+        fmt_fixed(&line, reading.humidity, 2);
+        fmt_str(&line, " %RH");
+    }
+    if (reading.fields & LORA_PAYLOAD_F_GAS) {
+        fmt_str(&line, " G=");
+        fmt_u32(&line, reading.gas_resistance);
+        fmt_str(&line, " Ohm");
+    }
+    fmt_str(&line, "\r\n");
+    lora_debug_print(msg);
+    return 0;
+}
+
+// Print a received packet: signal quality, then the decoded reading or the
+// first 32 bytes
+static void lora_print_packet(const lora_packet_t* packet) {
     char scan_msg[128];
+    fmt_t line;
+    uint8_t shown = (packet->length > 32) ? 32 : packet->length;
+    
+    fmt_format(scan_msg, sizeof(scan_msg), 
+               "✓ Signal detected! RSSI: %d dBm, SNR: %d dB, Length: %d bytes\r\n",
+               packet->rssi_dbm, packet->snr_db, packet->length);
+    lora_debug_print(scan_msg);
+    
+    if (lora_print_reading(packet) == 0) {
+        return;
+    }
+    
+    // Print payload as hex (one line, one write)
+    fmt_init(&line, scan_msg, sizeof(scan_msg));
+    fmt_str(&line, "Payload (hex): ");
+    for (uint8_t i = 0; i < shown; i++) {
+        fmt_hex(&line, packet->data[i], 2);
+        fmt_char(&line, ' ');
+    }
+    fmt_str(&line, "\r\n");
+    lora_debug_print(scan_msg);
+    
+    // Try to print as string if it looks like text
+    if (packet->length > 0) {
+        fmt_init(&line, scan_msg, sizeof(scan_msg));
+        fmt_str(&line, "Payload (text): ");
+        for (uint8_t i = 0; i < shown; i++) {
+            if (packet->data[i] >= 32 && packet->data[i] <= 126) {
+                fmt_char(&line, (char)packet->data[i]);
+            } else {
+                fmt_char(&line, '.');
+            }
+        }
+        fmt_str(&line, "\r\n");
+        lora_debug_print(scan_msg);
+    }
+}
+
+// Tick the running scan ends
+static uint32_t lora_scan_end_tick;
+
+// Scan reception event: print the packet and listen for the rest of the scan
+static void lora_scan_event(uint8_t event, const lora_packet_t* packet, void* arg) {
+    uint32_t remaining = lora_scan_end_tick - HAL_GetTick();
+    
+    if (event == LORA_RX_DONE) {
+        lora_print_packet(packet);
+    } else if (event == LORA_RX_CRC_ERROR) {
+        lora_debug_print("✗ Packet with CRC error\r\n");
+    }
+    
+    if (event == LORA_RX_TIMEOUT || (int32_t)remaining <= 0 ||
+        lora_start_rx(remaining, lora_scan_event, NULL) != 0) {
+        lora_debug_print("Scan completed\r\n");
+    }
+}
+
+// Scan for LoRa signals from other devices; returns at once and prints
+// packets from the LoRa task until the scan time is over
+int8_t lora_scan_signals(uint32_t scan_time_ms) {
+    char scan_msg[64];
+    int8_t rslt;
     
     if (!lora_module_detected) {
         lora_debug_print("✗ Scan failed - no LoRa module detected\r\n");
@@ -434,75 +1136,33 @@ int8_t lora_scan_signals(uint32_t scan_time_ms) {
     }
     
     // Set to receive mode
-    status = sx126x_set_rx(NULL, scan_time_ms);
-    if (status != SX126X_STATUS_OK) {
+    lora_scan_end_tick = HAL_GetTick() + scan_time_ms;
+    rslt = lora_start_rx(scan_time_ms, lora_scan_event, NULL);
+    if (rslt == LORA_E_BUSY) {
+        lora_debug_print("✗ LoRa radio busy\r\n");
+        return -3;
+    } else if (rslt != 0) {
         lora_debug_print("✗ Failed to set receive mode\r\n");
         return -3;
     }
     
-    snprintf(scan_msg, sizeof(scan_msg), "Scanning for LoRa signals for %lu ms...\r\n", scan_time_ms);
+    fmt_format(scan_msg, sizeof(scan_msg), "Scanning for LoRa signals for %lu ms...\r\n", scan_time_ms);
     lora_debug_print(scan_msg);
-    
-    // Wait for reception or timeout
-    uint32_t start_time = HAL_GetTick();
-    uint32_t timeout = start_time + scan_time_ms;
-    
-    while (HAL_GetTick() < timeout) {
-        status = sx126x_get_irq_status(NULL, &irq_status);
-        if (status == SX126X_STATUS_OK) {
-            if (irq_status & SX126X_IRQ_RX_DONE) {
-                // Packet received
-                status = sx126x_get_lora_pkt_status(NULL, &pkt_status);
-                if (status == SX126X_STATUS_OK) {
-                    // Read payload
-                    status = sx126x_read_buffer(NULL, 0x00, rx_buffer, payload_length);
-                    if (status == SX126X_STATUS_OK) {
-                        snprintf(scan_msg, sizeof(scan_msg), 
-                                "✓ Signal detected! RSSI: %d dBm, SNR: %d dB, Length: %d bytes\r\n",
-                                pkt_status.rssi_pkt_in_dbm, pkt_status.snr_pkt_in_db, payload_length);
-                        lora_debug_print(scan_msg);
-                        
-                        // Print first 32 bytes of payload as hex
-                        lora_debug_print("Payload (hex): ");
-                        for (int i = 0; i < (payload_length > 32 ? 32 : payload_length); i++) {
-                            snprintf(scan_msg, sizeof(scan_msg), "%02X ", rx_buffer[i]);
-                            lora_debug_print(scan_msg);
-                        }
-                        lora_debug_print("\r\n");
-                        
-                        // Try to print as string if it looks like text
-                        if (payload_length > 0) {
-                            lora_debug_print("Payload (text): ");
-                            for (int i = 0; i < (payload_length > 32 ? 32 : payload_length); i++) {
-                                if (rx_buffer[i] >= 32 && rx_buffer[i] <= 126) {
-                                    snprintf(scan_msg, sizeof(scan_msg), "%c", rx_buffer[i]);
-                                    lora_debug_print(scan_msg);
-                                } else {
-                                    lora_debug_print(".");
-                                }
-                            }
-                            lora_debug_print("\r\n");
-                        }
-                    }
-                }
-                
-                // Clear IRQ and continue scanning
-                sx126x_clear_irq_status(NULL, SX126X_IRQ_ALL);
-                status = sx126x_set_rx(NULL, timeout - HAL_GetTick());
-            } else if (irq_status & SX126X_IRQ_TIMEOUT) {
-                break; // Scan timeout
-            }
-        }
-        HAL_Delay(10);
-    }
-    
-    lora_debug_print("Scan completed\r\n");
     return 0;
 }
 
+// Monitoring reception event
+static void lora_monitor_event(uint8_t event, const lora_packet_t* packet, void* arg) {
+    if (event == LORA_RX_DONE) {
+        lora_print_packet(packet);
+    } else if (event == LORA_RX_CRC_ERROR) {
+        lora_debug_print("✗ Packet with CRC error\r\n");
+    }
+}
+
 // Continuous LoRa monitoring mode
 int8_t lora_start_monitoring(void) {
-    sx126x_status_t status;
+    int8_t rslt;
     
     if (!lora_module_detected) {
         lora_debug_print("✗ Monitoring failed - no LoRa module detected\r\n");
@@ -514,20 +1174,22 @@ int8_t lora_start_monitoring(void) {
         return -2;
     }
     
-    lora_debug_print("Starting continuous LoRa monitoring...\r\n");
-    lora_debug_print("Press any key to stop monitoring\r\n");
-    
     // Set to continuous receive mode
-    status = sx126x_set_rx(NULL, 0); // 0 = continuous RX
-    if (status != SX126X_STATUS_OK) {
+    rslt = lora_start_rx(0, lora_monitor_event, NULL);
+    if (rslt == LORA_E_BUSY) {
+        lora_debug_print("✗ LoRa radio busy\r\n");
+        return -3;
+    } else if (rslt != 0) {
         lora_debug_print("✗ Failed to set continuous receive mode\r\n");
         return -3;
     }
     
+    lora_debug_print("Starting continuous LoRa monitoring...\r\n");
+    lora_debug_print("Use 'lora stop' to stop monitoring\r\n");
     return 0;
 }
 
-// Stop LoRa monitoring
+// Stop LoRa monitoring (or a running scan)
 int8_t lora_stop_monitoring(void) {
     sx126x_status_t status;
     
@@ -535,7 +1197,20 @@ int8_t lora_stop_monitoring(void) {
         return -1;
     }
     
+    if (lora_radio.op == LORA_OP_TX) {
+        // A monitor paused for the queue is simply not resumed
+        if (lora_radio.rx_paused) {
+            lora_radio.rx_paused = 0;
+            lora_debug_print("Monitoring stopped\r\n");
+            return 0;
+        }
+        lora_debug_print("✗ Transmission in progress\r\n");
+        return -1;
+    }
+    
     // Set to standby mode
+    lora_radio.op = LORA_OP_IDLE;
+    lora_radio.rx_paused = 0;
     status = sx126x_set_standby(NULL, SX126X_STANDBY_CFG_RC);
     if (status != SX126X_STATUS_OK) {
         lora_debug_print("✗ Failed to stop monitoring\r\n");
@@ -543,6 +1218,7 @@ int8_t lora_stop_monitoring(void) {
     }
     
     lora_debug_print("Monitoring stopped\r\n");
+    lora_tx_next();
     return 0;
 }
 
@@ -565,11 +1241,203 @@ int8_t lora_get_rssi(void) {
     status = sx126x_get_rssi_inst(NULL, &rssi);
     if (status == SX126X_STATUS_OK) {
         char rssi_msg[64];
-        snprintf(rssi_msg, sizeof(rssi_msg), "Current RSSI: %d dBm\r\n", rssi);
+        fmt_format(rssi_msg, sizeof(rssi_msg), "Current RSSI: %d dBm\r\n", rssi);
         lora_debug_print(rssi_msg);
         return 0;
     } else {
         lora_debug_print("✗ Failed to get RSSI\r\n");
         return -3;
     }
-} 
\ No newline at end of file
+}
+
+// Snapshot of the radio state and transmission counters
+void lora_get_stats(lora_stats_t* stats) {
+    stats->detected = lora_module_detected;
+    stats->initialized = lora_initialized;
+    stats->tx_ok = lora_tx_ok;
+    stats->tx_failed = lora_tx_failed;
+    stats->rx_ok = lora_rx_ok;
+    stats->rx_crc_errors = lora_rx_crc_errors;
+    stats->irq_edges = lora_irq_edges;
+    stats->irq_missed = lora_irq_missed;
+    stats->last_airtime_us = lora_last_airtime_us;
+    stats->tx_queued = lora_tx_queue.queued;
+    stats->tx_expired = lora_tx_queue.expired;
+    stats->tx_queue_full = lora_tx_queue.full;
+    stats->tx_last_gap_us = lora_tx_queue.last_gap_us;
+    stats->duty_deferred = lora_tx_queue.duty_deferred;
+    stats->duty_rejected = lora_tx_queue.duty_rejected;
+    stats->sf = lora_mod_params.sf;
+    stats->tx_power_dbm = lora_tx_power_dbm;
+}
+
+// Packets waiting in the transmit queue
+uint8_t lora_queue_depth(void) {
+    uint8_t depth = 0;
+    
+    for (uint8_t i = 0; i < LORA_TX_QUEUE_SLOTS; i++) {
+        depth += (lora_tx_queue.used >> i) & 1u;
+    }
+    return depth;
+}
+
+// Console commands
+
+// 'lora broadcast' transmission finished: print over the prompt, then show
+// it again
+static void lora_broadcast_sent(int8_t rslt, uint32_t airtime_us, void* arg) {
+    console_write(arg, "\r");
+    if (rslt == 0) {
+        console_printf(arg, "✓ LoRa broadcast successful (%lu us on air)\r\n", airtime_us);
+    } else {
+        console_write(arg, "✗ LoRa broadcast failed\r\n");
+    }
+    console_write(arg, "> ");
+}
+
+// Print and transmit a reading for 'lora broadcast'
+static void lora_broadcast_sample(console_ctx_t* ctx, int8_t rslt, const bme680_sample_t* sample) {
+    char text[128];
+    fmt_t line;
+    
+    if (rslt != BME68X_OK) {
+        console_write(ctx, "Error reading sensor data for LoRa broadcast\r\n");
+        return;
+    }
+    
+    fmt_init(&line, text, sizeof(text));
+    fmt_str(&line, "Broadcasting sensor data via LoRa...\r\nTemperature: ");
+    fmt_fixed(&line, sample->temperature, 2);
+    fmt_str(&line, "°C, Pressure: ");
+    fmt_u32(&line, sample->pressure);
+    fmt_str(&line, " Pa, Humidity: ");
+    fmt_fixed(&line, sample->humidity, 2);
+    fmt_str(&line, "%\r\n");
+    console_write(ctx, text);
+    
+    // Send via LoRa; the result follows when the packet is out
+    rslt = lora_send_sensor_data(sample, lora_broadcast_sent, ctx);
+    if (rslt == LORA_E_FULL) {
+        console_write(ctx, "✗ LoRa transmit queue full\r\n");
+    } else if (rslt != 0) {
+        console_write(ctx, "✗ LoRa broadcast failed\r\n");
+    }
+}
+
+// Sensor reading for 'lora broadcast' finished after the command returned:
+// print over the prompt, then show it again
+static void lora_broadcast_done(int8_t rslt, const bme680_sample_t* sample, void* arg) {
+    console_write(arg, "\r");
+    lora_broadcast_sample(arg, rslt, sample);
+    console_write(arg, "> ");
+}
+
+// Command handler for LoRa broadcast (a recent cached reading is sent at
+// once, otherwise when the sensor conversion ends)
+static void cmd_lora_broadcast(console_ctx_t* ctx, int argc, char* argv[]) {
+    bme680_sample_t sample;
+    int8_t rslt = bme680_get_sample(0, BME680_READ_MAX_AGE_MS, &sample, lora_broadcast_done, ctx);
+    
+    if (rslt == BME68X_OK) {
+        lora_broadcast_sample(ctx, rslt, &sample);
+    } else if (rslt != BME680_W_PENDING) {
+        console_write(ctx, "Error: BME680 sensor not available\r\n");
+    }
+}
+
+// Command handler for the transmit queue counters
+static void cmd_lora_queue(console_ctx_t* ctx, int argc, char* argv[]) {
+    lora_stats_t stats;
+    
+    lora_get_stats(&stats);
+    console_printf(ctx, "TX queue: %u/%u slots used, radio %s\r\n", lora_queue_depth(), LORA_TX_QUEUE_SLOTS,
+                   lora_busy() ? "busy" : "idle");
+    console_printf(ctx, "queued=%lu sent=%lu failed=%lu expired=%lu full=%lu\r\n", stats.tx_queued,
+                   stats.tx_ok, stats.tx_failed, stats.tx_expired, stats.tx_queue_full);
+    console_printf(ctx, "Last airtime %lu us, last inter-frame gap %lu us\r\n", stats.last_airtime_us,
+                   stats.tx_last_gap_us);
+}
+
+// Command handler for the duty-cycle budgets of the EU868 sub-bands
+static void cmd_lora_duty(console_ctx_t* ctx, int argc, char* argv[]) {
+    lora_duty_band_info_t band;
+    lora_stats_t stats;
+    int8_t current = lora_duty_band(LORA_FREQUENCY_HZ);
+    int32_t wait_ms;
+    
+    console_write(ctx, "Sub-band (MHz)      Limit  Used/hour (ms)  Left (ms)  TX\r\n");
+    for (uint8_t i = 0; i < LORA_DUTY_BANDS; i++) {
+        lora_duty_get(i, &band);
+        console_printf(ctx, "%c %3lu.%03lu-%3lu.%03lu  %3u.%u%%  %7lu/%-7lu  %9lu  %lu\r\n",
+                       (i == current) ? '*' : ' ', band.low_hz / 1000000, (band.low_hz / 1000) % 1000,
+                       band.high_hz / 1000000, (band.high_hz / 1000) % 1000, band.limit_permille / 10,
+                       band.limit_permille % 10, band.used_ms, band.budget_ms,
+                       band.budget_ms - band.used_ms, band.transmissions);
+    }
+    if (current < 0) {
+        console_write(ctx, "Radio frequency outside the sub-bands: transmissions are refused\r\n");
+    }
+    
+    lora_get_stats(&stats);
+    wait_ms = lora_send_delay_ms(LORA_PAYLOAD_MAX_LENGTH);
+    console_printf(ctx, "Next %u-byte packet: ", LORA_PAYLOAD_MAX_LENGTH);
+    if (wait_ms == 0) {
+        console_write(ctx, "now");
+    } else if (wait_ms > 0) {
+        console_printf(ctx, "in %ld ms", wait_ms);
+    } else {
+        console_write(ctx, "never");
+    }
+    console_printf(ctx, " (deferred=%lu rejected=%lu)\r\n", stats.duty_deferred, stats.duty_rejected);
+}
+
+// Command handler for adaptive data rate: show the state, or switch it
+static void cmd_lora_adr(console_ctx_t* ctx, int argc, char* argv[]) {
+    lora_adr_state_t adr;
+    
+    if (argc > 1) {
+        if (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "off") == 0) {
+            lora_adr_enable(strcmp(argv[1], "on") == 0);
+        } else {
+            console_write(ctx, "Usage: lora adr [on|off]\r\n");
+            return;
+        }
+    }
+    
+    lora_adr_get(&adr);
+    console_printf(ctx, "ADR %s: SF%u at %d dBm (max %d dBm), %lu changes\r\n", adr.enabled ? "on" : "off",
+                   adr.sf, adr.power_dbm, adr.max_power_dbm, adr.changes);
+    console_printf(ctx, "Last heard: SNR %d dB, RSSI %d dBm; history %u/%u, best SNR %d dB\r\n",
+                   adr.last_snr_db, adr.last_rssi_dbm, adr.samples, LORA_ADR_HISTORY, adr.best_snr_db);
+    console_printf(ctx, "Margin at last evaluation %d.%u dB; %u receive windows since anything was heard\r\n",
+                   adr.margin_db10 / 10, (unsigned)((adr.margin_db10 < 0 ? -adr.margin_db10 : adr.margin_db10) % 10),
+                   adr.windows_unheard);
+}
+
+static void cmd_lora_config(console_ctx_t* ctx, int argc, char* argv[]) { lora_print_config(); }
+static void cmd_lora_test(console_ctx_t* ctx, int argc, char* argv[]) { lora_test_transmission(); }
+static void cmd_lora_scan(console_ctx_t* ctx, int argc, char* argv[]) { lora_scan_signals(5000); } // 5 second scan
+static void cmd_lora_monitor(console_ctx_t* ctx, int argc, char* argv[]) { lora_start_monitoring(); }
+static void cmd_lora_stop(console_ctx_t* ctx, int argc, char* argv[]) { lora_stop_monitoring(); }
+static void cmd_lora_rssi(console_ctx_t* ctx, int argc, char* argv[]) { lora_get_rssi(); }
+static void cmd_lora_redetect(console_ctx_t* ctx, int argc, char* argv[]) { lora_force_redetect(); }
+
+static const console_command_t lora_commands[] = {
+    { "lora broadcast", "lb",  NULL, cmd_lora_broadcast, "Broadcast sensor data via LoRa" },
+    { "lora config",    "lc",  NULL, cmd_lora_config,    "Show LoRa configuration" },
+    { "lora queue",     "lq",  NULL, cmd_lora_queue,     "Show the LoRa transmit queue" },
+    { "lora duty",      "ldc", NULL, cmd_lora_duty,      "Show the EU868 duty-cycle budgets" },
+    { "lora adr",       "lad", "[on|off]", cmd_lora_adr, "Show or switch adaptive data rate" },
+    { "lora test",      "lt",  NULL, cmd_lora_test,      "Test LoRa transmission" },
+    { "lora scan",      "ls",  NULL, cmd_lora_scan,      "Scan for LoRa signals (5s)" },
+    { "lora monitor",   "lm",  NULL, cmd_lora_monitor,   "Start continuous monitoring" },
+    { "lora stop",      "lst", NULL, cmd_lora_stop,      "Stop LoRa monitoring" },
+    { "lora rssi",      "lr",  NULL, cmd_lora_rssi,      "Get current RSSI" },
+    { "lora redetect",  "lrd", NULL, cmd_lora_redetect,  "Force LoRa module re-detection" },
+};
+
+// Register the LoRa commands with the console
+int8_t lora_register_commands(void) {
+    return console_register_commands("LoRa Commands", lora_commands,
+                                     sizeof(lora_commands) / sizeof(lora_commands[0]));
+}
@@ -0,0 +1,239 @@
+#include "lora_payload.h"
+#include <string.h>
+
+// Byte cursor over a frame; a read or write past the end sets overflow
+typedef struct {
+    uint8_t* buf;
+    const uint8_t* in;
+    uint8_t size;
+    uint8_t pos;
+    uint8_t overflow;
+} lora_payload_cursor_t;
+
+static void put_u8(lora_payload_cursor_t* c, uint8_t value)
+{
+    if (c->pos >= c->size) {
+        c->overflow = 1;
+        return;
+    }
+    c->buf[c->pos++] = value;
+}
+
+// Little-endian, bytes low to high
+static void put_le(lora_payload_cursor_t* c, uint32_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++) {
+        put_u8(c, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+// Zigzag (0, -1, 1, -2 ... to 0, 1, 2, 3 ...) then LEB128, 7 bits per byte
+static void put_delta(lora_payload_cursor_t* c, int32_t delta)
+{
+    uint32_t value = ((uint32_t)delta << 1) ^ (0u - ((uint32_t)delta >> 31));
+
+    while (value >= 0x80) {
+        put_u8(c, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_u8(c, (uint8_t)value);
+}
+
+static uint8_t get_u8(lora_payload_cursor_t* c)
+{
+    if (c->pos >= c->size) {
+        c->overflow = 1;
+        return 0;
+    }
+    return c->in[c->pos++];
+}
+
+static uint32_t get_le(lora_payload_cursor_t* c, uint8_t bytes)
+{
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < bytes; i++) {
+        value |= (uint32_t)get_u8(c) << (8 * i);
+    }
+    return value;
+}
+
+static int32_t get_delta(lora_payload_cursor_t* c)
+{
+    uint32_t value = 0;
+    uint8_t byte;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        byte = get_u8(c);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return (int32_t)((value >> 1) ^ (0u - (value & 1)));
+        }
+    }
+    c->overflow = 1;    // More than 5 bytes
+    return 0;
+}
+
+// Field bits, in frame order, and their absolute sizes
+static const uint8_t field_bits[] = {
+    LORA_PAYLOAD_F_TEMPERATURE, LORA_PAYLOAD_F_PRESSURE, LORA_PAYLOAD_F_HUMIDITY, LORA_PAYLOAD_F_GAS
+};
+static const uint8_t field_bytes[] = { 2, 3, 2, 4 };
+
+// Field values as 32-bit words: deltas wrap modulo 2^32 on both sides
+static uint32_t field_get(const lora_payload_t* p, uint8_t bit)
+{
+    switch (bit) {
+    case LORA_PAYLOAD_F_TEMPERATURE: return (uint32_t)(int32_t)p->temperature;
+    case LORA_PAYLOAD_F_PRESSURE:    return p->pressure;
+    case LORA_PAYLOAD_F_HUMIDITY:    return p->humidity;
+    default:                         return p->gas_resistance;
+    }
+}
+
+static void field_set(lora_payload_t* p, uint8_t bit, uint32_t value)
+{
+    switch (bit) {
+    case LORA_PAYLOAD_F_TEMPERATURE: p->temperature = (int16_t)value; break;
+    case LORA_PAYLOAD_F_PRESSURE:    p->pressure = value & 0xFFFFFF; break;
+    case LORA_PAYLOAD_F_HUMIDITY:    p->humidity = (uint16_t)value; break;
+    default:                         p->gas_resistance = value; break;
+    }
+}
+
+// Start a node's encoder, or a receiver's reference for a node and sensor
+void lora_payload_init(lora_payload_ctx_t* ctx, uint16_t node_id, uint8_t sensor, uint8_t keyframe_interval)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->node_id = node_id;
+    ctx->sensor = sensor & 0x07;
+    ctx->keyframe_interval = keyframe_interval;
+    ctx->seq = 0xFF;    // The first frame is number 0
+}
+
+// Make the next frame absolute (the last one may not have arrived)
+void lora_payload_force_keyframe(lora_payload_ctx_t* ctx)
+{
+    ctx->valid = 0;
+}
+
+// Encode a reading (node, sensor and sequence number come from ctx) into
+// buf. Returns the frame length or LORA_PAYLOAD_E_*.
+int16_t lora_payload_encode(lora_payload_ctx_t* ctx, const lora_payload_t* reading, uint8_t* buf, uint8_t size)
+{
+    lora_payload_cursor_t c = { .buf = buf, .size = size };
+    uint8_t fields = reading->fields;
+    uint8_t flags = 0;
+    uint8_t seq = (uint8_t)(ctx->seq + 1);
+
+    if (fields == 0 || (fields & ~LORA_PAYLOAD_F_ALL)) {
+        return LORA_PAYLOAD_E_FORMAT;
+    }
+
+    if (ctx->valid && ctx->last.fields == fields && ctx->since_keyframe + 1 < ctx->keyframe_interval) {
+        flags |= LORA_PAYLOAD_FLAG_DELTA;
+    }
+    if (fields != LORA_PAYLOAD_F_DEFAULT) {
+        flags |= LORA_PAYLOAD_FLAG_BITMAP;
+    }
+
+    put_u8(&c, (uint8_t)((LORA_PAYLOAD_VERSION << 5) | (flags << 3) | ctx->sensor));
+    put_le(&c, ctx->node_id, 2);
+    put_u8(&c, seq);
+    if (flags & LORA_PAYLOAD_FLAG_BITMAP) {
+        put_u8(&c, fields);
+    }
+    for (uint8_t i = 0; i < sizeof(field_bits); i++) {
+        if (!(fields & field_bits[i])) {
+            continue;
+        }
+        if (flags & LORA_PAYLOAD_FLAG_DELTA) {
+            put_delta(&c, (int32_t)(field_get(reading, field_bits[i]) - field_get(&ctx->last, field_bits[i])));
+        } else {
+            put_le(&c, field_get(reading, field_bits[i]), field_bytes[i]);
+        }
+    }
+    if (c.overflow) {
+        return LORA_PAYLOAD_E_SIZE;
+    }
+
+    // The receiver decodes the same value, so the next delta starts from it
+    ctx->seq = seq;
+    ctx->since_keyframe = (flags & LORA_PAYLOAD_FLAG_DELTA) ? ctx->since_keyframe + 1 : 0;
+    ctx->last = *reading;
+    ctx->last.pressure &= 0xFFFFFF;
+    ctx->valid = 1;
+    return c.pos;
+}
+
+// Read the node ID and sensor of a frame, to pick the reference to decode
+// it with. Returns 0 or LORA_PAYLOAD_E_*.
+int8_t lora_payload_peek(const uint8_t* buf, uint8_t length, uint16_t* node_id, uint8_t* sensor)
+{
+    if (length < 4) {
+        return LORA_PAYLOAD_E_SIZE;
+    }
+    if ((buf[0] >> 5) != LORA_PAYLOAD_VERSION) {
+        return LORA_PAYLOAD_E_VERSION;
+    }
+    *node_id = (uint16_t)(buf[1] | (buf[2] << 8));
+    *sensor = buf[0] & 0x07;
+    return 0;
+}
+
+// Decode a frame of the node and sensor ref was initialized for. A frame
+// that decodes becomes the reference for the next delta. Returns 0 or
+// LORA_PAYLOAD_E_*; a delta frame that does not follow the reference gives
+// LORA_PAYLOAD_E_REFERENCE until the next absolute frame.
+int8_t lora_payload_decode(lora_payload_ctx_t* ref, const uint8_t* buf, uint8_t length, lora_payload_t* out)
+{
+    lora_payload_cursor_t c = { .in = buf, .size = length };
+    lora_payload_t p;
+    uint8_t header;
+    uint8_t flags;
+    int8_t rslt;
+
+    memset(&p, 0, sizeof(p));
+    rslt = lora_payload_peek(buf, length, &p.node_id, &p.sensor);
+    if (rslt != 0) {
+        return rslt;
+    }
+    if (p.node_id != ref->node_id || p.sensor != ref->sensor) {
+        return LORA_PAYLOAD_E_REFERENCE;
+    }
+
+    header = get_u8(&c);
+    flags = (header >> 3) & 0x03;
+    (void)get_le(&c, 2);
+    p.seq = get_u8(&c);
+    p.fields = (flags & LORA_PAYLOAD_FLAG_BITMAP) ? get_u8(&c) : LORA_PAYLOAD_F_DEFAULT;
+    if (c.overflow || p.fields == 0 || (p.fields & ~LORA_PAYLOAD_F_ALL)) {
+        return LORA_PAYLOAD_E_FORMAT;
+    }
+
+    if ((flags & LORA_PAYLOAD_FLAG_DELTA) &&
+        (!ref->valid || p.seq != (uint8_t)(ref->seq + 1) || p.fields != ref->last.fields)) {
+        ref->valid = 0;
+        return LORA_PAYLOAD_E_REFERENCE;
+    }
+
+    for (uint8_t i = 0; i < sizeof(field_bits); i++) {
+        if (!(p.fields & field_bits[i])) {
+            continue;
+        }
+        if (flags & LORA_PAYLOAD_FLAG_DELTA) {
+            field_set(&p, field_bits[i], field_get(&ref->last, field_bits[i]) + (uint32_t)get_delta(&c));
+        } else {
+            field_set(&p, field_bits[i], get_le(&c, field_bytes[i]));
+        }
+    }
+    if (c.overflow || c.pos != length) {
+        return LORA_PAYLOAD_E_FORMAT;
+    }
+
+    ref->seq = p.seq;
+    ref->last = p;
+    ref->valid = 1;
+    *out = p;
+    return 0;
+}
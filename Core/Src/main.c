@@ -21,9 +21,17 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "benchmark.h"
 #include "bme680_interface.h"
 #include "command_interface.h"
+#include "fmt.h"
+#include "i2c_scan.h"
+#include "log.h"
 #include "lora_interface.h"
+#include "power.h"
+#include "scheduler.h"
+#include "sensor_stream.h"
+#include "timebase.h"
 
 /* USER CODE END Includes */
 
@@ -47,8 +55,15 @@ I2C_HandleTypeDef hi2c1;
 
 SPI_HandleTypeDef hspi1;
 
+UART_HandleTypeDef hlpuart1;
 UART_HandleTypeDef huart2;
 UART_HandleTypeDef huart4;
+DMA_HandleTypeDef hdma_lpuart1_rx;
+DMA_HandleTypeDef hdma_lpuart1_tx;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+DMA_HandleTypeDef hdma_usart4_rx;
+DMA_HandleTypeDef hdma_usart4_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -57,17 +72,44 @@ UART_HandleTypeDef huart4;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_I2C1_Init(void);
 static void MX_USART4_UART_Init(void);
 static void MX_SPI1_Init(void);
+static void MX_LPUART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+// Heartbeat LED task
+static void led_task(uint32_t events)
+{
+  HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
+}
 
+static const sched_task_def_t led_task_def = {
+  .name = "led", .run = led_task, .period_ms = 500, .deadline_ms = 0, .priority = 3
+};
+
+// Console command groups, registered in this order ('help' lists them so)
+typedef struct {
+  const char* name;
+  int8_t (*register_commands)(void);
+} console_module_t;
+
+static const console_module_t console_modules[] = {
+  { "Sensor",      bme680_register_commands },
+  { "LoRa",        lora_register_commands },
+  { "Streaming",   sensor_stream_register_commands },
+  { "Diagnostics", benchmark_register_commands },
+  { "Logging",     log_register_commands },
+  { "Scheduler",   sched_register_commands },
+  { "Power",       power_register_commands },
+  { "I2C Bus",     i2c_scan_register_commands },
+};
 /* USER CODE END 0 */
 
 /**
@@ -99,128 +141,139 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_I2C1_Init();
   MX_USART4_UART_Init();
   MX_SPI1_Init();
+  MX_LPUART1_UART_Init();
   /* USER CODE BEGIN 2 */
-  // System initialization messages
-  command_interface_send_response("========================================\r\n");
-  command_interface_send_response("IoT Prototype System - STM32G071RB\r\n");
-  command_interface_send_response("========================================\r\n");
-  command_interface_send_response("System Clock: 16 MHz\r\n");
-  command_interface_send_response("I2C1 Configuration: PA9 (SCL), PA10 (SDA)\r\n");
-  command_interface_send_response("USART2: PA2 (TX), PA3 (RX) - 115200 baud\r\n");
-  command_interface_send_response("USART4: PA0 (TX), PA1 (RX) - 115200 baud\r\n");
-  command_interface_send_response("SPI1: PA5 (SCK), PA6 (MISO), PA7 (MOSI)\r\n");
-  command_interface_send_response("LoRa: PA4 (NSS), PC0 (RESET)\r\n");
-  command_interface_send_response("LED Status: PA5\r\n");
-  command_interface_send_response("========================================\r\n");
-  
-  command_interface_send_response_usart4("========================================\r\n");
-  command_interface_send_response_usart4("IoT Prototype System - STM32G071RB\r\n");
-  command_interface_send_response_usart4("========================================\r\n");
-  command_interface_send_response_usart4("System Clock: 16 MHz\r\n");
-  command_interface_send_response_usart4("I2C1 Configuration: PA9 (SCL), PA10 (SDA)\r\n");
-  command_interface_send_response_usart4("USART2: PA2 (TX), PA3 (RX) - 115200 baud\r\n");
-  command_interface_send_response_usart4("USART4: PA0 (TX), PA1 (RX) - 115200 baud\r\n");
-  command_interface_send_response_usart4("SPI1: PA5 (SCK), PA6 (MISO), PA7 (MOSI)\r\n");
-  command_interface_send_response_usart4("LoRa: PA4 (NSS), PC0 (RESET)\r\n");
-  command_interface_send_response_usart4("LED Status: PA5\r\n");
-  command_interface_send_response_usart4("========================================\r\n");
-  
-  // Scan I2C bus for devices
-  command_interface_send_response("\r\nScanning I2C bus for devices...\r\n");
-  command_interface_send_response_usart4("\r\nScanning I2C bus for devices...\r\n");
-  i2c_scan_bus();
+  // Microsecond timebase for driver delays and timeouts
+  timebase_init();
+
+  // Bring up every console port first so boot messages reach all of them
+  command_interface_init();
+  uint16_t console_failed = 0;
+  for (uint8_t i = 0; i < sizeof(console_modules) / sizeof(console_modules[0]); i++) {
+    if (console_modules[i].register_commands() != 0) {
+      console_failed |= 1u << i;
+    }
+  }
+
+  // STOP wakeup sources (reconfigures the console UARTs, so before any output)
+  power_init();
   
-  // Test I2C configuration
-  command_interface_send_response("\r\nTesting I2C configuration...\r\n");
-  command_interface_send_response_usart4("\r\nTesting I2C configuration...\r\n");
+  // System initialization messages
+  command_interface_broadcast("========================================\r\n");
+  command_interface_broadcast("IoT Prototype System - STM32G071RB\r\n");
+  command_interface_broadcast("========================================\r\n");
+  command_interface_broadcast("System Clock: 16 MHz\r\n");
+  command_interface_broadcast("I2C1 Configuration: PA9 (SCL), PA10 (SDA)\r\n");
+  command_interface_broadcast("USART2: PA2 (TX), PA3 (RX) - 115200 baud\r\n");
+  command_interface_broadcast("USART4: PA0 (TX), PA1 (RX) - 115200 baud\r\n");
+  command_interface_broadcast("LPUART1: PB11 (TX), PB10 (RX) - 115200 baud\r\n");
+  command_interface_broadcast("SPI1: PA5 (SCK), PA6 (MISO), PA7 (MOSI)\r\n");
+  command_interface_broadcast("LoRa: PA4 (NSS), PC0 (RESET)\r\n");
+  command_interface_broadcast("LED Status: PA5\r\n");
+  command_interface_broadcast("========================================\r\n");
+
+  // A group over the registry limits is missing from 'help' and the parser
+  for (uint8_t i = 0; i < sizeof(console_modules) / sizeof(console_modules[0]); i++) {
+    if (console_failed & (1u << i)) {
+      char line[64];
+      fmt_format(line, sizeof(line), "✗ %s commands failed to register\r\n", console_modules[i].name);
+      command_interface_broadcast(line);
+    }
+  }
   
-  // Test I2C bus with a simple ping
-  HAL_StatusTypeDef i2c_test = HAL_I2C_IsDeviceReady(&hi2c1, 0x76 << 1, 3, 1000);
-  if (i2c_test == HAL_OK) {
-    command_interface_send_response("✓ I2C bus test successful - device responds at 0x76\r\n");
-    command_interface_send_response_usart4("✓ I2C bus test successful - device responds at 0x76\r\n");
-  } else {
-    command_interface_send_response("✗ I2C bus test failed - no device at 0x76\r\n");
-    command_interface_send_response_usart4("✗ I2C bus test failed - no device at 0x76\r\n");
+  // Check the I2C lines (freeing a stuck SDA); the full address scan runs in
+  // the background once the scheduler starts, 'scan i2c' shows its result
+  command_interface_broadcast("\r\nChecking I2C bus...\r\n");
+  i2c_scan_result_t scan;
+  i2c_scan_start();
+  i2c_scan_get(&scan);
+  switch (scan.bus) {
+    case I2C_BUS_OK:
+      command_interface_broadcast("✓ I2C bus idle, scanning in the background\r\n");
+      break;
+    case I2C_BUS_RECOVERED:
+      command_interface_broadcast("✓ I2C bus recovered (SDA was held low), scanning in the background\r\n");
+      break;
+    case I2C_BUS_SDA_STUCK:
+      command_interface_broadcast("✗ I2C bus stuck - SDA held low\r\n");
+      break;
+    default:
+      command_interface_broadcast("✗ I2C bus stuck - SCL held low\r\n");
+      break;
   }
   
   // Check BME680 sensor presence
-  command_interface_send_response("\r\nChecking BME680 sensor presence...\r\n");
-  command_interface_send_response_usart4("\r\nChecking BME680 sensor presence...\r\n");
+  command_interface_broadcast("\r\nChecking BME680 sensor presence...\r\n");
   
   if (bme680_check_sensor_presence() == BME68X_OK) {
-    command_interface_send_response("✓ BME680 sensor detected on I2C bus (Address: 0x76)\r\n");
-    command_interface_send_response_usart4("✓ BME680 sensor detected on I2C bus (Address: 0x76)\r\n");
+    bme680_health_t health;
+    char line[80];
+
+    for (uint8_t i = 0; bme680_get_health(i, &health) == 0; i++) {
+      fmt_format(line, sizeof(line), "✓ BME680 sensor %u detected on I2C bus (Address: 0x%02X)\r\n",
+                 i, health.address);
+      command_interface_broadcast(line);
+    }
     
     // Initialize BME680 sensor
-    command_interface_send_response("Initializing BME680 sensor...\r\n");
-    command_interface_send_response_usart4("Initializing BME680 sensor...\r\n");
+    command_interface_broadcast("Initializing BME680 sensor...\r\n");
     
     if (bme680_init_sensor() == BME68X_OK) {
-      command_interface_send_response("✓ BME680 sensor initialized successfully\r\n");
-      command_interface_send_response("  - Temperature oversampling: 1x\r\n");
-      command_interface_send_response("  - Pressure oversampling: 1x\r\n");
-      command_interface_send_response("  - Humidity oversampling: 1x\r\n");
-      command_interface_send_response("  - Gas sensor: Disabled\r\n");
-      
-      command_interface_send_response_usart4("✓ BME680 sensor initialized successfully\r\n");
-      command_interface_send_response_usart4("  - Temperature oversampling: 1x\r\n");
-      command_interface_send_response_usart4("  - Pressure oversampling: 1x\r\n");
-      command_interface_send_response_usart4("  - Humidity oversampling: 1x\r\n");
-      command_interface_send_response_usart4("  - Gas sensor: Disabled\r\n");
+      command_interface_broadcast("✓ BME680 sensor initialized successfully\r\n");
+      fmt_format(line, sizeof(line), "  - Measurement profile: %s\r\n",
+                 bme680_meas_profile_info(bme680_get_meas_profile())->name);
+      command_interface_broadcast(line);
+      for (uint8_t i = 0; bme680_get_health(i, &health) == 0; i++) {
+        fmt_format(line, sizeof(line), "  - Sensor %u: calibration from %s, bring-up %lu us\r\n",
+                   i, health.calib_from_flash ? "flash" : "sensor", health.init_us);
+        command_interface_broadcast(line);
+      }
+      command_interface_broadcast("  - Gas sensor: Disabled\r\n");
     } else {
-      command_interface_send_response("✗ Error initializing BME680 sensor\r\n");
-      command_interface_send_response("  - Check sensor power supply (3.3V)\r\n");
-      command_interface_send_response("  - Verify I2C connections\r\n");
-      
-      command_interface_send_response_usart4("✗ Error initializing BME680 sensor\r\n");
-      command_interface_send_response_usart4("  - Check sensor power supply (3.3V)\r\n");
-      command_interface_send_response_usart4("  - Verify I2C connections\r\n");
+      command_interface_broadcast("✗ Error initializing BME680 sensor\r\n");
+      command_interface_broadcast("  - Check sensor power supply (3.3V)\r\n");
+      command_interface_broadcast("  - Verify I2C connections\r\n");
     }
   } else {
-    command_interface_send_response("✗ BME680 sensor not found on I2C bus\r\n");
-    command_interface_send_response("Troubleshooting steps:\r\n");
-    command_interface_send_response("  1. Check I2C connections:\r\n");
-    command_interface_send_response("     - PA9 (SCL) → BME680 SCL\r\n");
-    command_interface_send_response("     - PA10 (SDA) → BME680 SDA\r\n");
-    command_interface_send_response("  2. Verify power supply:\r\n");
-    command_interface_send_response("     - BME680 VCC → 3.3V\r\n");
-    command_interface_send_response("     - BME680 GND → GND\r\n");
-    command_interface_send_response("  3. Check pull-up resistors (4.7kΩ recommended)\r\n");
-    command_interface_send_response("  4. Verify I2C address (default: 0x76)\r\n");
-    command_interface_send_response("System will continue without sensor functionality\r\n");
-    
-    command_interface_send_response_usart4("✗ BME680 sensor not found on I2C bus\r\n");
-    command_interface_send_response_usart4("Troubleshooting steps:\r\n");
-    command_interface_send_response_usart4("  1. Check I2C connections:\r\n");
-    command_interface_send_response_usart4("     - PA9 (SCL) → BME680 SCL\r\n");
-    command_interface_send_response_usart4("     - PA10 (SDA) → BME680 SDA\r\n");
-    command_interface_send_response_usart4("  2. Verify power supply:\r\n");
-    command_interface_send_response_usart4("     - BME680 VCC → 3.3V\r\n");
-    command_interface_send_response_usart4("     - BME680 GND → GND\r\n");
-    command_interface_send_response_usart4("  3. Check pull-up resistors (4.7kΩ recommended)\r\n");
-    command_interface_send_response_usart4("  4. Verify I2C address (default: 0x76)\r\n");
-    command_interface_send_response_usart4("System will continue without sensor functionality\r\n");
+    command_interface_broadcast("✗ BME680 sensor not found on I2C bus\r\n");
+    command_interface_broadcast("Troubleshooting steps:\r\n");
+    command_interface_broadcast("  1. Check I2C connections:\r\n");
+    command_interface_broadcast("     - PA9 (SCL) → BME680 SCL\r\n");
+    command_interface_broadcast("     - PA10 (SDA) → BME680 SDA\r\n");
+    command_interface_broadcast("  2. Verify power supply:\r\n");
+    command_interface_broadcast("     - BME680 VCC → 3.3V\r\n");
+    command_interface_broadcast("     - BME680 GND → GND\r\n");
+    command_interface_broadcast("  3. Check pull-up resistors (4.7kΩ recommended)\r\n");
+    command_interface_broadcast("  4. Verify I2C address (default: 0x76)\r\n");
+    command_interface_broadcast("System will continue without sensor functionality\r\n");
   }
   
   // Initialize LoRa module
-  command_interface_send_response("\r\nInitializing LoRa module...\r\n");
-  command_interface_send_response_usart4("\r\nInitializing LoRa module...\r\n");
+  command_interface_broadcast("\r\nInitializing LoRa module...\r\n");
   
   if (lora_init() == 0) {
-    command_interface_send_response("✓ LoRa module initialized successfully\r\n");
-    command_interface_send_response_usart4("✓ LoRa module initialized successfully\r\n");
+    command_interface_broadcast("✓ LoRa module initialized successfully\r\n");
   } else {
-    command_interface_send_response("✗ LoRa module initialization failed\r\n");
-    command_interface_send_response_usart4("✗ LoRa module initialization failed\r\n");
+    command_interface_broadcast("✗ LoRa module initialization failed\r\n");
   }
   
-  // Initialize command interface
-  command_interface_init();
+  // Prompt for 'start' on every console
+  command_interface_announce();
+  
+  // Every activity runs as a scheduler task from here on
+  bme680_register_task();
+  sensor_stream_register_task();
+  command_interface_register_task();
+  lora_register_task();
+  sched_add_task(&led_task_def);
+  log_register_task();
+  i2c_scan_register_task();
+  sched_set_idle_hook(power_idle);
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -230,14 +283,8 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    // Process command interface
-    command_interface_process();
-    
-    // Toggle LED to show system is running
-    HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-    
-    // Small delay
-    HAL_Delay(10);
+    // Sensor, console, sampling, LoRa, LED and logging tasks (never returns)
+    sched_run();
   }
   /* USER CODE END 3 */
 }
@@ -370,6 +417,54 @@ static void MX_SPI1_Init(void)
 
 }
 
+/**
+  * @brief LPUART1 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_LPUART1_UART_Init(void)
+{
+
+  /* USER CODE BEGIN LPUART1_Init 0 */
+
+  /* USER CODE END LPUART1_Init 0 */
+
+  /* USER CODE BEGIN LPUART1_Init 1 */
+
+  /* USER CODE END LPUART1_Init 1 */
+  hlpuart1.Instance = LPUART1;
+  hlpuart1.Init.BaudRate = 115200;
+  hlpuart1.Init.WordLength = UART_WORDLENGTH_8B;
+  hlpuart1.Init.StopBits = UART_STOPBITS_1;
+  hlpuart1.Init.Parity = UART_PARITY_NONE;
+  hlpuart1.Init.Mode = UART_MODE_TX_RX;
+  hlpuart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  hlpuart1.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+  hlpuart1.Init.ClockPrescaler = UART_PRESCALER_DIV1;
+  hlpuart1.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+  hlpuart1.FifoMode = UART_FIFOMODE_DISABLE;
+  if (HAL_UART_Init(&hlpuart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_UARTEx_SetTxFifoThreshold(&hlpuart1, UART_TXFIFO_THRESHOLD_1_8) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_UARTEx_SetRxFifoThreshold(&hlpuart1, UART_RXFIFO_THRESHOLD_1_8) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_UARTEx_DisableFifoMode(&hlpuart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN LPUART1_Init 2 */
+
+  /* USER CODE END LPUART1_Init 2 */
+
+}
+
 /**
   * @brief USART2 Initialization Function
   * @param None
@@ -454,6 +549,28 @@ static void MX_USART4_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+  /* DMA1_Channel2_3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+  /* DMA1_Ch4_7_DMAMUX1_OVR_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Ch4_7_DMAMUX1_OVR_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Ch4_7_DMAMUX1_OVR_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -0,0 +1,327 @@
+#include "power.h"
+#include "scheduler.h"
+#include "command_interface.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "timebase.h"
+#include <string.h>
+
+// LPTIM_CFGR PRESC field value for a division by POWER_LPTIM_PRESCALER (16)
+#define POWER_LPTIM_PRESC      (4u << LPTIM_CFGR_PRESC_Pos)
+
+// LSI measurement window at start-up
+#define POWER_CALIBRATE_MS     100
+
+static uint8_t power_mode = POWER_MODE_STOP;
+static uint32_t power_lptim_hz = 32000 / POWER_LPTIM_PRESCALER;
+static power_stats_t power_stats;
+static uint32_t power_since;
+static uint32_t power_sleep_cycles;     // Sleep time below 1 ms, in core cycles
+static uint32_t power_stop_ticks;       // STOP time below 1 ms, in LPTIM ticks x 1000
+
+static const char* const power_mode_names[] = { "run", "sleep", "stop" };
+
+// LPTIM1 counter (reads are only valid when two in a row agree)
+static uint32_t power_lptim_count(void)
+{
+    uint32_t count;
+
+    do {
+        count = LPTIM1->CNT;
+    } while (count != LPTIM1->CNT);
+    return count;
+}
+
+// Start LPTIM1 counting from 0 up to ticks, once (SNGSTRT) or continuously
+static void power_lptim_start(uint32_t ticks, uint32_t start)
+{
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF | LPTIM_ICR_ARRMCF;
+    LPTIM1->ARR = ticks;
+    while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0) {
+    }
+    LPTIM1->CR = LPTIM_CR_ENABLE | start;
+}
+
+// Stop LPTIM1 (this also clears its counter)
+static void power_lptim_stop(void)
+{
+    LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+    LPTIM1->CR = 0;
+}
+
+// Measure the LPTIM1 rate against SysTick: the LSI is only accurate to a few
+// percent, which would otherwise skew the tick count after every STOP
+static void power_lptim_calibrate(void)
+{
+    uint32_t start_tick;
+    uint32_t start_count;
+    uint32_t count;
+
+    power_lptim_start(POWER_LPTIM_MAX_TICKS, LPTIM_CR_CNTSTRT);
+
+    // Align to a tick edge, then count LSI periods over the window
+    start_tick = HAL_GetTick();
+    while (HAL_GetTick() == start_tick) {
+    }
+    start_tick = HAL_GetTick();
+    start_count = power_lptim_count();
+    while (HAL_GetTick() - start_tick < POWER_CALIBRATE_MS) {
+    }
+    count = power_lptim_count();
+    power_lptim_stop();
+
+    count = (count - start_count) & POWER_LPTIM_MAX_TICKS;
+    if (count != 0) {
+        power_lptim_hz = count * (1000 / POWER_CALIBRATE_MS);
+    }
+}
+
+// Let a console UART wake the MCU from STOP on a start bit. The UART is
+// briefly disabled, so this runs before any output is queued.
+static void power_uart_wakeup_init(UART_HandleTypeDef* huart)
+{
+    UART_WakeUpTypeDef wakeup = { .WakeUpEvent = UART_WAKEUP_ON_STARTBIT };
+
+    if (!IS_UART_WAKEUP_FROMSTOP_INSTANCE(huart->Instance)) {
+        return;
+    }
+    if (HAL_UARTEx_StopModeWakeUpSourceConfig(huart, wakeup) != HAL_OK) {
+        return;
+    }
+    __HAL_UART_ENABLE_IT(huart, UART_IT_WUF);
+    HAL_UARTEx_EnableStopMode(huart);
+
+    // Reconfiguring the UART aborted the reception
+    uart_rx_start(huart);
+}
+
+// Set up LPTIM1 on the LSI and the STOP wakeup sources.
+// Call after command_interface_init() and before the first console output.
+void power_init(void)
+{
+    // LSI for LPTIM1, which keeps counting in STOP
+    __HAL_RCC_LSI_ENABLE();
+    while (__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) == 0) {
+    }
+    __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSI);
+    __HAL_RCC_LPTIM1_CLK_ENABLE();
+
+    // CFGR and IER are only writable while LPTIM1 is disabled
+    LPTIM1->CR = 0;
+    LPTIM1->CFGR = POWER_LPTIM_PRESC;
+    LPTIM1->IER = LPTIM_IER_ARRMIE;
+
+    // Wakeup lines: USART2 (26), LPUART1 (28), LPTIM1 (29)
+    EXTI->IMR1 |= EXTI_IMR1_IM26 | EXTI_IMR1_IM28 | EXTI_IMR1_IM29;
+    HAL_NVIC_SetPriority(TIM6_DAC_LPTIM1_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(TIM6_DAC_LPTIM1_IRQn);
+
+    power_lptim_calibrate();
+
+    for (uint8_t i = 0; i < command_interface_port_count(); i++) {
+        power_uart_wakeup_init(command_interface_get_port(i)->huart);
+    }
+
+#ifdef DEBUG
+    // Keep the debugger attached through STOP
+    __HAL_RCC_DBGMCU_CLK_ENABLE();
+    HAL_DBGMCU_EnableDBGStopMode();
+#endif
+
+    power_reset_stats();
+}
+
+// STOP1 stops the DMA and the UART idle-line timers, and USART4 cannot wake
+// the MCU, so only enter it when no console transfer is in flight and no
+// session is open on a port that could not wake us
+static uint8_t power_stop_allowed(void)
+{
+    for (uint8_t i = 0; i < command_interface_port_count(); i++) {
+        console_ctx_t* port = command_interface_get_port(i);
+
+        if (!uart_tx_is_idle(port->huart) || uart_rx_is_busy(port->huart)) {
+            return 0;
+        }
+        if ((port->started || port->mode == CONSOLE_MODE_BINARY) &&
+            !IS_UART_WAKEUP_FROMSTOP_INSTANCE(port->huart->Instance)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// STOP1 for up to ms, woken by LPTIM1, a console start bit or an EXTI line
+static void power_enter_stop(uint32_t ms)
+{
+    uint32_t max_ms = POWER_LPTIM_MAX_TICKS * 1000u / power_lptim_hz;
+    uint32_t ticks;
+    uint32_t elapsed;
+
+    if (ms > max_ms) {
+        ms = max_ms;
+    }
+    ticks = ms * power_lptim_hz / 1000u;
+    power_lptim_start(ticks, LPTIM_CR_SNGSTRT);
+
+    HAL_SuspendTick();
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    // SYSCLK is HSI16, which is also the clock STOP1 wakes up on, so there is
+    // no PLL or HSE to restore
+    elapsed = (LPTIM1->ISR & LPTIM_ISR_ARRM) ? ticks : power_lptim_count();
+    power_lptim_stop();
+
+    // SysTick and TIM2 were stopped: catch the HAL tick and the microsecond
+    // timebase up, keeping the remainder
+    power_stop_ticks += elapsed * 1000u;
+    elapsed = power_stop_ticks / power_lptim_hz;
+    power_stop_ticks %= power_lptim_hz;
+    uwTick += elapsed;
+    timebase_advance_us(elapsed * 1000u);
+    HAL_ResumeTick();
+
+    power_stats.stop_ms += elapsed;
+    power_stats.stop_count++;
+}
+
+// Sleep (WFI) until the next interrupt, SysTick at the latest
+static void power_enter_sleep(void)
+{
+    uint32_t cycles_per_ms = SystemCoreClock / 1000u;
+    uint32_t start;
+    uint32_t end;
+
+    // Interrupts are masked, so a SysTick wrap is seen by COUNTFLAG only
+    (void)SysTick->CTRL;
+    start = SysTick->VAL;
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    end = SysTick->VAL;
+
+    if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        power_sleep_cycles += start + (SysTick->LOAD + 1 - end);
+    } else {
+        power_sleep_cycles += start - end;
+    }
+    power_stats.sleep_ms += power_sleep_cycles / cycles_per_ms;
+    power_sleep_cycles %= cycles_per_ms;
+    power_stats.sleep_count++;
+}
+
+// Scheduler idle hook (interrupts masked): sleep as deep as the next timed
+// release and the peripherals allow
+void power_idle(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t next = now;
+    uint32_t gap = UINT32_MAX;
+
+    if (power_mode == POWER_MODE_RUN) {
+        return;
+    }
+
+    if (sched_next_release(&next)) {
+        gap = ((int32_t)(next - now) > 0) ? next - now : 0;
+    }
+
+    if (power_mode == POWER_MODE_STOP && gap >= POWER_STOP_MIN_MS && power_stop_allowed()) {
+        power_enter_stop(gap);
+    } else {
+        power_enter_sleep();
+    }
+}
+
+void power_set_mode(uint8_t mode)
+{
+    if (mode <= POWER_MODE_STOP) {
+        power_mode = mode;
+    }
+}
+
+uint8_t power_get_mode(void)
+{
+    return power_mode;
+}
+
+void power_get_stats(power_stats_t* stats)
+{
+    *stats = power_stats;
+    stats->elapsed_ms = HAL_GetTick() - power_since;
+    stats->lptim_hz = power_lptim_hz;
+}
+
+void power_reset_stats(void)
+{
+    memset(&power_stats, 0, sizeof(power_stats));
+    power_since = HAL_GetTick();
+}
+
+// LPTIM1 interrupt: the STOP timeout, only needed to wake the core
+void power_lptim_irq(void)
+{
+    LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+}
+
+// Console commands
+
+// Share of elapsed time in per mille (without overflowing after ~70 minutes)
+static uint32_t power_permille(uint32_t ms, uint32_t elapsed_ms)
+{
+    if (elapsed_ms == 0) {
+        return 0;
+    }
+    if (elapsed_ms >= 1000000u) {
+        return ms / (elapsed_ms / 1000u);
+    }
+    return ms * 1000u / elapsed_ms;
+}
+
+// Command handler for the idle mode and the time spent in each power state
+static void cmd_power(console_ctx_t* ctx, int argc, char* argv[])
+{
+    power_stats_t stats;
+    uint32_t run_ms;
+    uint32_t permille;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") == 0) {
+            power_reset_stats();
+            console_write(ctx, "Power counters reset\r\n");
+            return;
+        }
+        for (uint8_t mode = 0; mode <= POWER_MODE_STOP; mode++) {
+            if (strcmp(argv[1], power_mode_names[mode]) == 0) {
+                power_set_mode(mode);
+                console_printf(ctx, "Idle mode set to %s\r\n", power_mode_names[mode]);
+                return;
+            }
+        }
+        console_write(ctx, "Usage: power [run|sleep|stop|reset]\r\n");
+        return;
+    }
+
+    power_get_stats(&stats);
+    run_ms = stats.elapsed_ms - stats.sleep_ms - stats.stop_ms;
+
+    console_printf(ctx, "Idle mode: %s, over %lu ms:\r\n", power_mode_names[power_mode], stats.elapsed_ms);
+    permille = power_permille(run_ms, stats.elapsed_ms);
+    console_printf(ctx, "  Run   %9lu ms %3lu.%lu%%\r\n", run_ms, permille / 10, permille % 10);
+    permille = power_permille(stats.sleep_ms, stats.elapsed_ms);
+    console_printf(ctx, "  Sleep %9lu ms %3lu.%lu%%  (%lu entries)\r\n", stats.sleep_ms,
+                   permille / 10, permille % 10, stats.sleep_count);
+    permille = power_permille(stats.stop_ms, stats.elapsed_ms);
+    console_printf(ctx, "  Stop  %9lu ms %3lu.%lu%%  (%lu entries)\r\n", stats.stop_ms,
+                   permille / 10, permille % 10, stats.stop_count);
+    console_printf(ctx, "LPTIM1: %lu Hz (LSI/%u, measured at boot)\r\n", stats.lptim_hz, POWER_LPTIM_PRESCALER);
+}
+
+static const console_command_t power_commands[] = {
+    { "power", NULL, "[mode]", cmd_power, "Show time per power state, set idle mode (run/sleep/stop) or reset" },
+};
+
+// Register the power commands with the console
+int8_t power_register_commands(void)
+{
+    return console_register_commands("Power", power_commands,
+                                     sizeof(power_commands) / sizeof(power_commands[0]));
+}
@@ -0,0 +1,79 @@
+#include "ring_buffer.h"
+#include "stm32g0xx.h"
+#include <string.h>
+
+// Initialize ring over caller-provided storage (size must be a power of two)
+void ring_buffer_init(ring_buffer_t* rb, uint8_t* storage, uint16_t size)
+{
+    rb->buffer = storage;
+    rb->mask = size - 1;
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+// Drop all pending data (only safe while the producer is stopped)
+void ring_buffer_reset(ring_buffer_t* rb)
+{
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+// Number of bytes waiting to be read
+uint16_t ring_buffer_count(const ring_buffer_t* rb)
+{
+    return (uint16_t)(rb->head - rb->tail) & rb->mask;
+}
+
+// Number of bytes that can be written without overwriting unread data
+uint16_t ring_buffer_free(const ring_buffer_t* rb)
+{
+    return rb->mask - ring_buffer_count(rb);
+}
+
+// Producer side: copy up to len bytes in, returns the number actually stored
+uint16_t ring_buffer_write(ring_buffer_t* rb, const uint8_t* data, uint16_t len)
+{
+    uint16_t head = rb->head;
+    uint16_t space = ring_buffer_free(rb);
+
+    if (len > space) {
+        len = space;
+    }
+
+    // Copy in at most two pieces (up to the end of storage, then from the start)
+    uint16_t first = (uint16_t)(rb->mask + 1 - head);
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&rb->buffer[head], data, first);
+    memcpy(&rb->buffer[0], data + first, len - first);
+
+    // Data must be visible before the consumer sees the new head
+    __DMB();
+    rb->head = (uint16_t)(head + len) & rb->mask;
+
+    return len;
+}
+
+// Consumer side: copy up to len bytes out, returns the number actually read
+uint16_t ring_buffer_read(ring_buffer_t* rb, uint8_t* data, uint16_t len)
+{
+    uint16_t tail = rb->tail;
+    uint16_t available = ring_buffer_count(rb);
+
+    if (len > available) {
+        len = available;
+    }
+
+    uint16_t first = (uint16_t)(rb->mask + 1 - tail);
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, &rb->buffer[tail], first);
+    memcpy(data + first, &rb->buffer[0], len - first);
+
+    __DMB();
+    rb->tail = (uint16_t)(tail + len) & rb->mask;
+
+    return len;
+}
@@ -0,0 +1,289 @@
+#include "scheduler.h"
+#include "benchmark.h"
+#include "command_interface.h"
+#include <string.h>
+
+// Task control block
+typedef struct {
+    const sched_task_def_t* def;
+    volatile uint32_t events;
+    bench_mark_t event_mark;    // When the first pending event was posted
+    uint32_t due;               // Next timed release (valid while armed)
+    uint8_t armed;
+    sched_task_stats_t stats;
+} sched_task_t;
+
+static sched_task_t sched_tasks[SCHED_MAX_TASKS];
+static uint8_t sched_count = 0;
+static sched_idle_hook_t sched_idle_hook = NULL;
+static uint32_t sched_stats_since = 0;
+
+// Add a task, returns its id or -1 if the table is full.
+// Periodic tasks are first released one period from now.
+int8_t sched_add_task(const sched_task_def_t* def)
+{
+    sched_task_t* task;
+
+    if (sched_count >= SCHED_MAX_TASKS || def == NULL || def->run == NULL) {
+        return -1;
+    }
+
+    task = &sched_tasks[sched_count];
+    memset(task, 0, sizeof(*task));
+    task->def = def;
+    if (def->period_ms != 0) {
+        task->due = HAL_GetTick() + def->period_ms;
+        task->armed = 1;
+    }
+    return (int8_t)sched_count++;
+}
+
+// Post event flags to a task (ISR safe)
+void sched_set_event(int8_t id, uint32_t events)
+{
+    sched_task_t* task;
+    bench_mark_t mark;
+    uint32_t primask;
+
+    if (id < 0 || id >= sched_count) {
+        return;
+    }
+
+    task = &sched_tasks[id];
+    bench_start(&mark);
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (task->events == 0) {
+        task->event_mark = mark;
+    }
+    task->events |= events;
+    __set_PRIMASK(primask);
+}
+
+// Run a task as soon as possible
+void sched_wake(int8_t id)
+{
+    sched_set_event(id, SCHED_EVENT_WAKE);
+}
+
+// Release a task at the given tick (main loop only). For a periodic task this
+// also moves the phase of its following releases.
+void sched_wake_at(int8_t id, uint32_t tick)
+{
+    if (id < 0 || id >= sched_count) {
+        return;
+    }
+    sched_tasks[id].due = tick;
+    sched_tasks[id].armed = 1;
+}
+
+void sched_set_idle_hook(sched_idle_hook_t hook)
+{
+    sched_idle_hook = hook;
+}
+
+// Timed release has come
+static uint8_t sched_is_due(const sched_task_t* task, uint32_t now)
+{
+    return task->armed && (int32_t)(now - task->due) >= 0;
+}
+
+// Most urgent ready task, NULL if none
+static sched_task_t* sched_next_ready(uint32_t now)
+{
+    sched_task_t* best = NULL;
+
+    for (uint8_t i = 0; i < sched_count; i++) {
+        sched_task_t* task = &sched_tasks[i];
+
+        if ((task->events != 0 || sched_is_due(task, now)) &&
+            (best == NULL || task->def->priority < best->def->priority)) {
+            best = task;
+        }
+    }
+    return best;
+}
+
+// Set up the next timed release. Releases already in the past are skipped
+// and counted as overruns rather than run back to back.
+static void sched_advance(sched_task_t* task, uint32_t now)
+{
+    uint16_t period = task->def->period_ms;
+
+    if (period == 0) {
+        task->armed = 0;
+        return;
+    }
+
+    task->due += period;
+    while ((int32_t)(now - task->due) >= 0) {
+        task->due += period;
+        task->stats.overruns++;
+    }
+}
+
+// Run one task to completion and account for it
+static void sched_execute(sched_task_t* task, uint32_t now)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+    uint16_t deadline = task->def->deadline_ms ? task->def->deadline_ms : task->def->period_ms;
+    bench_mark_t release;
+    bench_mark_t start;
+    uint32_t events;
+    uint32_t latency_us;
+    uint32_t run_us;
+    uint32_t primask;
+
+    // Take the pending events
+    primask = __get_PRIMASK();
+    __disable_irq();
+    events = task->events;
+    task->events = 0;
+    release = task->event_mark;
+    __set_PRIMASK(primask);
+
+    // A timed release counts from the start of its tick
+    if (sched_is_due(task, now)) {
+        release.tick = task->due;
+        release.count = SysTick->LOAD;
+        sched_advance(task, now);
+    }
+
+    bench_start(&start);
+    latency_us = bench_cycles(&release) / cycles_per_us;
+    task->def->run(events);
+    run_us = bench_cycles(&start) / cycles_per_us;
+
+    task->stats.runs++;
+    task->stats.total_us += run_us;
+    if (run_us > task->stats.max_us) {
+        task->stats.max_us = run_us;
+    }
+    if (latency_us > task->stats.max_latency_us) {
+        task->stats.max_latency_us = latency_us;
+    }
+    if (deadline != 0 && latency_us + run_us > deadline * 1000u) {
+        task->stats.overruns++;
+    }
+}
+
+// Run the most urgent ready task, returns 0 if none was ready
+uint8_t sched_dispatch(void)
+{
+    uint32_t now = HAL_GetTick();
+    sched_task_t* task = sched_next_ready(now);
+
+    if (task == NULL) {
+        return 0;
+    }
+    sched_execute(task, now);
+    return 1;
+}
+
+// Earliest timed release, returns 0 if every task waits for an event
+uint8_t sched_next_release(uint32_t* tick)
+{
+    uint8_t found = 0;
+
+    for (uint8_t i = 0; i < sched_count; i++) {
+        const sched_task_t* task = &sched_tasks[i];
+
+        if (task->armed && (!found || (int32_t)(task->due - *tick) < 0)) {
+            *tick = task->due;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+// Scheduler main loop, never returns
+void sched_run(void)
+{
+    sched_stats_since = HAL_GetTick();
+
+    while (1) {
+        if (sched_dispatch()) {
+            continue;
+        }
+
+        // Re-check with interrupts masked so an event posted after the scan
+        // keeps the idle hook from sleeping through it
+        __disable_irq();
+        if (sched_next_ready(HAL_GetTick()) == NULL && sched_idle_hook != NULL) {
+            sched_idle_hook();
+        }
+        __enable_irq();
+    }
+}
+
+uint8_t sched_task_count(void)
+{
+    return sched_count;
+}
+
+// Definition of a task (NULL for a bad id), its counters copied to stats
+const sched_task_def_t* sched_get_task(int8_t id, sched_task_stats_t* stats)
+{
+    if (id < 0 || id >= sched_count) {
+        return NULL;
+    }
+    if (stats != NULL) {
+        *stats = sched_tasks[id].stats;
+    }
+    return sched_tasks[id].def;
+}
+
+void sched_reset_stats(void)
+{
+    for (uint8_t i = 0; i < sched_count; i++) {
+        memset(&sched_tasks[i].stats, 0, sizeof(sched_tasks[i].stats));
+    }
+    sched_stats_since = HAL_GetTick();
+}
+
+// Console commands
+
+// Command handler listing per-task runtime, latency and overruns
+static void cmd_tasks(console_ctx_t* ctx, int argc, char* argv[])
+{
+    uint32_t elapsed_ms = HAL_GetTick() - sched_stats_since;
+    uint32_t busy_us = 0;
+    uint32_t permille;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            console_write(ctx, "Usage: tasks [reset]\r\n");
+            return;
+        }
+        sched_reset_stats();
+        console_write(ctx, "Task counters reset\r\n");
+        return;
+    }
+
+    console_write(ctx, "Task      Prio Period     Runs   Avg us   Max us  Max lat us  Overruns\r\n");
+    for (uint8_t i = 0; i < sched_count; i++) {
+        const sched_task_def_t* def = sched_tasks[i].def;
+        const sched_task_stats_t* stats = &sched_tasks[i].stats;
+
+        console_printf(ctx, "%-9s %4u %6u %8lu %8lu %8lu %11lu %9lu\r\n", def->name, def->priority,
+                       def->period_ms, stats->runs, stats->runs ? stats->total_us / stats->runs : 0,
+                       stats->max_us, stats->max_latency_us, stats->overruns);
+        busy_us += stats->total_us;
+    }
+
+    // Busy time per elapsed ms is the load in per mille
+    permille = elapsed_ms ? busy_us / elapsed_ms : 0;
+    console_printf(ctx, "CPU busy %lu.%lu%% over %lu ms (period 0: event driven)\r\n",
+                   permille / 10, permille % 10, elapsed_ms);
+}
+
+static const console_command_t sched_commands[] = {
+    { "tasks", NULL, "[reset]", cmd_tasks, "Show task runtime, worst-case latency and overruns" },
+};
+
+// Register the scheduler commands with the console
+int8_t sched_register_commands(void)
+{
+    return console_register_commands("Scheduler", sched_commands,
+                                     sizeof(sched_commands) / sizeof(sched_commands[0]));
+}
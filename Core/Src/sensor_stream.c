@@ -0,0 +1,366 @@
+#include "sensor_stream.h"
+#include "bme680_interface.h"
+#include "host_protocol.h"
+#include "uart_tx.h"
+#include "fmt.h"
+#include "scheduler.h"
+#include <string.h>
+#include <stdlib.h>
+
+// Stream states
+#define STREAM_IDLE       0   // Stopped
+#define STREAM_WAIT       1   // Waiting for the next sample deadline
+#define STREAM_MEASURING  2   // Waiting for the sensor task to deliver the samples
+
+// Text sample line: "<ms>[,<sensor>],<T>,<P>,<H>,<gas>,<heater step>\r\n"
+#define STREAM_LINE_SIZE  64
+
+// One stream at a time, owned by the console that started it, taking a
+// sample of every available sensor per deadline. Deadlines are computed from
+// the start tick and the sample index, so they never drift however late a
+// single sample is taken. Each deadline's conversions start together one
+// conversion time (of the active measurement profile) before it, so they run
+// side by side and all samples are ready at the deadline.
+typedef struct {
+    console_ctx_t* ctx;
+    uint8_t state;
+    uint8_t pending;            // Conversions of this deadline not delivered yet
+    uint32_t start_tick;
+    uint32_t index;
+    uint32_t deadline;
+    sensor_stream_stats_t stats;
+} sensor_stream_t;
+
+static sensor_stream_t stream;
+static uint8_t stream_run;      // Bumped on every start, tells late callbacks of an old stream apart
+static int8_t stream_task_id = -1;
+
+// Deadline of sample n (start + n * 1000 / rate ms, without 32-bit overflow)
+static uint32_t sensor_stream_deadline(uint32_t n)
+{
+    uint8_t rate = stream.stats.rate_hz;
+    return stream.start_tick + (n / rate) * 1000u + ((n % rate) * 1000u) / rate;
+}
+
+// Conversion time of the active measurement profile, whole ms
+static uint16_t sensor_stream_lead_ms(void)
+{
+    return (uint16_t)((bme680_meas_duration_us(bme680_get_meas_profile()) + 999) / 1000);
+}
+
+// Sensors a deadline takes samples of
+static uint8_t sensor_stream_available(void)
+{
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < bme680_sensor_count(); i++) {
+        count += bme680_is_available(i);
+    }
+    return count;
+}
+
+// Start streaming to a console, replacing any running stream.
+// Returns -1 for a bad rate or field mask, -2 if no sensor is available,
+// -3 if a conversion of the measurement profile takes longer than a period.
+int8_t sensor_stream_start(console_ctx_t* ctx, uint8_t rate_hz, uint8_t fields)
+{
+    uint16_t lead_ms = sensor_stream_lead_ms();
+
+    if (rate_hz < SENSOR_STREAM_MIN_HZ || rate_hz > SENSOR_STREAM_MAX_HZ ||
+        fields == 0 || (fields & ~(HOST_FIELD_TPH | HOST_FIELD_GAS)) != 0) {
+        return -1;
+    }
+    if (lead_ms > 1000u / rate_hz) {
+        return -3;
+    }
+
+    sensor_stream_stop();
+    if (sensor_stream_available() == 0) {
+        return -2;
+    }
+
+    stream_run++;
+    stream.ctx = ctx;
+    stream.stats.rate_hz = rate_hz;
+    stream.stats.fields = fields;
+    stream.stats.lead_ms = lead_ms;
+    stream.start_tick = HAL_GetTick() + lead_ms;
+    stream.index = 0;
+    stream.deadline = stream.start_tick;
+    stream.state = STREAM_WAIT;
+    sched_wake(stream_task_id);
+    return 0;
+}
+
+void sensor_stream_stop(void)
+{
+    memset(&stream, 0, sizeof(stream));
+    stream.state = STREAM_IDLE;
+}
+
+uint8_t sensor_stream_get_rate(void)
+{
+    return stream.stats.rate_hz;
+}
+
+void sensor_stream_get_stats(sensor_stream_stats_t* stats)
+{
+    *stats = stream.stats;
+}
+
+// Free TX space on every text sink of the stream's console
+static uint8_t sensor_stream_text_room(uint16_t len)
+{
+    for (uint8_t i = 0; i < command_interface_port_count(); i++) {
+        console_ctx_t* port = command_interface_get_port(i);
+
+        if ((stream.ctx->sink_mask & (1u << i)) && port->mode == CONSOLE_MODE_TEXT &&
+            uart_tx_free(port->huart) < len) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Format a sample as one CSV line (fixed-point, no float formatting)
+static uint16_t sensor_stream_format(const bme680_sample_t* sample, char* text, uint16_t size)
+{
+    uint8_t fields = stream.stats.fields;
+    fmt_t line;
+
+    fmt_init(&line, text, size);
+    fmt_u32(&line, sample->timestamp);
+    if (bme680_sensor_count() > 1) {
+        fmt_char(&line, ',');
+        fmt_u32(&line, sample->sensor_id);
+    }
+    if (fields & HOST_FIELD_TEMPERATURE) {
+        fmt_char(&line, ',');
+        fmt_fixed(&line, sample->temperature, 2);
+    }
+    if (fields & HOST_FIELD_PRESSURE) {
+        fmt_char(&line, ',');
+        fmt_u32(&line, sample->pressure);
+    }
+    if (fields & HOST_FIELD_HUMIDITY) {
+        fmt_char(&line, ',');
+        fmt_fixed(&line, sample->humidity, 2);
+    }
+    if (fields & HOST_FIELD_GAS) {
+        fmt_char(&line, ',');
+        if (sample->status & BME68X_GASM_VALID_MSK) {
+            fmt_u32(&line, sample->gas_resistance);
+        } else {
+            fmt_char(&line, '-');
+        }
+        fmt_char(&line, ',');
+        fmt_u32(&line, sample->gas_step);
+    }
+    fmt_str(&line, "\r\n");
+    return line.len;
+}
+
+// Push one sample to the owning console in its current mode. Samples that do
+// not fit in the TX queue are dropped instead of stalling the main loop.
+static void sensor_stream_emit(const bme680_sample_t* sample)
+{
+    console_ctx_t* ctx = stream.ctx;
+
+    if (ctx->mode == CONSOLE_MODE_BINARY) {
+        host_tlv_t tlv;
+
+        host_tlv_init(&tlv);
+        host_tlv_put_sample(&tlv, sample, stream.stats.fields);
+        host_tlv_put_u32(&tlv, HOST_TAG_SAMPLES_DROPPED, stream.stats.samples_dropped);
+
+        if (uart_tx_free(ctx->huart) < HOST_PROTO_MAX_ENCODED + 1 ||
+            host_protocol_send(ctx, host_protocol_next_seq(ctx), HOST_PROTO_SAMPLE, &tlv) != 0) {
+            stream.stats.samples_dropped++;
+            return;
+        }
+    } else {
+        char line[STREAM_LINE_SIZE];
+        uint16_t len = sensor_stream_format(sample, line, sizeof(line));
+
+        if (!sensor_stream_text_room(len)) {
+            stream.stats.samples_dropped++;
+            return;
+        }
+        console_write(ctx, line);
+    }
+    stream.stats.samples_sent++;
+}
+
+// Move on to the next sample deadline
+static void sensor_stream_advance(void)
+{
+    stream.index++;
+    stream.deadline = sensor_stream_deadline(stream.index);
+    stream.state = STREAM_WAIT;
+}
+
+// Conversion of one sensor finished (called from the sensor task, arg is
+// the stream run that started it). The next deadline waits for the last one.
+static void sensor_stream_done(int8_t rslt, const bme680_sample_t* sample, void* arg)
+{
+    bme680_sample_t stamped;
+
+    // Stopped or restarted while the conversion ran
+    if (stream.state != STREAM_MEASURING || (uint8_t)(uintptr_t)arg != stream_run) {
+        return;
+    }
+
+    if (rslt == BME68X_OK) {
+        // Stamped with the deadline so samples are exactly 1/rate apart
+        stamped = *sample;
+        stamped.timestamp = stream.deadline;
+        sensor_stream_emit(&stamped);
+    } else {
+        stream.stats.read_errors++;
+    }
+    if (--stream.pending == 0) {
+        sensor_stream_advance();
+        sched_wake(stream_task_id);
+    }
+}
+
+// Run the stream: start a conversion on every available sensor one
+// conversion time before each deadline; the sensor task delivers the samples
+// when they are ready. Called from the main loop, never blocks.
+void sensor_stream_process(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint16_t lead_ms;
+
+    if (stream.state != STREAM_WAIT) {
+        return;
+    }
+
+    // Follows measurement profile changes while streaming
+    lead_ms = sensor_stream_lead_ms();
+    stream.stats.lead_ms = lead_ms;
+    if ((int32_t)(now - (stream.deadline - lead_ms)) < 0) {
+        return;
+    }
+
+    // Whole periods missed (long command, blocked output) are dropped
+    while ((int32_t)(now - (sensor_stream_deadline(stream.index + 1) - lead_ms)) >= 0) {
+        stream.index++;
+        stream.stats.samples_dropped++;
+    }
+    stream.deadline = sensor_stream_deadline(stream.index);
+
+    stream.pending = 0;
+    for (uint8_t i = 0; i < bme680_sensor_count(); i++) {
+        if (bme680_is_available(i) &&
+            bme680_start_measurement(i, sensor_stream_done, (void*)(uintptr_t)stream_run) == BME68X_OK) {
+            stream.pending++;
+        }
+    }
+    if (stream.pending == 0) {
+        stream.stats.read_errors++;
+        sensor_stream_advance();
+        return;
+    }
+    stream.state = STREAM_MEASURING;
+}
+
+// Stream task: woken exactly when the next conversion is due, and by the
+// measurement callback
+static void sensor_stream_task(uint32_t events)
+{
+    sensor_stream_process();
+
+    if (stream.state == STREAM_WAIT) {
+        sched_wake_at(stream_task_id, stream.deadline - stream.stats.lead_ms);
+    }
+}
+
+static const sched_task_def_t stream_task_def = {
+    .name = "stream", .run = sensor_stream_task, .period_ms = 0, .deadline_ms = 0, .priority = 0
+};
+
+// Run the stream from the scheduler
+int8_t sensor_stream_register_task(void)
+{
+    stream_task_id = sched_add_task(&stream_task_def);
+    return (stream_task_id < 0) ? -1 : 0;
+}
+
+// Console commands
+
+// Parse a field list such as "tph" or "t,p,h,g", returns 0 if invalid
+static uint8_t sensor_stream_parse_fields(const char* text)
+{
+    uint8_t fields = 0;
+
+    for (const char* p = text; *p != '\0'; p++) {
+        switch (*p) {
+            case 't': fields |= HOST_FIELD_TEMPERATURE; break;
+            case 'p': fields |= HOST_FIELD_PRESSURE; break;
+            case 'h': fields |= HOST_FIELD_HUMIDITY; break;
+            case 'g': fields |= HOST_FIELD_GAS; break;
+            case ',': break;
+            default: return 0;
+        }
+    }
+    return fields;
+}
+
+// Command handler for starting, stopping and inspecting the stream
+static void cmd_stream(console_ctx_t* ctx, int argc, char* argv[])
+{
+    uint8_t fields = HOST_FIELD_TPH;
+    int rate;
+    int8_t rslt;
+
+    if (argc < 2) {
+        if (stream.stats.rate_hz == 0) {
+            console_write(ctx, "Stream: off\r\n");
+        } else {
+            console_printf(ctx, "Stream: %u Hz on %s, conversion lead %u ms, sent=%lu dropped=%lu errors=%lu\r\n",
+                           stream.stats.rate_hz, stream.ctx->name, stream.stats.lead_ms,
+                           stream.stats.samples_sent, stream.stats.samples_dropped, stream.stats.read_errors);
+        }
+        return;
+    }
+
+    if (strcmp(argv[1], "off") == 0 || strcmp(argv[1], "0") == 0) {
+        sensor_stream_stop();
+        console_write(ctx, "Stream stopped\r\n");
+        return;
+    }
+
+    rate = atoi(argv[1]);
+    if (argc > 2) {
+        fields = sensor_stream_parse_fields(argv[2]);
+    }
+
+    rslt = (fields == 0) ? -1 : sensor_stream_start(ctx, (uint8_t)((rate > 0 && rate < 256) ? rate : 0), fields);
+    if (rslt == -1) {
+        console_printf(ctx, "Usage: stream <%u-%u Hz|off> [t,p,h,g]\r\n", SENSOR_STREAM_MIN_HZ, SENSOR_STREAM_MAX_HZ);
+    } else if (rslt == -2) {
+        console_write(ctx, "Error: no BME680 sensor available\r\n");
+    } else if (rslt == -3) {
+        console_printf(ctx, "Error: %lu us per conversion is too slow for %d Hz, pick a faster 'sensor profile'\r\n",
+                       bme680_meas_duration_us(bme680_get_meas_profile()), rate);
+    } else {
+        console_printf(ctx, "# Streaming at %u Hz ('stream off' to stop): ms%s%s%s%s%s\r\n", stream.stats.rate_hz,
+                       (bme680_sensor_count() > 1) ? ",Sensor" : "",
+                       (fields & HOST_FIELD_TEMPERATURE) ? ",T(C)" : "",
+                       (fields & HOST_FIELD_PRESSURE) ? ",P(Pa)" : "",
+                       (fields & HOST_FIELD_HUMIDITY) ? ",H(%RH)" : "",
+                       (fields & HOST_FIELD_GAS) ? ",Gas(Ohm),Step" : "");
+    }
+}
+
+static const console_command_t stream_commands[] = {
+    { "stream", NULL, "[hz|off] [fields]", cmd_stream, "Stream samples at 1-10 Hz (fields t,p,h,g)" },
+};
+
+// Register the streaming commands with the console
+int8_t sensor_stream_register_commands(void)
+{
+    return console_register_commands("Streaming", stream_commands,
+                                     sizeof(stream_commands) / sizeof(stream_commands[0]));
+}
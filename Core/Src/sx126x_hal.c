@@ -39,6 +39,7 @@
 
 #include "sx126x_hal.h"
 #include "stm32g0xx_hal.h"
+#include "timebase.h"
 #include <string.h>
 
 /*
@@ -143,9 +144,9 @@ sx126x_hal_status_t sx126x_hal_reset(const void* context)
     
     // Reset the radio
     HAL_GPIO_WritePin(hal_ctx.reset_port, hal_ctx.reset_pin, GPIO_PIN_RESET);
-    HAL_Delay(10);
+    timebase_delay_ms(10);
     HAL_GPIO_WritePin(hal_ctx.reset_port, hal_ctx.reset_pin, GPIO_PIN_SET);
-    HAL_Delay(100); // Wait for module to boot
+    timebase_delay_ms(100); // Wait for module to boot
     
     return SX126X_HAL_STATUS_OK;
 }
@@ -0,0 +1,109 @@
+#include "timebase.h"
+
+// Wraps of the 32-bit counter (the upper half of the count)
+static volatile uint32_t timebase_high;
+
+// Time TIM2 was stopped (STOP mode), added to every reading
+static uint64_t timebase_offset_us;
+
+// Start TIM2 free-running at 1 MHz
+void timebase_init(void)
+{
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+
+    // Timers run at twice PCLK when the APB prescaler divides
+    if (RCC->CFGR & RCC_CFGR_PPRE_2) {
+        clock *= 2;
+    }
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    TIM2->CR1 = 0;
+    TIM2->PSC = clock / 1000000u - 1;
+    TIM2->ARR = 0xFFFFFFFFu;
+    TIM2->CNT = 0;
+    TIM2->EGR = TIM_EGR_UG;         // Load the prescaler
+    TIM2->SR = 0;
+    TIM2->DIER = TIM_DIER_UIE;
+    TIM2->CR1 = TIM_CR1_CEN;
+
+    HAL_NVIC_SetPriority(TIM2_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+// Microseconds since timebase_init() (ISR safe)
+uint64_t timebase_now_us(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t high;
+    uint32_t count;
+
+    __disable_irq();
+    high = timebase_high;
+    count = TIM2->CNT;
+    // Wrapped while interrupts were masked: the overflow is not counted yet
+    if ((TIM2->SR & TIM_SR_UIF) && count < 0x80000000u) {
+        high++;
+    }
+    __set_PRIMASK(primask);
+
+    return (((uint64_t)high << 32) | count) + timebase_offset_us;
+}
+
+// Busy-wait for at least us microseconds
+void timebase_delay_us(uint32_t us)
+{
+    uint64_t deadline = timebase_deadline_us(us);
+
+    while (!timebase_expired(deadline)) {
+    }
+}
+
+// Busy-wait for at least ms milliseconds
+void timebase_delay_ms(uint32_t ms)
+{
+    uint64_t deadline = timebase_deadline_ms(ms);
+
+    while (!timebase_expired(deadline)) {
+    }
+}
+
+uint64_t timebase_deadline_us(uint32_t timeout_us)
+{
+    return timebase_now_us() + timeout_us;
+}
+
+uint64_t timebase_deadline_ms(uint32_t timeout_ms)
+{
+    return timebase_now_us() + (uint64_t)timeout_ms * 1000u;
+}
+
+uint8_t timebase_expired(uint64_t deadline)
+{
+    return timebase_now_us() >= deadline;
+}
+
+// Milliseconds left until a deadline (rounded up), 0 once it has passed
+uint32_t timebase_remaining_ms(uint64_t deadline)
+{
+    uint64_t now = timebase_now_us();
+
+    if (now >= deadline) {
+        return 0;
+    }
+    return (uint32_t)((deadline - now + 999u) / 1000u);
+}
+
+// Account for time TIM2 did not count (called after STOP)
+void timebase_advance_us(uint32_t us)
+{
+    timebase_offset_us += us;
+}
+
+// TIM2 update interrupt: one more wrap of the 32-bit counter
+void timebase_irq(void)
+{
+    if (TIM2->SR & TIM_SR_UIF) {
+        TIM2->SR = ~TIM_SR_UIF;
+        timebase_high++;
+    }
+}
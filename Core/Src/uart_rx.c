@@ -0,0 +1,150 @@
+#include "uart_rx.h"
+#include "ring_buffer.h"
+#include <string.h>
+
+// Per-port receive state.
+// DMA writes the circular buffer in hardware; the RX event callback (half, full
+// and idle-line events) moves every new byte into the ring, and the main loop
+// drains the ring in whole chunks.
+typedef struct {
+    UART_HandleTypeDef* huart;
+    uint8_t dma_buffer[UART_RX_DMA_SIZE];
+    uint16_t dma_pos;
+    ring_buffer_t ring;
+    uint8_t ring_storage[UART_RX_RING_SIZE];
+    uint32_t overflows;
+} uart_rx_port_t;
+
+static uart_rx_port_t rx_ports[UART_RX_MAX_PORTS];
+static uint8_t rx_port_count = 0;
+
+// Called from the RX event callback once new bytes are in a ring
+static void (*rx_notify)(void) = NULL;
+
+// Find the port bound to a UART handle
+static uart_rx_port_t* uart_rx_find_port(UART_HandleTypeDef* huart)
+{
+    for (uint8_t i = 0; i < rx_port_count; i++) {
+        if (rx_ports[i].huart == huart) {
+            return &rx_ports[i];
+        }
+    }
+    return NULL;
+}
+
+// (Re)arm circular DMA reception with idle-line detection
+static int8_t uart_rx_arm(uart_rx_port_t* port)
+{
+    port->dma_pos = 0;
+
+    if (HAL_UARTEx_ReceiveToIdle_DMA(port->huart, port->dma_buffer, UART_RX_DMA_SIZE) != HAL_OK) {
+        return -1;
+    }
+    return 0;
+}
+
+// Push a slice of the DMA buffer into the ring, counting what does not fit
+static void uart_rx_push(uart_rx_port_t* port, uint16_t offset, uint16_t len)
+{
+    uint16_t stored = ring_buffer_write(&port->ring, &port->dma_buffer[offset], len);
+    port->overflows += len - stored;
+}
+
+// Start background reception on a UART (safe to call again for the same port)
+int8_t uart_rx_start(UART_HandleTypeDef* huart)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+
+    if (port == NULL) {
+        if (rx_port_count >= UART_RX_MAX_PORTS) {
+            return -1;
+        }
+        port = &rx_ports[rx_port_count++];
+        memset(port, 0, sizeof(*port));
+        port->huart = huart;
+        ring_buffer_init(&port->ring, port->ring_storage, UART_RX_RING_SIZE);
+    } else {
+        HAL_UART_AbortReceive(huart);
+        ring_buffer_reset(&port->ring);
+    }
+
+    return uart_rx_arm(port);
+}
+
+// Bytes waiting on a port
+uint16_t uart_rx_available(UART_HandleTypeDef* huart)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+    return (port != NULL) ? ring_buffer_count(&port->ring) : 0;
+}
+
+// Drain up to len received bytes from a port
+uint16_t uart_rx_read(UART_HandleTypeDef* huart, uint8_t* data, uint16_t len)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+    return (port != NULL) ? ring_buffer_read(&port->ring, data, len) : 0;
+}
+
+// Bytes lost because the consumer fell behind
+uint32_t uart_rx_get_overflows(UART_HandleTypeDef* huart)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+    return (port != NULL) ? port->overflows : 0;
+}
+
+// A frame is being received or received bytes still wait for their RX event
+// (the DMA and the idle-line timer stop in STOP mode)
+uint8_t uart_rx_is_busy(UART_HandleTypeDef* huart)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+    uint16_t pos;
+
+    if (port == NULL) {
+        return 0;
+    }
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_BUSY) || __HAL_UART_GET_FLAG(huart, UART_FLAG_RXNE)) {
+        return 1;
+    }
+    pos = UART_RX_DMA_SIZE - (uint16_t)__HAL_DMA_GET_COUNTER(huart->hdmarx);
+    return (pos % UART_RX_DMA_SIZE) != port->dma_pos;
+}
+
+// Set the function called (in interrupt context) when bytes arrive on any port
+void uart_rx_set_notify(void (*notify)(void))
+{
+    rx_notify = notify;
+}
+
+// HAL reception event: pos is the DMA write index inside dma_buffer
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t pos)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+
+    if (port == NULL || pos == port->dma_pos) {
+        return;
+    }
+
+    if (pos > port->dma_pos) {
+        uart_rx_push(port, port->dma_pos, pos - port->dma_pos);
+    } else {
+        // DMA wrapped around since the last event
+        uart_rx_push(port, port->dma_pos, UART_RX_DMA_SIZE - port->dma_pos);
+        uart_rx_push(port, 0, pos);
+    }
+
+    port->dma_pos = (pos == UART_RX_DMA_SIZE) ? 0 : pos;
+
+    if (rx_notify != NULL) {
+        rx_notify();
+    }
+}
+
+// HAL error (overrun, framing, noise): reception is aborted, so re-arm it
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    uart_rx_port_t* port = uart_rx_find_port(huart);
+
+    if (port != NULL && huart->RxState == HAL_UART_STATE_READY) {
+        uart_rx_arm(port);
+    }
+}
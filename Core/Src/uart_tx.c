@@ -0,0 +1,257 @@
+#include "uart_tx.h"
+#include <string.h>
+
+#define UART_TX_MASK (UART_TX_RING_SIZE - 1)
+
+// Per-port transmit queue.
+// [tail, read) is owned by the DMA transfer in flight, [read, head) is queued.
+// Writers only move head (and read when dropping old data, with IRQs off);
+// the completion interrupt moves tail and starts the next chunk.
+typedef struct {
+    UART_HandleTypeDef* huart;
+    uart_tx_policy_t policy;
+    uint8_t buffer[UART_TX_RING_SIZE];
+    volatile uint16_t head;
+    volatile uint16_t read;
+    volatile uint16_t tail;
+    volatile uint8_t busy;
+    uart_tx_stats_t stats;
+} uart_tx_port_t;
+
+static uart_tx_port_t tx_ports[UART_TX_MAX_PORTS];
+static uint8_t tx_port_count = 0;
+
+// Find the port bound to a UART handle
+static uart_tx_port_t* uart_tx_find_port(UART_HandleTypeDef* huart)
+{
+    for (uint8_t i = 0; i < tx_port_count; i++) {
+        if (tx_ports[i].huart == huart) {
+            return &tx_ports[i];
+        }
+    }
+    return NULL;
+}
+
+static uint16_t uart_tx_used(const uart_tx_port_t* port)
+{
+    return (uint16_t)(port->head - port->tail) & UART_TX_MASK;
+}
+
+static uint16_t uart_tx_space(const uart_tx_port_t* port)
+{
+    return UART_TX_MASK - uart_tx_used(port);
+}
+
+// Blocking is only allowed from thread context with interrupts enabled,
+// otherwise the completion interrupt that frees space could never run
+static uint8_t uart_tx_can_block(void)
+{
+    return (__get_IPSR() == 0) && (__get_PRIMASK() == 0);
+}
+
+// Start the next DMA chunk if the channel is idle (IRQs off or from the ISR)
+static void uart_tx_kick(uart_tx_port_t* port)
+{
+    // Recover from a transfer aborted by a UART error (no completion callback)
+    if (port->busy && port->huart->gState == HAL_UART_STATE_READY) {
+        port->tail = port->read;
+        port->busy = 0;
+    }
+
+    if (port->busy) {
+        return;
+    }
+
+    uint16_t pending = (uint16_t)(port->head - port->read) & UART_TX_MASK;
+    if (pending == 0) {
+        return;
+    }
+
+    // One contiguous piece, capped so little data is pinned by the DMA
+    uint16_t chunk = UART_TX_RING_SIZE - port->read;
+    if (chunk > pending) {
+        chunk = pending;
+    }
+    if (chunk > UART_TX_DMA_CHUNK) {
+        chunk = UART_TX_DMA_CHUNK;
+    }
+
+    if (HAL_UART_Transmit_DMA(port->huart, &port->buffer[port->read], chunk) == HAL_OK) {
+        port->read = (uint16_t)(port->read + chunk) & UART_TX_MASK;
+        port->busy = 1;
+    }
+}
+
+// Discard up to len of the oldest queued (not yet in flight) bytes (IRQs off)
+static uint16_t uart_tx_drop_oldest(uart_tx_port_t* port, uint16_t len)
+{
+    uint16_t pending = (uint16_t)(port->head - port->read) & UART_TX_MASK;
+
+    if (len > pending) {
+        len = pending;
+    }
+    port->read = (uint16_t)(port->read + len) & UART_TX_MASK;
+    if (!port->busy) {
+        port->tail = port->read;
+    }
+    return len;
+}
+
+// Register a UART for queued DMA transmission
+int8_t uart_tx_init(UART_HandleTypeDef* huart, uart_tx_policy_t policy)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+
+    if (port == NULL) {
+        if (tx_port_count >= UART_TX_MAX_PORTS) {
+            return -1;
+        }
+        port = &tx_ports[tx_port_count];
+        memset(port, 0, sizeof(*port));
+        port->huart = huart;
+        tx_port_count++;
+    }
+
+    port->policy = policy;
+    return 0;
+}
+
+// Change the full-queue policy of a port
+void uart_tx_set_policy(UART_HandleTypeDef* huart, uart_tx_policy_t policy)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+
+    if (port != NULL) {
+        port->policy = policy;
+    }
+}
+
+// Queue data for transmission, returns the number of bytes accepted
+uint16_t uart_tx_write(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t len)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+    uint16_t accepted = 0;
+
+    // Ports without a queue keep the old blocking behaviour
+    if (port == NULL) {
+        HAL_UART_Transmit(huart, (uint8_t*)data, len, HAL_MAX_DELAY);
+        return len;
+    }
+
+    while (len > 0) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        uint16_t space = uart_tx_space(port);
+        if (space < len && port->policy == UART_TX_POLICY_DROP_OLDEST) {
+            port->stats.bytes_dropped += uart_tx_drop_oldest(port, len - space);
+            space = uart_tx_space(port);
+        }
+
+        uint16_t n = (len < space) ? len : space;
+        uint16_t head = port->head;
+        uint16_t first = UART_TX_RING_SIZE - head;
+        if (first > n) {
+            first = n;
+        }
+        memcpy(&port->buffer[head], data, first);
+        memcpy(&port->buffer[0], data + first, n - first);
+        port->head = (uint16_t)(head + n) & UART_TX_MASK;
+
+        uart_tx_kick(port);
+
+        uint16_t used = uart_tx_used(port);
+        if (used > port->stats.high_water) {
+            port->stats.high_water = used;
+        }
+        __set_PRIMASK(primask);
+
+        data += n;
+        len -= n;
+        accepted += n;
+
+        if (len == 0) {
+            break;
+        }
+
+        // Dropped bytes behind an in-flight chunk are only reclaimed when it
+        // completes, so drop-oldest may also have to wait (one chunk at most)
+        if (port->policy != UART_TX_POLICY_TRUNCATE && uart_tx_can_block()) {
+            // Wait for the DMA to hand back some space
+            while (uart_tx_space(port) == 0) {
+                __disable_irq();
+                uart_tx_kick(port);
+                __enable_irq();
+            }
+        } else {
+            port->stats.bytes_dropped += len;
+            break;
+        }
+    }
+
+    port->stats.bytes_queued += accepted;
+    return accepted;
+}
+
+// Queue a NUL-terminated string
+uint16_t uart_tx_write_string(UART_HandleTypeDef* huart, const char* str)
+{
+    return uart_tx_write(huart, (const uint8_t*)str, strlen(str));
+}
+
+// Bytes that can be queued right now without triggering the full policy
+uint16_t uart_tx_free(UART_HandleTypeDef* huart)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+    return (port != NULL) ? uart_tx_space(port) : UART_TX_MASK;
+}
+
+// Nothing queued and nothing in flight
+uint8_t uart_tx_is_idle(UART_HandleTypeDef* huart)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+    return (port == NULL) || (!port->busy && uart_tx_used(port) == 0);
+}
+
+// Snapshot of a port's counters
+int8_t uart_tx_get_stats(UART_HandleTypeDef* huart, uart_tx_stats_t* stats)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+
+    if (port == NULL) {
+        return -1;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = port->stats;
+    stats->pending = uart_tx_used(port);
+    stats->policy = port->policy;
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+// Human-readable policy name
+const char* uart_tx_policy_name(uart_tx_policy_t policy)
+{
+    switch (policy) {
+        case UART_TX_POLICY_BLOCK:       return "block";
+        case UART_TX_POLICY_DROP_OLDEST: return "drop-oldest";
+        case UART_TX_POLICY_TRUNCATE:    return "truncate";
+        default:                         return "unknown";
+    }
+}
+
+// HAL transmit complete: release the finished chunk and start the next one
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uart_tx_port_t* port = uart_tx_find_port(huart);
+
+    if (port == NULL) {
+        return;
+    }
+
+    port->tail = port->read;
+    port->busy = 0;
+    uart_tx_kick(port);
+}
@@ -5,12 +5,25 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../Core/Src/benchmark.c \
+../Core/Src/bme680_calib.c \
 ../Core/Src/bme680_interface.c \
 ../Core/Src/bme68x.c \
 ../Core/Src/command_interface.c \
+../Core/Src/fmt.c \
+../Core/Src/host_protocol.c \
+../Core/Src/i2c_scan.c \
+../Core/Src/log.c \
+../Core/Src/lora_adr.c \
+../Core/Src/lora_duty.c \
 ../Core/Src/lora_interface.c \
+../Core/Src/lora_payload.c \
 ../Core/Src/lr_fhss_mac.c \
 ../Core/Src/main.c \
+../Core/Src/power.c \
+../Core/Src/ring_buffer.c \
+../Core/Src/scheduler.c \
+../Core/Src/sensor_stream.c \
 ../Core/Src/stm32g0xx_hal_msp.c \
 ../Core/Src/stm32g0xx_it.c \
 ../Core/Src/sx126x.c \
@@ -20,16 +33,32 @@ C_SRCS += \
 ../Core/Src/syscalls.c \
 ../Core/Src/sysmem.c \
 ../Core/Src/system_stm32g0xx.c \
+../Core/Src/timebase.c \
+../Core/Src/uart_rx.c \
+../Core/Src/uart_tx.c \
 ../Core/Src/usart2_test.c \
 ../Core/Src/usart4_test.c 
 
 OBJS += \
+./Core/Src/benchmark.o \
+./Core/Src/bme680_calib.o \
 ./Core/Src/bme680_interface.o \
 ./Core/Src/bme68x.o \
 ./Core/Src/command_interface.o \
+./Core/Src/fmt.o \
+./Core/Src/host_protocol.o \
+./Core/Src/i2c_scan.o \
+./Core/Src/log.o \
+./Core/Src/lora_adr.o \
+./Core/Src/lora_duty.o \
 ./Core/Src/lora_interface.o \
+./Core/Src/lora_payload.o \
 ./Core/Src/lr_fhss_mac.o \
 ./Core/Src/main.o \
+./Core/Src/power.o \
+./Core/Src/ring_buffer.o \
+./Core/Src/scheduler.o \
+./Core/Src/sensor_stream.o \
 ./Core/Src/stm32g0xx_hal_msp.o \
 ./Core/Src/stm32g0xx_it.o \
 ./Core/Src/sx126x.o \
@@ -39,16 +68,32 @@ OBJS += \
 ./Core/Src/syscalls.o \
 ./Core/Src/sysmem.o \
 ./Core/Src/system_stm32g0xx.o \
+./Core/Src/timebase.o \
+./Core/Src/uart_rx.o \
+./Core/Src/uart_tx.o \
 ./Core/Src/usart2_test.o \
 ./Core/Src/usart4_test.o 
 
 C_DEPS += \
+./Core/Src/benchmark.d \
+./Core/Src/bme680_calib.d \
 ./Core/Src/bme680_interface.d \
 ./Core/Src/bme68x.d \
 ./Core/Src/command_interface.d \
+./Core/Src/fmt.d \
+./Core/Src/host_protocol.d \
+./Core/Src/i2c_scan.d \
+./Core/Src/log.d \
+./Core/Src/lora_adr.d \
+./Core/Src/lora_duty.d \
 ./Core/Src/lora_interface.d \
+./Core/Src/lora_payload.d \
 ./Core/Src/lr_fhss_mac.d \
 ./Core/Src/main.d \
+./Core/Src/power.d \
+./Core/Src/ring_buffer.d \
+./Core/Src/scheduler.d \
+./Core/Src/sensor_stream.d \
 ./Core/Src/stm32g0xx_hal_msp.d \
 ./Core/Src/stm32g0xx_it.d \
 ./Core/Src/sx126x.d \
@@ -58,18 +103,21 @@ C_DEPS += \
 ./Core/Src/syscalls.d \
 ./Core/Src/sysmem.d \
 ./Core/Src/system_stm32g0xx.d \
+./Core/Src/timebase.d \
+./Core/Src/uart_rx.d \
+./Core/Src/uart_tx.d \
 ./Core/Src/usart2_test.d \
 ./Core/Src/usart4_test.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
 Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
-	arm-none-eabi-gcc "$<" -mcpu=cortex-m0plus -std=gnu11 -g3 -DDEBUG -DUSE_HAL_DRIVER -DSTM32G071xx -c -I../Core/Inc -I../Drivers/STM32G0xx_HAL_Driver/Inc -I../Drivers/STM32G0xx_HAL_Driver/Inc/Legacy -I../Drivers/CMSIS/Device/ST/STM32G0xx/Include -I../Drivers/CMSIS/Include -O0 -ffunction-sections -fdata-sections -Wall -fstack-usage -fcyclomatic-complexity -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" --specs=nano.specs -mfloat-abi=soft -mthumb -o "$@"
+	arm-none-eabi-gcc "$<" -mcpu=cortex-m0plus -std=gnu11 -g3 -DDEBUG -DUSE_HAL_DRIVER -DSTM32G071xx -DBME68X_DO_NOT_USE_FPU -c -I../Core/Inc -I../Drivers/STM32G0xx_HAL_Driver/Inc -I../Drivers/STM32G0xx_HAL_Driver/Inc/Legacy -I../Drivers/CMSIS/Device/ST/STM32G0xx/Include -I../Drivers/CMSIS/Include -O0 -ffunction-sections -fdata-sections -Wall -fstack-usage -fcyclomatic-complexity -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" --specs=nano.specs -mfloat-abi=soft -mthumb -o "$@"
 
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/bme680_interface.cyclo ./Core/Src/bme680_interface.d ./Core/Src/bme680_interface.o ./Core/Src/bme680_interface.su ./Core/Src/bme68x.cyclo ./Core/Src/bme68x.d ./Core/Src/bme68x.o ./Core/Src/bme68x.su ./Core/Src/command_interface.cyclo ./Core/Src/command_interface.d ./Core/Src/command_interface.o ./Core/Src/command_interface.su ./Core/Src/lora_interface.cyclo ./Core/Src/lora_interface.d ./Core/Src/lora_interface.o ./Core/Src/lora_interface.su ./Core/Src/lr_fhss_mac.cyclo ./Core/Src/lr_fhss_mac.d ./Core/Src/lr_fhss_mac.o ./Core/Src/lr_fhss_mac.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/stm32g0xx_hal_msp.cyclo ./Core/Src/stm32g0xx_hal_msp.d ./Core/Src/stm32g0xx_hal_msp.o ./Core/Src/stm32g0xx_hal_msp.su ./Core/Src/stm32g0xx_it.cyclo ./Core/Src/stm32g0xx_it.d ./Core/Src/stm32g0xx_it.o ./Core/Src/stm32g0xx_it.su ./Core/Src/sx126x.cyclo ./Core/Src/sx126x.d ./Core/Src/sx126x.o ./Core/Src/sx126x.su ./Core/Src/sx126x_driver_version.cyclo ./Core/Src/sx126x_driver_version.d ./Core/Src/sx126x_driver_version.o ./Core/Src/sx126x_driver_version.su ./Core/Src/sx126x_hal.cyclo ./Core/Src/sx126x_hal.d ./Core/Src/sx126x_hal.o ./Core/Src/sx126x_hal.su ./Core/Src/sx126x_lr_fhss.cyclo ./Core/Src/sx126x_lr_fhss.d ./Core/Src/sx126x_lr_fhss.o ./Core/Src/sx126x_lr_fhss.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32g0xx.cyclo ./Core/Src/system_stm32g0xx.d ./Core/Src/system_stm32g0xx.o ./Core/Src/system_stm32g0xx.su ./Core/Src/usart2_test.cyclo ./Core/Src/usart2_test.d ./Core/Src/usart2_test.o ./Core/Src/usart2_test.su ./Core/Src/usart4_test.cyclo ./Core/Src/usart4_test.d ./Core/Src/usart4_test.o ./Core/Src/usart4_test.su
+	-$(RM) ./Core/Src/benchmark.cyclo ./Core/Src/benchmark.d ./Core/Src/benchmark.o ./Core/Src/benchmark.su ./Core/Src/bme680_calib.cyclo ./Core/Src/bme680_calib.d ./Core/Src/bme680_calib.o ./Core/Src/bme680_calib.su ./Core/Src/bme680_interface.cyclo ./Core/Src/bme680_interface.d ./Core/Src/bme680_interface.o ./Core/Src/bme680_interface.su ./Core/Src/bme68x.cyclo ./Core/Src/bme68x.d ./Core/Src/bme68x.o ./Core/Src/bme68x.su ./Core/Src/command_interface.cyclo ./Core/Src/command_interface.d ./Core/Src/command_interface.o ./Core/Src/command_interface.su ./Core/Src/fmt.cyclo ./Core/Src/fmt.d ./Core/Src/fmt.o ./Core/Src/fmt.su ./Core/Src/host_protocol.cyclo ./Core/Src/host_protocol.d ./Core/Src/host_protocol.o ./Core/Src/host_protocol.su ./Core/Src/i2c_scan.cyclo ./Core/Src/i2c_scan.d ./Core/Src/i2c_scan.o ./Core/Src/i2c_scan.su ./Core/Src/log.cyclo ./Core/Src/log.d ./Core/Src/log.o ./Core/Src/log.su ./Core/Src/lora_adr.cyclo ./Core/Src/lora_adr.d ./Core/Src/lora_adr.o ./Core/Src/lora_adr.su ./Core/Src/lora_duty.cyclo ./Core/Src/lora_duty.d ./Core/Src/lora_duty.o ./Core/Src/lora_duty.su ./Core/Src/lora_interface.cyclo ./Core/Src/lora_interface.d ./Core/Src/lora_interface.o ./Core/Src/lora_interface.su ./Core/Src/lora_payload.cyclo ./Core/Src/lora_payload.d ./Core/Src/lora_payload.o ./Core/Src/lora_payload.su ./Core/Src/lr_fhss_mac.cyclo ./Core/Src/lr_fhss_mac.d ./Core/Src/lr_fhss_mac.o ./Core/Src/lr_fhss_mac.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/power.cyclo ./Core/Src/power.d ./Core/Src/power.o ./Core/Src/power.su ./Core/Src/ring_buffer.cyclo ./Core/Src/ring_buffer.d ./Core/Src/ring_buffer.o ./Core/Src/ring_buffer.su ./Core/Src/scheduler.cyclo ./Core/Src/scheduler.d ./Core/Src/scheduler.o ./Core/Src/scheduler.su ./Core/Src/sensor_stream.cyclo ./Core/Src/sensor_stream.d ./Core/Src/sensor_stream.o ./Core/Src/sensor_stream.su ./Core/Src/stm32g0xx_hal_msp.cyclo ./Core/Src/stm32g0xx_hal_msp.d ./Core/Src/stm32g0xx_hal_msp.o ./Core/Src/stm32g0xx_hal_msp.su ./Core/Src/stm32g0xx_it.cyclo ./Core/Src/stm32g0xx_it.d ./Core/Src/stm32g0xx_it.o ./Core/Src/stm32g0xx_it.su ./Core/Src/sx126x.cyclo ./Core/Src/sx126x.d ./Core/Src/sx126x.o ./Core/Src/sx126x.su ./Core/Src/sx126x_driver_version.cyclo ./Core/Src/sx126x_driver_version.d ./Core/Src/sx126x_driver_version.o ./Core/Src/sx126x_driver_version.su ./Core/Src/sx126x_hal.cyclo ./Core/Src/sx126x_hal.d ./Core/Src/sx126x_hal.o ./Core/Src/sx126x_hal.su ./Core/Src/sx126x_lr_fhss.cyclo ./Core/Src/sx126x_lr_fhss.d ./Core/Src/sx126x_lr_fhss.o ./Core/Src/sx126x_lr_fhss.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32g0xx.cyclo ./Core/Src/system_stm32g0xx.d ./Core/Src/system_stm32g0xx.o ./Core/Src/system_stm32g0xx.su ./Core/Src/timebase.cyclo ./Core/Src/timebase.d ./Core/Src/timebase.o ./Core/Src/timebase.su ./Core/Src/uart_rx.cyclo ./Core/Src/uart_rx.d ./Core/Src/uart_rx.o ./Core/Src/uart_rx.su ./Core/Src/uart_tx.cyclo ./Core/Src/uart_tx.d ./Core/Src/uart_tx.o ./Core/Src/uart_tx.su ./Core/Src/usart2_test.cyclo ./Core/Src/usart2_test.d ./Core/Src/usart2_test.o ./Core/Src/usart2_test.su ./Core/Src/usart4_test.cyclo ./Core/Src/usart4_test.d ./Core/Src/usart4_test.o ./Core/Src/usart4_test.su
 
 .PHONY: clean-Core-2f-Src
 